@@ -0,0 +1,113 @@
+/*!
+ *  \file  pmos_jni.c
+ *  \brief JNI binding of pmos models (see src/com/streaminglabs/pmos/Pmos.java).
+ *
+ *  Batch methods access direct ByteBuffers in place (GetDirectBufferAddress), so each batch costs a
+ *  single JNI crossing and no copying. Viewing contexts are heap-allocated, and passed to Java as
+ *  opaque handles.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <jni.h>
+#include "pmos.h"
+#include "pmos_batch.h"
+
+/*!
+ * \brief Returns address of a direct buffer holding at least n elements of given size (NULL - exception is thrown).
+ */
+static void* buffer_address(JNIEnv* env, jobject buffer, jlong n, int size, const char* name)
+{
+	void* p;
+	jlong capacity;
+	char message[128];
+
+	if (buffer == NULL) {
+		(*env)->ThrowNew(env, (*env)->FindClass(env, "java/lang/NullPointerException"), name);
+		return NULL;
+	}
+	p = (*env)->GetDirectBufferAddress(env, buffer);
+	capacity = (*env)->GetDirectBufferCapacity(env, buffer);
+	if (p == NULL || capacity < n * size || ((uintptr_t)p % size)) {
+		sprintf(message, "%s must be an aligned direct buffer of at least %lld bytes", name, (long long)(n * size));
+		(*env)->ThrowNew(env, (*env)->FindClass(env, "java/lang/IllegalArgumentException"), message);
+		return NULL;
+	}
+	return p;
+}
+
+JNIEXPORT jlong JNICALL Java_com_streaminglabs_pmos_Pmos_contextCreate(JNIEnv* env, jclass cls, jint width, jint height, jint player_width, jint player_height, jint hdr, jint upsampling, jint device)
+{
+	struct viewing_context* ctx;
+	int err;
+
+	ctx = (struct viewing_context*)malloc(sizeof(struct viewing_context));
+	if (ctx == NULL) return -15;
+	err = viewing_context_init(ctx, width, height, player_width, player_height, hdr, upsampling, device, NULL);
+	if (err) {
+		free(ctx);
+		return err;
+	}
+	return (jlong)(intptr_t)ctx;
+}
+
+JNIEXPORT void JNICALL Java_com_streaminglabs_pmos_Pmos_contextFree(JNIEnv* env, jclass cls, jlong ctx)
+{
+	free((struct viewing_context*)(intptr_t)ctx);
+}
+
+JNIEXPORT jdouble JNICALL Java_com_streaminglabs_pmos_Pmos_contextScore(JNIEnv* env, jclass cls, jlong ctx, jint metric, jdouble value)
+{
+	return metric2mos((const struct viewing_context*)(intptr_t)ctx, metric, value);
+}
+
+JNIEXPORT jint JNICALL Java_com_streaminglabs_pmos_Pmos_contextScoreBatch(JNIEnv* env, jclass cls, jlong ctx, jint metric, jobject values, jobject mos, jint n)
+{
+	double *v, *m;
+
+	if (n < 0) return -12;
+	if ((v = (double*)buffer_address(env, values, n, sizeof(double), "values")) == NULL) return -6;
+	if ((m = (double*)buffer_address(env, mos, n, sizeof(double), "mos")) == NULL) return -6;
+	return metric2mos_batch((const struct viewing_context*)(intptr_t)ctx, metric, v, m, n);
+}
+
+JNIEXPORT jint JNICALL Java_com_streaminglabs_pmos_Pmos_scoreBatch(JNIEnv* env, jclass cls, jint metric, jobject values, jobject geometry, jobject mos, jint n, jint threads)
+{
+	struct score_batch batch;
+	struct batch_column* columns[7];
+	const int* g;
+	double* m;
+	int i;
+
+	if (n < 0) return -12;
+	if ((batch.values = (const double*)buffer_address(env, values, n, sizeof(double), "values")) == NULL) return -6;
+	if ((g = (const int*)buffer_address(env, geometry, (jlong)n * 7, sizeof(int), "geometry")) == NULL) return -6;
+	if ((m = (double*)buffer_address(env, mos, n, sizeof(double), "mos")) == NULL) return -6;
+
+	/* geometry is row-major, 7 fields per row: */
+	batch.n = n;
+	batch.values_stride = 1;
+	columns[0] = &batch.width;
+	columns[1] = &batch.height;
+	columns[2] = &batch.player_width;
+	columns[3] = &batch.player_height;
+	columns[4] = &batch.hdr;
+	columns[5] = &batch.upsampling;
+	columns[6] = &batch.device;
+	for (i = 0; i < 7; i++) {
+		columns[i]->data = g + i;
+		columns[i]->stride = 7;
+	}
+	batch.params = NULL;
+	batch.store = NULL;
+	return score_batch(metric, &batch, m, threads);
+}
+
+/* pmos_jni.c -- end of file */
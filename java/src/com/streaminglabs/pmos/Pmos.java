@@ -0,0 +1,69 @@
+/*
+ * Pmos.java -- JNI binding of pmos models.
+ *
+ * Copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+package com.streaminglabs.pmos;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+/**
+ * Native entry points of pmos library.
+ *
+ * Batch methods operate on direct ByteBuffers in native byte order (see {@link #allocate(int)}),
+ * which are accessed in place, without copying, and with a single JNI call per batch.
+ * Negative values in output buffers are error codes (see psnr2mos() in pmos.c).
+ */
+public final class Pmos {
+    static {
+        System.loadLibrary("pmos_jni");
+    }
+
+    /* metric types (enum metric_types): */
+    public static final int METRIC_PSNR = 0;
+    public static final int METRIC_SSIM = 1;
+    public static final int METRIC_VIF = 2;
+    public static final int METRIC_VMAF = 3;
+
+    /* device types (enum device_types): */
+    public static final int DEVICE_MOBILE = 0;
+    public static final int DEVICE_TABLET = 1;
+    public static final int DEVICE_PC = 2;
+    public static final int DEVICE_TV = 3;
+
+    /* upsampling methods (enum upsampling_methods): */
+    public static final int UPSAMPLING_BICUBIC = 0;
+    public static final int UPSAMPLING_NN = 1;
+    public static final int UPSAMPLING_SR = 2;
+
+    /** Number of int32 geometry fields per row in {@link #scoreBatch}: width, height, playerWidth, playerHeight, hdr, upsampling, device. */
+    public static final int GEOMETRY_FIELDS = 7;
+
+    private Pmos() {
+    }
+
+    /** Allocates direct buffer of given size [bytes] in native byte order. */
+    public static ByteBuffer allocate(int bytes) {
+        return ByteBuffer.allocateDirect(bytes).order(ByteOrder.nativeOrder());
+    }
+
+    /** Creates viewing context; returns handle (> 0), or negative error code. */
+    static native long contextCreate(int width, int height, int playerWidth, int playerHeight, int hdr, int upsampling, int device);
+
+    /** Releases viewing context. */
+    static native void contextFree(long ctx);
+
+    /** Maps metric score to MOS in a given viewing context. */
+    static native double contextScore(long ctx, int metric, double value);
+
+    /** Maps n float64 scores to MOS in a given viewing context; returns 0, or negative error code. */
+    static native int contextScoreBatch(long ctx, int metric, ByteBuffer values, ByteBuffer mos, int n);
+
+    /**
+     * Maps n float64 scores with per-row geometry (GEOMETRY_FIELDS int32 values per row) to MOS,
+     * using given number of threads (0 - all cores); returns 0, or error code of the first failed row.
+     */
+    public static native int scoreBatch(int metric, ByteBuffer values, ByteBuffer geometry, ByteBuffer mos, int n, int threads);
+}
@@ -0,0 +1,78 @@
+/*
+ * PmosBench.java -- micro-benchmark of JNI binding (JMH-style warmup and measurement iterations).
+ *
+ * Usage: java -Djava.library.path=. -cp classes com.streaminglabs.pmos.PmosBench [rows]
+ *
+ * Copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+package com.streaminglabs.pmos;
+
+import java.nio.ByteBuffer;
+
+public final class PmosBench {
+    private static final int WARMUP_ITERATIONS = 5;
+    private static final int MEASUREMENT_ITERATIONS = 10;
+
+    private interface Body {
+        double run();
+    }
+
+    /** Runs warmup and measurement iterations; prints mean time per row. */
+    private static void measure(String name, int rows, Body body) {
+        double sink = 0;
+        for (int i = 0; i < WARMUP_ITERATIONS; i++) {
+            sink += body.run();
+        }
+        long best = Long.MAX_VALUE, total = 0;
+        for (int i = 0; i < MEASUREMENT_ITERATIONS; i++) {
+            long t = System.nanoTime();
+            sink += body.run();
+            t = System.nanoTime() - t;
+            total += t;
+            best = Math.min(best, t);
+        }
+        System.out.printf("%-32s %8.2f ns/row (mean), %8.2f ns/row (best)   [%g]%n",
+            name, (double) total / MEASUREMENT_ITERATIONS / rows, (double) best / rows, sink);
+    }
+
+    public static void main(String[] args) {
+        final int n = args.length > 0 ? Integer.parseInt(args[0]) : 1_000_000;
+        final int[] widths = {640, 960, 1280, 1920, 3840}, heights = {360, 540, 720, 1080, 2160};
+        final double[] scores = new double[n];
+        final ByteBuffer values = Pmos.allocate(n * 8), mos = Pmos.allocate(n * 8);
+        final ByteBuffer geometry = Pmos.allocate(n * Pmos.GEOMETRY_FIELDS * 4);
+
+        for (int i = 0; i < n; i++) {
+            int k = i % widths.length;
+            scores[i] = 28.0 + (i % 1500) / 100.0;
+            values.putDouble(i * 8, scores[i]);
+            int[] row = {widths[k], heights[k], 3840, 2160, 0, Pmos.UPSAMPLING_BICUBIC, Pmos.DEVICE_TV};
+            for (int j = 0; j < row.length; j++) {
+                geometry.putInt((i * Pmos.GEOMETRY_FIELDS + j) * 4, row[j]);
+            }
+        }
+
+        try (ViewingContext ctx = new ViewingContext(1920, 1080, 3840, 2160, 0, Pmos.UPSAMPLING_BICUBIC, Pmos.DEVICE_TV)) {
+            measure("context, per element", n, () -> {
+                double s = 0;
+                for (int i = 0; i < n; i++) {
+                    s += ctx.score(Pmos.METRIC_PSNR, scores[i]);
+                }
+                return s;
+            });
+            measure("context, batch", n, () -> {
+                ctx.score(Pmos.METRIC_PSNR, values, mos, n);
+                return mos.getDouble(0);
+            });
+        }
+        measure("per-row geometry, 1 thread", n, () -> {
+            Pmos.scoreBatch(Pmos.METRIC_PSNR, values, geometry, mos, n, 1);
+            return mos.getDouble(0);
+        });
+        measure("per-row geometry, all cores", n, () -> {
+            Pmos.scoreBatch(Pmos.METRIC_PSNR, values, geometry, mos, n, 0);
+            return mos.getDouble(0);
+        });
+    }
+}
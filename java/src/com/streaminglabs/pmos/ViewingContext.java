@@ -0,0 +1,70 @@
+/*
+ * ViewingContext.java -- cached viewing context (long-lived native handle).
+ *
+ * Copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+package com.streaminglabs.pmos;
+
+import java.nio.ByteBuffer;
+import java.util.concurrent.locks.ReentrantReadWriteLock;
+
+/**
+ * Validated viewing setup with cached WR score (see viewing_context_init() in pmos.c).
+ * Contexts are immutable and may be shared by threads; they must be closed to release native memory.
+ * Scoring holds a read lock on the native handle (so threads score concurrently), and close() holds
+ * the write lock, so the handle is never freed while in use; scoring after close() throws.
+ */
+public final class ViewingContext implements AutoCloseable {
+    private final ReentrantReadWriteLock lock = new ReentrantReadWriteLock();
+    private long handle;    /* guarded by lock */
+
+    public ViewingContext(int width, int height, int playerWidth, int playerHeight, int hdr, int upsampling, int device) {
+        long h = Pmos.contextCreate(width, height, playerWidth, playerHeight, hdr, upsampling, device);
+        if (h <= 0) {
+            throw new IllegalArgumentException("invalid viewing setup (error " + h + ")");
+        }
+        handle = h;
+    }
+
+    /** Maps metric score to MOS (negative - error code). */
+    public double score(int metric, double value) {
+        lock.readLock().lock();
+        try {
+            return Pmos.contextScore(check(), metric, value);
+        } finally {
+            lock.readLock().unlock();
+        }
+    }
+
+    /** Maps n float64 scores to MOS (direct buffers, see Pmos.allocate()); returns 0, or negative error code. */
+    public int score(int metric, ByteBuffer values, ByteBuffer mos, int n) {
+        lock.readLock().lock();
+        try {
+            return Pmos.contextScoreBatch(check(), metric, values, mos, n);
+        } finally {
+            lock.readLock().unlock();
+        }
+    }
+
+    @Override
+    public void close() {
+        lock.writeLock().lock();
+        try {
+            if (handle != 0) {
+                Pmos.contextFree(handle);
+                handle = 0;
+            }
+        } finally {
+            lock.writeLock().unlock();
+        }
+    }
+
+    /* called with the lock held: */
+    private long check() {
+        if (handle == 0) {
+            throw new IllegalStateException("viewing context is closed");
+        }
+        return handle;
+    }
+}
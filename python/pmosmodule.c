@@ -0,0 +1,345 @@
+/*!
+ *  \file  pmosmodule.c
+ *  \brief Python extension module exposing vectorized pmos models.
+ *
+ *  Functions psnr2mos(), ssim2mos(), vif2mos() and vmaf2mos() accept metric scores and viewing
+ *  geometry as scalars, sequences or 1-D buffers (e.g. NumPy arrays) of equal lengths; scalars and
+ *  arrays of length 1 are broadcast over all rows. Buffers of float64 scores and int32 geometry
+ *  parameters are used in place, without copying (sequences and int64 buffers are converted). Scoring runs without
+ *  the GIL, on parallel threads, with per-thread caches of viewing contexts (see pmos_batch.h).
+ *
+ *  Example:
+ *
+ *    import numpy as np, pmos
+ *    mos = np.frombuffer(pmos.psnr2mos(psnr, width, height, 3840, 2160, device=pmos.DEVICE_TV))
+ *
+ *  Rows with invalid parameters produce negative error codes (see psnr2mos() in pmos.c).
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <string.h>
+#include <limits.h>
+#include "pmos.h"
+#include "pmos_batch.h"
+
+/*! Argument that is either a scalar or a 1-D buffer: */
+struct column_arg {
+	Py_buffer view;			/* buffer (if view.obj != NULL) */
+	int scalar_int;			/* scalar value (integer columns) */
+	double scalar_double;		/* scalar value (score columns) */
+	int* converted;			/* converted integers (if not int32, or a sequence) */
+	double* converted_double;	/* converted scores (if a sequence) */
+	Py_ssize_t n;			/* number of elements */
+};
+
+/*!
+ * \brief Checks if buffer format denotes native type with given code.
+ */
+static int format_is(const Py_buffer* view, char code)
+{
+	const char* f = view->format ? view->format : "B";
+	if (*f == '@' || *f == '=' || *f == '<') f++;
+	return f[0] == code && f[1] == 0;
+}
+
+/*!
+ * \brief Converts Python integer to int.
+ *
+ * \returns 0 - success, -1 - error (Python exception is set, OverflowError if out of int range)
+ */
+static int long_to_int(PyObject* obj, int* v)
+{
+	long x = PyLong_AsLong(obj);
+
+	if (x == -1 && PyErr_Occurred()) return -1;
+	if (x < INT_MIN || x > INT_MAX) {
+		PyErr_SetString(PyExc_OverflowError, "integer is out of int32 range");
+		return -1;
+	}
+	*v = (int)x;
+	return 0;
+}
+
+/*!
+ * \brief Releases argument buffers.
+ */
+static void column_release(struct column_arg* c)
+{
+	if (c->converted) PyMem_Free(c->converted);
+	if (c->converted_double) PyMem_Free(c->converted_double);
+	if (c->view.obj) PyBuffer_Release(&c->view);
+	c->converted = NULL;
+	c->converted_double = NULL;
+}
+
+/*!
+ * \brief Parses a scalar or 1-D buffer argument.
+ *
+ * \returns 0 - success, -1 - error (Python exception is set)
+ */
+static int column_parse(PyObject* obj, const char* name, int is_double, struct column_arg* c)
+{
+	Py_ssize_t i;
+
+	memset(c, 0, sizeof(*c));
+	c->n = 1;
+
+	/* sequences (e.g. lists) - convert: */
+	if (!PyObject_CheckBuffer(obj) && PySequence_Check(obj) && !PyUnicode_Check(obj)) {
+		c->n = PySequence_Size(obj);
+		if (c->n < 0) return -1;
+		if (is_double)
+			c->converted_double = (double*)PyMem_Malloc((c->n ? c->n : 1) * sizeof(double));
+		else
+			c->converted = (int*)PyMem_Malloc((c->n ? c->n : 1) * sizeof(int));
+		if (c->converted == NULL && c->converted_double == NULL) {
+			PyErr_NoMemory();
+			return -1;
+		}
+		for (i = 0; i < c->n; i++) {
+			PyObject* item = PySequence_GetItem(obj, i);
+			if (item == NULL) goto fail;
+			if (is_double)
+				c->converted_double[i] = PyFloat_AsDouble(item);
+			else
+				long_to_int(item, &c->converted[i]);
+			Py_DECREF(item);
+			if (PyErr_Occurred()) {
+				if (PyErr_ExceptionMatches(PyExc_OverflowError))
+					PyErr_Format(PyExc_OverflowError, "elements of %s must be in int32 range", name);
+				else
+					PyErr_Format(PyExc_TypeError, "elements of %s must be numbers", name);
+				goto fail;
+			}
+		}
+		return 0;
+	}
+
+	/* scalars: */
+	if (!PyObject_CheckBuffer(obj)) {
+		if (is_double)
+			c->scalar_double = PyFloat_AsDouble(obj);
+		else
+			long_to_int(obj, &c->scalar_int);
+		if (PyErr_Occurred()) {
+			if (PyErr_ExceptionMatches(PyExc_OverflowError))
+				PyErr_Format(PyExc_OverflowError, "%s must be in int32 range", name);
+			else
+				PyErr_Format(PyExc_TypeError, "%s must be a number or a 1-D array", name);
+			return -1;
+		}
+		return 0;
+	}
+
+	/* buffers: */
+	if (PyObject_GetBuffer(obj, &c->view, PyBUF_FORMAT | PyBUF_STRIDES)) return -1;
+	if (c->view.ndim > 1 || (c->view.ndim == 1 && c->view.strides[0] % c->view.itemsize)) {
+		PyErr_Format(PyExc_ValueError, "%s must be a 1-D array with aligned strides", name);
+		goto fail;
+	}
+	c->n = c->view.ndim ? c->view.shape[0] : 1;
+	if (is_double) {
+		if (!format_is(&c->view, 'd')) {
+			PyErr_Format(PyExc_TypeError, "%s must be an array of float64", name);
+			goto fail;
+		}
+		return 0;
+	}
+	if ((format_is(&c->view, 'i') || format_is(&c->view, 'l')) && c->view.itemsize == sizeof(int))
+		return 0;
+
+	/* other integer types - convert: */
+	if (c->view.itemsize != 8 || !(format_is(&c->view, 'l') || format_is(&c->view, 'q'))) {
+		PyErr_Format(PyExc_TypeError, "%s must be an array of int32 or int64", name);
+		goto fail;
+	}
+	c->converted = (int*)PyMem_Malloc((c->n ? c->n : 1) * sizeof(int));
+	if (c->converted == NULL) {
+		PyErr_NoMemory();
+		goto fail;
+	}
+	for (i = 0; i < c->n; i++) {
+		long long x = *(long long*)((char*)c->view.buf + i * (c->view.ndim ? c->view.strides[0] : 0));
+		if (x < INT_MIN || x > INT_MAX) {
+			PyErr_Format(PyExc_OverflowError, "elements of %s must be in int32 range", name);
+			goto fail;
+		}
+		c->converted[i] = (int)x;
+	}
+	return 0;
+
+fail:
+	column_release(c);
+	return -1;
+}
+
+/*!
+ * \brief Sets up batch column for an integer argument.
+ */
+static void column_setup(struct column_arg* c, Py_ssize_t n, struct batch_column* col)
+{
+	if (c->converted) {
+		col->data = c->converted;
+		col->stride = c->n == 1 && n != 1 ? 0 : 1;
+	} else if (c->view.obj) {
+		col->data = (const int*)c->view.buf;
+		col->stride = c->n == 1 && n != 1 ? 0 : (int)(c->view.ndim ? c->view.strides[0] / c->view.itemsize : 0);
+	} else {
+		col->data = &c->scalar_int;
+		col->stride = 0;
+	}
+}
+
+/*!
+ * \brief Common implementation of all scoring functions.
+ */
+static PyObject* metric2mos_py(int metric, PyObject* args, PyObject* kwargs)
+{
+	static char* keywords[] = {"values", "width", "height", "player_width", "player_height", "hdr", "upsampling", "device", "params", "out", "threads", NULL};
+	static const char* names[] = {"values", "width", "height", "player_width", "player_height", "hdr", "upsampling", "device"};
+	PyObject* objs[8], *zero = NULL, *tv = NULL, *params_obj = Py_None, *out_obj = Py_None, *result = NULL;
+	struct column_arg cols[8];
+	struct device_params params;
+	struct score_batch batch;
+	Py_buffer out;
+	Py_ssize_t n = 1;
+	int i, n_parsed = 0, n_threads = 0, err;
+
+	objs[5] = objs[6] = objs[7] = NULL;
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOOOO|OOOOOi", keywords, &objs[0], &objs[1], &objs[2], &objs[3], &objs[4],
+		&objs[5], &objs[6], &objs[7], &params_obj, &out_obj, &n_threads)) return NULL;
+
+	/* defaults: SDR, bicubic upsampling, TV: */
+	zero = PyLong_FromLong(0);
+	tv = PyLong_FromLong(device_tv);
+	if (zero == NULL || tv == NULL) goto done;
+	if (objs[5] == NULL) objs[5] = zero;
+	if (objs[6] == NULL) objs[6] = zero;
+	if (objs[7] == NULL) objs[7] = tv;
+	memset(&out, 0, sizeof(out));
+
+	/* custom device parameters: (display_width, display_height, ppi_x, ppi_y, distance_type, distance) */
+	memset(&params, 0, sizeof(params));
+	if (params_obj != Py_None && !PyArg_ParseTuple(params_obj, "iiddid;params must be (display_width, display_height, ppi_x, ppi_y, distance_type, distance)",
+		&params.display_width, &params.display_height, &params.ppi_x, &params.ppi_y, &params.distance_type, &params.distance)) goto done;
+
+	/* parse columns, and find common length: */
+	for (; n_parsed < 8; n_parsed++)
+		if (column_parse(objs[n_parsed], names[n_parsed], n_parsed == 0, &cols[n_parsed])) goto done;
+	for (i = 0; i < 8; i++)
+		if (cols[i].n != 1 && n == 1) n = cols[i].n;
+	for (i = 0; i < 8; i++)
+		if (cols[i].n != 1 && cols[i].n != n) {
+			PyErr_Format(PyExc_ValueError, "%s has length %zd, expected %zd or 1", names[i], cols[i].n, n);
+			goto done;
+		}
+	if (n > 0x7fffffff) {
+		PyErr_SetString(PyExc_ValueError, "too many rows");
+		goto done;
+	}
+
+	/* output buffer - given or new: */
+	if (out_obj == Py_None) {
+		result = PyByteArray_FromStringAndSize(NULL, n * sizeof(double));
+		if (result == NULL) goto done;
+		if (PyObject_GetBuffer(result, &out, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS)) { Py_CLEAR(result); goto done; }
+	} else {
+		if (PyObject_GetBuffer(out_obj, &out, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS | PyBUF_FORMAT)) goto done;
+		if (!format_is(&out, 'd') || out.len != n * (Py_ssize_t)sizeof(double)) {
+			PyErr_Format(PyExc_ValueError, "out must be a contiguous array of %zd float64 values", n);
+			PyBuffer_Release(&out);
+			goto done;
+		}
+		Py_INCREF(out_obj);
+		result = out_obj;
+	}
+
+	/* set up batch: */
+	batch.n = (int)n;
+	if (cols[0].converted_double) {
+		batch.values = cols[0].converted_double;
+		batch.values_stride = cols[0].n == 1 && n != 1 ? 0 : 1;
+	} else if (cols[0].view.obj) {
+		batch.values = (const double*)cols[0].view.buf;
+		batch.values_stride = cols[0].n == 1 && n != 1 ? 0 : (int)(cols[0].view.ndim ? cols[0].view.strides[0] / (Py_ssize_t)sizeof(double) : 0);
+	} else {
+		batch.values = &cols[0].scalar_double;
+		batch.values_stride = 0;
+	}
+	column_setup(&cols[1], n, &batch.width);
+	column_setup(&cols[2], n, &batch.height);
+	column_setup(&cols[3], n, &batch.player_width);
+	column_setup(&cols[4], n, &batch.player_height);
+	column_setup(&cols[5], n, &batch.hdr);
+	column_setup(&cols[6], n, &batch.upsampling);
+	column_setup(&cols[7], n, &batch.device);
+	batch.params = params_obj != Py_None ? &params : NULL;
+	batch.store = NULL;
+
+	/* score without holding the GIL: */
+	Py_BEGIN_ALLOW_THREADS
+	err = score_batch(metric, &batch, (double*)out.buf, n_threads);
+	Py_END_ALLOW_THREADS
+	(void)err;	/* per-row errors are reported in the output */
+
+	PyBuffer_Release(&out);
+	if (out_obj == Py_None) {
+		/* return float64 view of new buffer: */
+		PyObject* view = PyMemoryView_FromObject(result);
+		Py_DECREF(result);
+		result = view ? PyObject_CallMethod(view, "cast", "s", "d") : NULL;
+		Py_XDECREF(view);
+	}
+
+done:
+	for (i = 0; i < n_parsed; i++)
+		column_release(&cols[i]);
+	Py_XDECREF(zero);
+	Py_XDECREF(tv);
+	return result;
+}
+
+static PyObject* psnr2mos_py(PyObject* self, PyObject* args, PyObject* kwargs) { return metric2mos_py(metric_psnr, args, kwargs); }
+static PyObject* ssim2mos_py(PyObject* self, PyObject* args, PyObject* kwargs) { return metric2mos_py(metric_ssim, args, kwargs); }
+static PyObject* vif2mos_py(PyObject* self, PyObject* args, PyObject* kwargs) { return metric2mos_py(metric_vif, args, kwargs); }
+static PyObject* vmaf2mos_py(PyObject* self, PyObject* args, PyObject* kwargs) { return metric2mos_py(metric_vmaf, args, kwargs); }
+
+#define SCORE_DOC(name, metric) name "(values, width, height, player_width, player_height, hdr=0, upsampling=0, device=DEVICE_TV, params=None, out=None, threads=0)\n--\n\n" \
+	"Maps " metric " scores to MOS. Arguments are numbers or 1-D arrays (broadcast if of length 1).\n" \
+	"Returns float64 memoryview (or out, if given); invalid rows produce negative error codes."
+
+static PyMethodDef pmos_methods[] = {
+	{"psnr2mos", (PyCFunction)(void(*)(void))psnr2mos_py, METH_VARARGS | METH_KEYWORDS, SCORE_DOC("psnr2mos", "PSNR")},
+	{"ssim2mos", (PyCFunction)(void(*)(void))ssim2mos_py, METH_VARARGS | METH_KEYWORDS, SCORE_DOC("ssim2mos", "SSIM")},
+	{"vif2mos", (PyCFunction)(void(*)(void))vif2mos_py, METH_VARARGS | METH_KEYWORDS, SCORE_DOC("vif2mos", "VIF")},
+	{"vmaf2mos", (PyCFunction)(void(*)(void))vmaf2mos_py, METH_VARARGS | METH_KEYWORDS, SCORE_DOC("vmaf2mos", "VMAF")},
+	{NULL, NULL, 0, NULL}
+};
+
+static struct PyModuleDef pmos_module = {
+	PyModuleDef_HEAD_INIT, "pmos", "Parametric MOS models for multi-screen systems.", -1, pmos_methods
+};
+
+PyMODINIT_FUNC PyInit_pmos(void)
+{
+	PyObject* m = PyModule_Create(&pmos_module);
+	if (m == NULL) return NULL;
+	PyModule_AddIntConstant(m, "DEVICE_MOBILE", device_mobile);
+	PyModule_AddIntConstant(m, "DEVICE_TABLET", device_tablet);
+	PyModule_AddIntConstant(m, "DEVICE_PC", device_pc);
+	PyModule_AddIntConstant(m, "DEVICE_TV", device_tv);
+	PyModule_AddIntConstant(m, "DEVICE_CUSTOM", device_custom);
+	PyModule_AddIntConstant(m, "UPSAMPLING_BICUBIC", upsampling_bicubic);
+	PyModule_AddIntConstant(m, "UPSAMPLING_NEAREST", upsampling_nn);
+	PyModule_AddIntConstant(m, "UPSAMPLING_SUPER_RESOLUTION", upsampling_sr);
+	return m;
+}
+
+/* pmosmodule.c -- end of file */
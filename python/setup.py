@@ -0,0 +1,15 @@
+# Build: python setup.py build_ext --inplace
+import sys
+from setuptools import setup, Extension
+
+# no contraction of multiply-adds into FMAs, as required for reproducible mode (MSVC does not contract by default):
+extra_compile_args = [] if sys.platform == 'win32' else ['-ffp-contract=off']
+
+sources = ['pmosmodule.c'] + ['../source/' + f for f in ['pmos.c', 'pmos_repro.c', 'pmos_cache.c', 'pmos_batch.c', 'pmos_thread.c']]
+
+setup(
+    name='pmos',
+    version='1.0.0',
+    description='Parametric MOS models for multi-screen systems',
+    ext_modules=[Extension('pmos', sources=sources, include_dirs=['../source'], extra_compile_args=extra_compile_args)],
+)
@@ -19,6 +19,8 @@
 #include <stdio.h>
 #include <math.h>
 #include "pmos.h"
+#include "pmos_probes.h"
+#include "pmos_repro.h"
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -30,6 +32,14 @@
 #define max(a,b) ((a)>=(b)?(a):(b))
 #endif
 
+/*! Reproducible mode - elementary functions are computed by platform-independent code (see pmos_repro.c): */
+static int reproducible = 0;
+
+static double m_exp(double x) { return reproducible ? repro_exp(x) : exp(x); }
+static double m_log(double x) { return reproducible ? repro_log(x) : log(x); }
+static double m_pow(double x, double y) { return reproducible ? repro_pow(x, y) : pow(x, y); }
+static double m_atan(double x) { return reproducible ? repro_atan(x) : atan(x); }
+
 /****************************
  *
  * The models:
@@ -39,9 +49,21 @@
  *   wr_plus_ssim2mos() - WR+SSIM2MOS model [3]
  *   wr_plus_vif2mos()  - WR+VIF2MOS model  [3]
  *   wr_plus_vmaf2mos() - WR+VMAF2MOS model [3]
+ *
+ *   metric_to_q() and fused_mos() implement mappings shared by all fused models [3].
  * 
  ***/
 
+/*!
+ *  Parameters of generalized WR model [2]:
+ */
+static struct wr_params wr_sdr = { 2.72, 145.69, 1.55, 2.12, 6.01, 2.11, 35.0, 16.93 }; /* sdr model: [2, page 4] */
+static struct wr_params wr_hdr[n_upsampling_methods] = {
+	{2.72, 106.91, 1.55 * 1.08, 2.12 * 1.08, 6.01, 1.76, 35.0, 13.93}, /* bc, hdr, [2, page 5, Table III, line 3] */
+	{2.72, 106.91, 1.55 * 1.08, 2.12 * 1.08, 6.01, 2.5,  35.0, 23.4},  /* nn, hdr, [2, page 5, Table III, line 2] */
+	{2.72, 106.91, 1.55 * 1.08, 2.12 * 1.08, 6.01, 2.06, 35.0, 12.24}, /* sr, hdr, [2, page 5, Table III, line 4] */
+};
+
 /*!
  *  \brief Generalized Westerink-Roufs model [2].
  *
@@ -54,14 +76,6 @@
  */
 static double wr_model(double phi, double u, int hdr, int upsampling)
 {
-	/* generalized WR model parameters [2]: */
-	struct wr_params { double alpha, beta, gamma, delta, k, l, phi_s, u_s; };
-	static struct wr_params wr_sdr = { 2.72, 145.69, 1.55, 2.12, 6.01, 2.11, 35.0, 16.93 }; /* sdr model: [2, page 4] */
-	static struct wr_params wr_hdr[n_upsampling_methods] = {
-		{2.72, 106.91, 1.55 * 1.08, 2.12 * 1.08, 6.01, 1.76, 35.0, 13.93}, /* bc, hdr, [2, page 5, Table III, line 3] */
-		{2.72, 106.91, 1.55 * 1.08, 2.12 * 1.08, 6.01, 2.5,  35.0, 23.4},  /* nn, hdr, [2, page 5, Table III, line 2] */
-		{2.72, 106.91, 1.55 * 1.08, 2.12 * 1.08, 6.01, 2.06, 35.0, 12.24}, /* sr, hdr, [2, page 5, Table III, line 4] */
-	};
 	struct wr_params* wr;
 	double f_phi, f_u, mos;
 
@@ -76,9 +90,63 @@ static double wr_model(double phi, double u, int hdr, int upsampling)
 	if (hdr) wr = wr_hdr + upsampling;
 
 	/* compute WR score [2, formulae 8]: */
-	f_phi = pow(1.0 + pow(phi / wr->phi_s, -wr->k), -wr->gamma / wr->k);
-	f_u = pow(1.0 + pow(u / wr->u_s, -wr->l), -wr->delta / wr->l);
-	mos = log(wr->alpha + wr->beta * f_phi * f_u);
+	f_phi = m_pow(1.0 + m_pow(phi / wr->phi_s, -wr->k), -wr->gamma / wr->k);
+	f_u = m_pow(1.0 + m_pow(u / wr->u_s, -wr->l), -wr->delta / wr->l);
+	mos = m_log(wr->alpha + wr->beta * f_phi * f_u);
+
+	/* clamp it to 1..5 range: */
+	mos = max(1, min(5, mos));
+	return mos;
+}
+
+/*!
+ *  Parameters of fused models, cf. Table 4 [3] (the order of records in this table follows values of enum metric_types):
+ */
+static struct fusion_params fusion_models[n_metric_types] =
+{
+	/* alpha,  beta,    gamma,  delta, epsilon, zeta */
+	{-6.906,   6.130,   -0.048, 1.476, 0.228,   23.83},  /* WR+PSNR2MOS */
+	{-7.181,   7.662,   -0.089, 1.753, 7.492,   0.777},  /* WR+SSIM2MOS */
+	{-12.09,   12.117,  -0.137, 2.763, 4.846,   0.416},  /* WR+VIF2MOS  */
+	{-7.682,   0.0753,  -0.122, 2.01,  0,       0}       /* WR+VMAF2MOS (VMAF scores are used as is) */
+};
+
+/*!
+ *  \brief Maps full-reference metric score to MOS scale [3, formulae 4, 5].
+ *
+ *  \param[in] metric       metric type (see enum metric_types)
+ *  \param[in] value        full-reference metric score
+ *
+ *  \return mapped score
+ */
+static double metric_to_q(int metric, double value)
+{
+	struct fusion_params* f = &fusion_models[metric];
+
+	/* VMAF is used as is [3, formula 5]: */
+	if (metric == metric_vmaf)
+		return value;
+
+	/* logistic mapping [3, formula 4]: */
+	return 1.0 / (1.0 + m_exp(-f->epsilon * (value - f->zeta)));
+}
+
+/*!
+ *  \brief Fused MOS score [3, formula 2].
+ *
+ *  \param[in] metric       metric type (see enum metric_types)
+ *  \param[in] Qwr          WR quality score
+ *  \param[in] Q            metric score mapped to MOS scale (see metric_to_q())
+ *
+ *  \return MOS score
+ */
+static double fused_mos(int metric, double Qwr, double Q)
+{
+	struct fusion_params* f = &fusion_models[metric];
+	double mos;
+
+	/* compute fused MOS score [3, formula 2]: */
+	mos = f->alpha + f->beta * (1 + f->gamma * Qwr) * Q + f->delta * Qwr;
 
 	/* clamp it to 1..5 range: */
 	mos = max(1, min(5, mos));
@@ -98,9 +166,7 @@ static double wr_model(double phi, double u, int hdr, int upsampling)
  */
 static double wr_plus_psnr2mos(double phi, double u, int hdr, int upsampling, double psnr)
 {
-	/* model parameters, cf. Table 4 [3] */
-	double alpha = -6.906, beta = 6.130, gamma = -0.048, delta = 1.476, epsilon = 0.228, zeta = 23.83;
-	double Qpsnr, Qwr, mos;
+	double Qpsnr, Qwr;
 
 	/* sanity checks */
 	assert(phi > 0 && phi < 180);
@@ -113,14 +179,10 @@ static double wr_plus_psnr2mos(double phi, double u, int hdr, int upsampling, do
 	Qwr = wr_model(phi, u, hdr, upsampling);
 
 	/* map PSNR to MOS scale [3, formula 4]: */
-	Qpsnr = 1.0 / (1.0 + exp(-epsilon * (psnr - zeta)));
+	Qpsnr = metric_to_q(metric_psnr, psnr);
 
 	/* compute fused MOS score [3, formula 2]: */
-	mos = alpha + beta * (1 + gamma * Qwr) * Qpsnr + delta * Qwr;
-
-	/* clamp it to 1..5 range: */
-	mos = max(1, min(5, mos));
-	return mos;
+	return fused_mos(metric_psnr, Qwr, Qpsnr);
 }
 
 /*!
@@ -136,9 +198,7 @@ static double wr_plus_psnr2mos(double phi, double u, int hdr, int upsampling, do
  */
 static double wr_plus_ssim2mos(double phi, double u, int hdr, int upsampling, double ssim)
 {
-	/* model parameters, cf. Table 4 [3] */
-	double alpha = -7.181, beta = 7.662, gamma = -0.089, delta = 1.753, epsilon = 7.492, zeta = 0.777;
-	double Qssim, Qwr, mos;
+	double Qssim, Qwr;
 
 	/* sanity checks */
 	assert(phi > 0 && phi < 180);
@@ -151,14 +211,10 @@ static double wr_plus_ssim2mos(double phi, double u, int hdr, int upsampling, do
 	Qwr = wr_model(phi, u, hdr, upsampling);
 
 	/* map SSIM to MOS scale [3, formula 4]: */
-	Qssim = 1.0 / (1.0 + exp(-epsilon * (ssim - zeta)));
+	Qssim = metric_to_q(metric_ssim, ssim);
 
 	/* compute fused MOS score [3, formula 2]: */
-	mos = alpha + beta * (1 + gamma * Qwr) * Qssim + delta * Qwr;
-
-	/* clamp it to 1..5 range: */
-	mos = max(1, min(5, mos));
-	return mos;
+	return fused_mos(metric_ssim, Qwr, Qssim);
 }
 
 /*!
@@ -174,9 +230,7 @@ static double wr_plus_ssim2mos(double phi, double u, int hdr, int upsampling, do
  */
 static double wr_plus_vif2mos(double phi, double u, int hdr, int upsampling, double vif)
 {
-	/* model parameters, cf. Table 4 [3] */
-	double alpha = -12.09, beta = 12.117, gamma = -0.137, delta = 2.763, epsilon = 4.846, zeta = 0.416;
-	double Qvif, Qwr, mos;
+	double Qvif, Qwr;
 
 	/* sanity checks */
 	assert(phi > 0 && phi < 180);
@@ -189,14 +243,10 @@ static double wr_plus_vif2mos(double phi, double u, int hdr, int upsampling, dou
 	Qwr = wr_model(phi, u, hdr, upsampling);
 
 	/* map VIF to MOS scale [3, formula 4]: */
-	Qvif = 1.0 / (1.0 + exp(-epsilon * (vif - zeta)));
+	Qvif = metric_to_q(metric_vif, vif);
 
 	/* compute fused MOS score [3, formula 2]: */
-	mos = alpha + beta * (1 + gamma * Qwr) * Qvif + delta * Qwr;
-
-	/* clamp it to 1..5 range: */
-	mos = max(1, min(5, mos));
-	return mos;
+	return fused_mos(metric_vif, Qwr, Qvif);
 }
 
 /*!
@@ -212,9 +262,7 @@ static double wr_plus_vif2mos(double phi, double u, int hdr, int upsampling, dou
  */
 static double wr_plus_vmaf2mos(double phi, double u, int hdr, int upsampling, double vmaf)
 {
-	/* model parameters, cf. Table 4 [3] */
-	double alpha = -7.682, beta = 0.0753, gamma = -0.122, delta = 2.01;
-	double Qvmaf, Qwr, mos;
+	double Qvmaf, Qwr;
 
 	/* sanity checks */
 	assert(phi > 0 && phi < 180);
@@ -227,14 +275,10 @@ static double wr_plus_vmaf2mos(double phi, double u, int hdr, int upsampling, do
 	Qwr = wr_model(phi, u, hdr, upsampling);
 
 	/* map VMAF to MOS scale [3, formula 5]: */
-	Qvmaf = vmaf;
+	Qvmaf = metric_to_q(metric_vmaf, vmaf);
 
-	/* compute final MOS score [3, formula 2]: */
-	mos = alpha + beta * (1 + gamma * Qwr) * Qvmaf + delta * Qwr;
-
-	/* clamp it to 1..5 range: */
-	mos = max(1, min(5, mos));
-	return mos;
+	/* compute fused MOS score [3, formula 2]: */
+	return fused_mos(metric_vmaf, Qwr, Qvmaf);
 }
 
 /****************************
@@ -244,6 +288,7 @@ static double wr_plus_vmaf2mos(double phi, double u, int hdr, int upsampling, do
  *   viewing_angle()             - computes viewing angle
  *   angular_resolution()        - computes angular resolution
  *   heights_to_inches()         - translates relative viewing distance into absolute metrics
+ *   device_distance()           - selects device parameters and computes absolute viewing distance
  *   device_to_viewing_params()  - computes viewing angle and angular resolution as specific to a given player and device
  * 
  ***/
@@ -257,7 +302,7 @@ static double wr_plus_vmaf2mos(double phi, double u, int hdr, int upsampling, do
  *
  *  \return viewing andge [degrees]
  */
-static double viewing_angle(int player_width, double distance, double ppi_x)
+double viewing_angle(int player_width, double distance, double ppi_x)
 {
 	/* sanity checks */
 	assert(player_width > 0);
@@ -265,7 +310,7 @@ static double viewing_angle(int player_width, double distance, double ppi_x)
 	assert(ppi_x > 0);
 
 	/* apply formula for viewing angle */
-	return 180.0 / M_PI * 2 * atan((double)player_width / (2.0 * distance * ppi_x));
+	return 180.0 / M_PI * 2 * m_atan((double)player_width / (2.0 * distance * ppi_x));
 }
 
 /*!
@@ -292,7 +337,7 @@ double angular_resolution(int video_width, int player_width, double distance, do
 	width = min(video_width, player_width);
 
 	/* apply formula for viewing angle of a cycle (2 pixels): */
-	viewing_angle_of_a_cycle = 180.0 / M_PI * 2 * atan((double)player_width / ((double)width * distance * ppi_x));
+	viewing_angle_of_a_cycle = 180.0 / M_PI * 2 * m_atan((double)player_width / ((double)width * distance * ppi_x));
 
 	/* map to cpd: */
 	return 1. / viewing_angle_of_a_cycle;
@@ -337,6 +382,54 @@ static struct device_params devices[n_device_types] =
 	{0,    0,    0,     0,     0,  0}    /* custome device type - parameters to be provided by an external structure */
 };
 
+/*!
+ * \brief Selects parameters of a given device, and computes its absolute viewing distance
+ *
+ *  \param[in]  device			device type [device_type]
+ *  \param[in]  params			custom device parameters
+ *  \param[out] pp				device parameters
+ *  \param[out] p_distance		viewing distance [inches]
+ *
+ *  \returns    0				success
+ *				-5				invalid device type
+ *				-6				NULL pointer
+ *				-7				invalid custom device parameters
+ */
+static int device_distance(int device, struct device_params* params, struct device_params** pp, double* p_distance)
+{
+	struct device_params* p;
+	double distance;
+
+	if (device < 0 || device >= n_device_types) return -5;
+
+	/* standard device? */
+	if (device < device_custom) {
+		/* select default parameters for a given device: */
+		p = & devices[device];
+	} else {
+		/* check if custom device parameter structure is present: */
+		p = params;
+		if (p == NULL) return -6;
+		if (p->display_width < 128 || p->display_width > 16384) return -7;
+		if (p->display_height < 128 || p->display_height > 16384) return -7;
+		if (p->ppi_x < 1 || p->ppi_x > 10000) return -7;
+		if (p->ppi_y < 1 || p->ppi_y > 10000) return -7;
+		if (p->distance_type < 0) return -7;
+		if (p->distance <= 0 || p->distance > 10000) return -7;
+	}
+
+	/* check if device comes with relative viewing distance: */
+	distance = p->distance;
+	if (p->distance_type) {
+		/* compute absolute distance: */
+		distance = heights_to_inches(p->display_height, p->ppi_y, p->distance);
+	}
+
+	*pp = p;
+	*p_distance = distance;
+	return 0;
+}
+
 /*!
  * \brief Computes viewing angle and angular resolution as specific to a given player and device
  *  
@@ -361,10 +454,11 @@ static struct device_params devices[n_device_types] =
  *				-7				invalid custom device parameters
  *				-8              internal error
  */
-int device_to_viewing_params(int width, int height,int player_width, int player_height, int hdr, int upsampling, int device, struct device_params* params, double *p_phi, double *p_u)
+static int viewing_params(int width, int height,int player_width, int player_height, int hdr, int upsampling, int device, struct device_params* params, double *p_phi, double *p_u)
 {
 	double distance, phi, u;
 	struct device_params* p;
+	int err;
 
 	/* check parameters */
 	if (width < 1 || width > 8192) return -1;
@@ -377,28 +471,9 @@ int device_to_viewing_params(int width, int height,int player_width, int player_
 	if (p_phi == NULL) return -6;
 	if (p_u == NULL) return -6;
 
-	/* standard device? */
-	if (device <= device_custom) {
-		/* select default parameters for a given device: */
-		p = & devices[device];
-	} else {
-		/* check if custom device parameter structure is present: */
-		p = params;
-		if (p == NULL) return -6;
-		if (p->display_width < 128 || p->display_width > 16384) return -7;
-		if (p->display_height < 128 || p->display_height > 16384) return -7;
-		if (p->ppi_x < 1 || p->ppi_x > 10000) return -7;
-		if (p->ppi_y < 1 || p->ppi_y > 10000) return -7;
-		if (p->distance_type < 0) return -7;
-		if (p->distance <= 0 || p->distance > 10000) return -7;
-	}
-
-	/* check if device comes with relative viewing distance: */
-	distance = p->distance;
-	if (p->distance_type) {
-		/* compute absolute distance: */
-		distance = heights_to_inches(p->display_height, p->ppi_y, p->distance);
-	}
+	/* select device parameters and compute absolute viewing distance: */
+	err = device_distance(device, params, &p, &distance);
+	if (err) return err;
 
 	/* compute effective viewing andgle and angular resolution: */
 	phi = viewing_angle(player_width, distance, p->ppi_x);
@@ -416,6 +491,21 @@ int device_to_viewing_params(int width, int height,int player_width, int player_
 	return 0;
 }
 
+/*!
+ * \brief Computes viewing angle and angular resolution as specific to a given player and device
+ *
+ *  Traced wrapper around viewing_params(); see its description for parameters and return codes.
+ */
+int device_to_viewing_params(int width, int height, int player_width, int player_height, int hdr, int upsampling, int device, struct device_params* params, double* p_phi, double* p_u)
+{
+	int err;
+
+	PMOS_PROBE7(device_to_viewing_params_entry, width, height, player_width, player_height, hdr, upsampling, device);
+	err = viewing_params(width, height, player_width, player_height, hdr, upsampling, device, params, p_phi, p_u);
+	PMOS_PROBE3(device_to_viewing_params_return, err, err ? 0 : PMOS_PROBE_MILLI(*p_phi), err ? 0 : PMOS_PROBE_MILLI(*p_u));
+	return err;
+}
+
 /****************************
  *
  * External functions:
@@ -448,17 +538,22 @@ double psnr2mos(double psnr, int width, int height, int player_width, int player
 	double phi = 0, u = 0, mos;
 	int err;
 
+	PMOS_PROBE8(psnr2mos_entry, PMOS_PROBE_MILLI(psnr), width, height, player_width, player_height, hdr, upsampling, device);
+
 	/* check input variables and compute angular parameters of viewing setup: */
 	err = device_to_viewing_params(width, height, player_width, player_height, hdr, upsampling, device, params, &phi, &u);
 	if (err)
-		return (double)err;
+		mos = (double)err;
 
 	/* check if PSNR score is valid */
-	if (psnr < 0 || psnr > 100)
-		return -9;
+	else if (psnr < 0 || psnr > 100)
+		mos = -9;
 
 	/* compute WR+PSNR2MOS quality score: */
-	mos = wr_plus_psnr2mos(phi, u, hdr, upsampling, psnr);
+	else
+		mos = wr_plus_psnr2mos(phi, u, hdr, upsampling, psnr);
+
+	PMOS_PROBE2(psnr2mos_return, PMOS_PROBE_MILLI(mos), mos < 0 ? (int)mos : 0);
 	return mos;
 }
 
@@ -470,17 +565,22 @@ double ssim2mos(double ssim, int width, int height, int player_width, int player
 	double phi = 0, u = 0, mos;
 	int err;
 
+	PMOS_PROBE8(ssim2mos_entry, PMOS_PROBE_MILLI(ssim), width, height, player_width, player_height, hdr, upsampling, device);
+
 	/* check input variables and compute angular parameters of viewing setup: */
 	err = device_to_viewing_params(width, height, player_width, player_height, hdr, upsampling, device, params, &phi, &u);
 	if (err)
-		return (double)err;
+		mos = (double)err;
 
 	/* check if SSIM score is valid */
-	if (ssim < 0 || ssim > 1.0)
-		return -9;
+	else if (ssim < 0 || ssim > 1.0)
+		mos = -9;
 
 	/* compute WR+SSIM2MOS quality score: */
-	mos = wr_plus_ssim2mos(phi, u, hdr, upsampling, ssim);
+	else
+		mos = wr_plus_ssim2mos(phi, u, hdr, upsampling, ssim);
+
+	PMOS_PROBE2(ssim2mos_return, PMOS_PROBE_MILLI(mos), mos < 0 ? (int)mos : 0);
 	return mos;
 }
 
@@ -492,17 +592,22 @@ double vif2mos(double vif, int width, int height, int player_width, int player_h
 	double phi = 0, u = 0, mos;
 	int err;
 
+	PMOS_PROBE8(vif2mos_entry, PMOS_PROBE_MILLI(vif), width, height, player_width, player_height, hdr, upsampling, device);
+
 	/* check input variables and compute angular parameters of viewing setup: */
 	err = device_to_viewing_params(width, height, player_width, player_height, hdr, upsampling, device, params, &phi, &u);
 	if (err)
-		return (double)err;
+		mos = (double)err;
 
 	/* check if VIF score is valid */
-	if (vif < 0 || vif > 1.0)
-		return -9;
+	else if (vif < 0 || vif > 1.0)
+		mos = -9;
 
 	/* compute WR+SSIM2MOS quality score: */
-	mos = wr_plus_vif2mos(phi, u, hdr, upsampling, vif);
+	else
+		mos = wr_plus_vif2mos(phi, u, hdr, upsampling, vif);
+
+	PMOS_PROBE2(vif2mos_return, PMOS_PROBE_MILLI(mos), mos < 0 ? (int)mos : 0);
 	return mos;
 }
 
@@ -514,18 +619,513 @@ double vmaf2mos(double vmaf, int width, int height, int player_width, int player
 	double phi = 0, u = 0, mos;
 	int err;
 
+	PMOS_PROBE8(vmaf2mos_entry, PMOS_PROBE_MILLI(vmaf), width, height, player_width, player_height, hdr, upsampling, device);
+
 	/* check input variables and compute angular parameters of viewing setup: */
 	err = device_to_viewing_params(width, height, player_width, player_height, hdr, upsampling, device, params, &phi, &u);
 	if (err)
-		return (double)err;
+		mos = (double)err;
 
-	/* check if VIF score is valid */
-	if (vmaf < 0 || vmaf > 1.0)
-		return -9;
+	/* check if VMAF score is valid */
+	else if (vmaf < 0 || vmaf > 100)
+		mos = -9;
 
 	/* compute WR+SSIM2MOS quality score: */
-	mos = wr_plus_vmaf2mos(phi, u, hdr, upsampling, vmaf);
+	else
+		mos = wr_plus_vmaf2mos(phi, u, hdr, upsampling, vmaf);
+
+	PMOS_PROBE2(vmaf2mos_return, PMOS_PROBE_MILLI(mos), mos < 0 ? (int)mos : 0);
 	return mos;
 }
 
+/****************************
+ *
+ * Viewing contexts:
+ *
+ *   viewing_context_init() - validates viewing setup and caches its angular parameters and WR score
+ *   metric2mos()           - maps metric score to MOS using cached viewing context
+ *   metric2mos_batch()     - maps an array of metric scores to MOS using cached viewing context
+ *   mos2metric()           - inverse mapping: finds metric score needed to reach given MOS
+ *
+ ***/
+
+/*!
+ *  Valid ranges of metric scores (the order of records in this table follows values of enum metric_types):
+ */
+static double metric_ranges[n_metric_types][2] =
+{
+	{0, 100},  /* PSNR */
+	{0, 1},    /* SSIM */
+	{0, 1},    /* VIF  */
+	{0, 100}   /* VMAF */
+};
+
+/*!
+ * \brief Validates viewing setup and caches its angular parameters and WR score.
+ *
+ * \param[out] ctx			viewing context
+ * \param[in]  width			video width [pixels]
+ * \param[in]  height			video height [pixels]
+ * \param[in]  player_width	player video width [pixels]
+ * \param[in]  player_height	player video height [pixels]
+ * \param[in]	hdr				indicator if video is hdr (1) or sdr (0)
+ * \param[in]	upsampling		assumed upsampling method (see enum upsampling_methods)
+ * \param[in]  device			device type [device_type]
+ * \param[in]  params			custom device parameters
+ *
+ * \returns    0				success
+ *			  <0				error (see device_to_viewing_params())
+ */
+int viewing_context_init(struct viewing_context* ctx, int width, int height, int player_width, int player_height, int hdr, int upsampling, int device, struct device_params* params)
+{
+	double phi = 0, u = 0;
+	int err;
+
+	if (ctx == NULL) return -6;
+
+	/* check input variables and compute angular parameters of viewing setup: */
+	err = device_to_viewing_params(width, height, player_width, player_height, hdr, upsampling, device, params, &phi, &u);
+	if (err)
+		return err;
+
+	/* store the results, and WR score for this setup: */
+	ctx->phi = phi;
+	ctx->u = u;
+	ctx->hdr = hdr;
+	ctx->upsampling = upsampling;
+	ctx->qwr = wr_model(phi, u, hdr, upsampling);
+	return 0;
+}
+
+/*!
+ * \brief Maps metric score to MOS using cached viewing context.
+ *
+ * \param[in]  ctx			viewing context (see viewing_context_init())
+ * \param[in]  metric			metric type (see enum metric_types)
+ * \param[in]  value			metric score
+ *
+ * \returns   >0   - computed MOS score (in [1..5])
+ *            -6   - NULL pointer
+ *            -9   - invalid metric score
+ *            -10  - invalid metric type
+ */
+double metric2mos(const struct viewing_context* ctx, int metric, double value)
+{
+	double mos;
+
+	PMOS_PROBE2(metric2mos_entry, metric, PMOS_PROBE_MILLI(value));
+
+	if (ctx == NULL)
+		mos = -6;
+	else if (metric < 0 || metric >= n_metric_types)
+		mos = -10;
+	else if (value < metric_ranges[metric][0] || value > metric_ranges[metric][1])
+		mos = -9;
+	else
+		mos = fused_mos(metric, ctx->qwr, metric_to_q(metric, value));
+
+	PMOS_PROBE2(metric2mos_return, PMOS_PROBE_MILLI(mos), mos < 0 ? (int)mos : 0);
+	return mos;
+}
+
+/*!
+ * \brief Maps an array of metric scores to MOS using cached viewing context.
+ *
+ *  Invalid scores produce -9 at corresponding positions in the output array.
+ *
+ * \param[in]  ctx			viewing context (see viewing_context_init())
+ * \param[in]  metric			metric type (see enum metric_types)
+ * \param[in]  values			metric scores
+ * \param[out] mos			computed MOS scores
+ * \param[in]  n				number of scores
+ *
+ * \returns    0				success
+ *			  -6				NULL pointer
+ *			  -9				some metric scores are invalid
+ *			  -10				invalid metric type
+ */
+int metric2mos_batch(const struct viewing_context* ctx, int metric, const double* values, double* mos, int n)
+{
+	struct fusion_params* f;
+	double lo, hi, b, dq, m;
+	int i, err = 0;
+
+	PMOS_PROBE2(metric2mos_batch_entry, metric, n);
+
+	if (ctx == NULL || values == NULL || mos == NULL)
+		err = -6;
+	else if (metric < 0 || metric >= n_metric_types)
+		err = -10;
+	else {
+		/* factors of fused model [3, formula 2] that depend only on viewing setup: */
+		f = &fusion_models[metric];
+		b = f->beta * (1 + f->gamma * ctx->qwr);
+		dq = f->delta * ctx->qwr;
+		lo = metric_ranges[metric][0];
+		hi = metric_ranges[metric][1];
+
+		for (i = 0; i < n; i++) {
+			if (values[i] < lo || values[i] > hi) {
+				mos[i] = -9;
+				err = -9;
+				continue;
+			}
+			m = f->alpha + b * metric_to_q(metric, values[i]) + dq;
+			mos[i] = max(1, min(5, m));
+		}
+	}
+
+	PMOS_PROBE1(metric2mos_batch_return, err);
+	return err;
+}
+
+/*!
+ * \brief Inverse mapping: finds metric score needed to reach given MOS in a given viewing context.
+ *
+ * \param[in]  ctx			viewing context (see viewing_context_init())
+ * \param[in]  metric			metric type (see enum metric_types)
+ * \param[in]  mos			target MOS score (in [1..5])
+ *
+ * \returns  >=0   - smallest metric score reaching target MOS
+ *            -6   - NULL pointer
+ *            -9   - invalid MOS score
+ *            -10  - invalid metric type
+ *            -11  - target MOS cannot be reached in this viewing setup
+ */
+double mos2metric(const struct viewing_context* ctx, int metric, double mos)
+{
+	struct fusion_params* f;
+	double q, value;
+
+	if (ctx == NULL) return -6;
+	if (metric < 0 || metric >= n_metric_types) return -10;
+	if (mos < 1 || mos > 5) return -9;
+
+	/* solve [3, formula 2] for mapped metric score: */
+	f = &fusion_models[metric];
+	q = (mos - f->alpha - f->delta * ctx->qwr) / (f->beta * (1 + f->gamma * ctx->qwr));
+
+	/* invert [3, formulae 4, 5]: */
+	if (metric == metric_vmaf)
+		value = q;
+	else if (q <= 0)
+		value = metric_ranges[metric][0];
+	else if (q >= 1)
+		return -11;
+	else
+		value = f->zeta - m_log(1.0 / q - 1.0) / f->epsilon;
+
+	/* clip to valid range of metric scores: */
+	if (value > metric_ranges[metric][1]) return -11;
+	value = max(metric_ranges[metric][0], value);
+	return value;
+}
+
+/****************************
+ *
+ * Model parameters and building blocks (for tools evaluating models in other ways than functions above):
+ *
+ *   wr_model_params()      - returns parameters of WR model
+ *   fusion_model_params()  - returns parameters of fused model
+ *   wr_score()             - computes WR score for given viewing angle and angular resolution
+ *   metric_scale()         - maps metric score to MOS scale of fused models
+ *   metric_range()         - returns range of valid metric scores
+ *   device_geometry()      - returns display parameters and absolute viewing distance of a device
+ *   model_hash()           - returns hash of all model parameters (for validation of persisted results)
+ *   set_reproducible_mode() - enables bit-reproducible computation of all models
+ *
+ ***/
+
+/*!
+ * \brief Returns parameters of WR model [2] used for given type of content and upsampling method.
+ *
+ * \returns pointer to model parameters, NULL - invalid parameters
+ */
+const struct wr_params* wr_model_params(int hdr, int upsampling)
+{
+	if (hdr < 0 || hdr > 1) return NULL;
+	if (upsampling < 0 || upsampling >= n_upsampling_methods) return NULL;
+	return hdr ? &wr_hdr[upsampling] : &wr_sdr;
+}
+
+/*!
+ * \brief Returns parameters of fused model [3] for given metric type.
+ *
+ * \returns pointer to model parameters, NULL - invalid metric type
+ */
+const struct fusion_params* fusion_model_params(int metric)
+{
+	if (metric < 0 || metric >= n_metric_types) return NULL;
+	return &fusion_models[metric];
+}
+
+/*!
+ * \brief Computes WR score [2] for given viewing angle and angular resolution.
+ *
+ * \param[in]  phi			viewing angle [degrees]
+ * \param[in]  u				angular resolution [cycles per degree]
+ * \param[in]	hdr				indicator if video is hdr (1) or sdr (0)
+ * \param[in]	upsampling		assumed upsampling method (see enum upsampling_methods)
+ *
+ * \returns   >0				WR score (in [1..5])
+ *			  -3				invalid HDR/SDR indicator
+ *			  -4				invalid upsampling method
+ *			  -8				invalid viewing angle or angular resolution
+ */
+double wr_score(double phi, double u, int hdr, int upsampling)
+{
+	if (hdr < 0 || hdr > 1) return -3;
+	if (upsampling < 0 || upsampling >= n_upsampling_methods) return -4;
+	if (phi < 1 || phi > 180) return -8;
+	if (u < 1 || u > 200) return -8;
+	return wr_model(phi, u, hdr, upsampling);
+}
+
+/*!
+ * \brief Maps metric score to MOS scale of fused models [3, formulae 4, 5].
+ *
+ * \returns  >=0   - mapped score
+ *            -9   - invalid metric score
+ *            -10  - invalid metric type
+ */
+double metric_scale(int metric, double value)
+{
+	if (metric < 0 || metric >= n_metric_types) return -10;
+	if (value < metric_ranges[metric][0] || value > metric_ranges[metric][1]) return -9;
+	return metric_to_q(metric, value);
+}
+
+/*!
+ * \brief Returns range of valid scores of a metric.
+ *
+ * \returns    0   - success
+ *            -6   - NULL pointer
+ *            -10  - invalid metric type
+ */
+int metric_range(int metric, double* p_min, double* p_max)
+{
+	if (metric < 0 || metric >= n_metric_types) return -10;
+	if (p_min == NULL || p_max == NULL) return -6;
+	*p_min = metric_ranges[metric][0];
+	*p_max = metric_ranges[metric][1];
+	return 0;
+}
+
+/*!
+ * \brief Returns display parameters and absolute viewing distance of a device.
+ *
+ * \param[in]  device			device type [device_type]
+ * \param[in]  params			custom device parameters
+ * \param[out] p_display		display parameters
+ * \param[out] p_distance		viewing distance [inches]
+ *
+ * \returns    0				success
+ *			  -5..-7			invalid device (see device_distance())
+ */
+int device_geometry(int device, struct device_params* params, struct device_params* p_display, double* p_distance)
+{
+	struct device_params* p;
+	double distance;
+	int err;
+
+	if (p_display == NULL || p_distance == NULL) return -6;
+	err = device_distance(device, params, &p, &distance);
+	if (err) return err;
+
+	*p_display = *p;
+	*p_distance = distance;
+	return 0;
+}
+
+/*!
+ * \brief Updates 64-bit FNV-1a hash with bytes of a value.
+ *
+ *  Also used for checksums of persisted data (see pmos_cache.c, pmos_stream.c).
+ *
+ * \param[in]  h				current hash (14695981039346656037 - initial value)
+ * \param[in]  p				value
+ * \param[in]  n				size of value in bytes
+ *
+ * \returns 64-bit hash
+ */
+unsigned long long hash_bytes(unsigned long long h, const void* p, size_t n)
+{
+	const unsigned char* b = (const unsigned char*)p;
+	while (n--) h = (h ^ *b++) * 1099511628211ull;
+	return h;
+}
+
+/*!
+ * \brief Returns hash of all model parameters.
+ *
+ *  Covers parameters of WR and fused models, ranges of metrics, and parameters of standard devices,
+ *  so that results computed and persisted by one build (e.g. cached viewing contexts) can be
+ *  recognized as stale by a build with different models.
+ *
+ * \returns 64-bit hash
+ */
+unsigned long long model_hash(void)
+{
+	unsigned long long h = 14695981039346656037ull;
+	const struct device_params* d;
+	int i;
+
+	h = hash_bytes(h, &wr_sdr, sizeof(wr_sdr));
+	h = hash_bytes(h, wr_hdr, sizeof(wr_hdr));
+	h = hash_bytes(h, fusion_models, sizeof(fusion_models));
+	h = hash_bytes(h, metric_ranges, sizeof(metric_ranges));
+	for (i = 0; i < device_custom; i++) {
+		d = &devices[i];	/* field by field, skipping padding */
+		h = hash_bytes(h, &d->display_width, sizeof(int));
+		h = hash_bytes(h, &d->display_height, sizeof(int));
+		h = hash_bytes(h, &d->ppi_x, sizeof(double));
+		h = hash_bytes(h, &d->ppi_y, sizeof(double));
+		h = hash_bytes(h, &d->distance_type, sizeof(int));
+		h = hash_bytes(h, &d->distance, sizeof(double));
+	}
+	return h;
+}
+
+/*!
+ * \brief Enables or disables reproducible mode.
+ *
+ *  In reproducible mode, elementary functions (exp, log, pow, atan) used by all models and geometry
+ *  functions are computed by platform-independent code (see pmos_repro.c) instead of the C library,
+ *  so that the same inputs produce bit-identical MOS on all platforms, and (since each score is
+ *  computed independently) in scalar, batch and multithreaded paths. Results differ from the
+ *  default mode by a few ulps. The mode is global, and should be set before scoring starts.
+ *
+ * \param[in]  on			1 - reproducible mode, 0 - default mode (C library functions)
+ */
+void set_reproducible_mode(int on)
+{
+	reproducible = on != 0;
+}
+
+/*!
+ * \brief Returns 1 if reproducible mode is enabled, 0 otherwise.
+ */
+int reproducible_mode(void)
+{
+	return reproducible;
+}
+
+/****************************
+ *
+ * Resolution saturation:
+ *
+ *   saturation_width()  - finds video width above which WR quality gain on a given device and player is below threshold
+ *   saturation_table()  - tabulates saturation widths for standard and custom devices
+ *
+ ***/
+
+/*!
+ * \brief Finds video width above which WR quality gain on a given device and player is below threshold.
+ *
+ *  WR score is a non-decreasing function of video width, reaching its maximum when video width matches
+ *  player width (see angular_resolution()). This function finds the smallest video width at which WR score
+ *  is within epsilon from this maximum, using bisection over integer widths.
+ *
+ * \param[in]  player_width	player video width [pixels]
+ * \param[in]  player_height	player video height [pixels]
+ * \param[in]	hdr				indicator if video is hdr (1) or sdr (0)
+ * \param[in]	upsampling		assumed upsampling method (see enum upsampling_methods)
+ * \param[in]  device			device type [device_type]
+ * \param[in]  params			custom device parameters
+ * \param[in]  epsilon			threshold of quality gain [MOS units]
+ * \param[out] p_width			saturation width [pixels]
+ * \param[out] p_height		video height at saturation width (preserving aspect ratio of the player) [pixels]
+ *
+ * \returns    0				success
+ *			  -2..-8			invalid viewing setup (see device_to_viewing_params())
+ *			  -9				invalid threshold
+ */
+int saturation_width(int player_width, int player_height, int hdr, int upsampling, int device, struct device_params* params, double epsilon, int* p_width, int* p_height)
+{
+	struct device_params* p;
+	double distance, phi, u, q_max;
+	int lo, hi, w, err;
+
+	/* check parameters */
+	if (player_width < 1 || player_width > 8192) return -2;
+	if (player_height < 1 || player_height > 8192) return -2;
+	if (hdr < 0 || hdr > 1) return -3;
+	if (upsampling < 0 || upsampling >= n_upsampling_methods) return -4;
+	if (p_width == NULL || p_height == NULL) return -6;
+	if (!(epsilon > 0)) return -9;
+	err = device_distance(device, params, &p, &distance);
+	if (err) return err;
+
+	/* maximum WR score - at video width = player width: */
+	phi = viewing_angle(player_width, distance, p->ppi_x);
+	u = angular_resolution(player_width, player_width, distance, p->ppi_x);
+	if (phi < 1 || phi > 180) return -8;
+	if (u < 1 || u > 200) return -8;
+	q_max = wr_model(phi, u, hdr, upsampling);
+
+	/* bisection: WR gain at width lo is >= epsilon, at width hi it is < epsilon: */
+	lo = 0; hi = player_width;
+	while (hi - lo > 1) {
+		w = (lo + hi) >> 1;
+		u = angular_resolution(w, player_width, distance, p->ppi_x);
+		if (q_max - wr_model(phi, u, hdr, upsampling) < epsilon) hi = w; else lo = w;
+	}
+
+	/* store the results: */
+	*p_width = hi;
+	*p_height = max(1, (int)((double)hi * player_height / player_width + 0.5));
+	return 0;
+}
+
+/*!
+ * \brief Tabulates saturation widths for standard and custom devices.
+ *
+ *  For each device (standard devices, followed by devices from custom catalog) and each player scale,
+ *  the table lists saturation widths for SDR video, and for HDR video with each upsampling method.
+ *
+ * \param[in]  catalog			custom device parameters (may be NULL)
+ * \param[in]  n_catalog		number of custom devices
+ * \param[in]  player_scales	player sizes relative to display sizes (NULL - full screen players only)
+ * \param[in]  n_scales		number of player scales
+ * \param[in]  epsilon			threshold of quality gain [MOS units]
+ * \param[out] table			saturation table
+ * \param[in]  max_entries		size of saturation table
+ *
+ * \returns   >=0				number of entries in the table
+ *			  -6				NULL pointer
+ *			  -12				table is too small
+ */
+int saturation_table(struct device_params* catalog, int n_catalog, const double* player_scales, int n_scales, double epsilon, struct saturation_entry* table, int max_entries)
+{
+	static double full_screen = 1.0;
+	struct saturation_entry* e;
+	struct device_params* p;
+	int d, k, i, n = 0;
+
+	/* check parameters */
+	if (table == NULL || (catalog == NULL && n_catalog > 0)) return -6;
+	if (player_scales == NULL) { player_scales = &full_screen; n_scales = 1; }
+	if ((device_custom + n_catalog) * n_scales * (1 + n_upsampling_methods) > max_entries) return -12;
+
+	for (d = 0; d < device_custom + n_catalog; d++) {
+		p = d < device_custom ? &devices[d] : &catalog[d - device_custom];
+		for (k = 0; k < n_scales; k++) {
+			/* SDR, followed by HDR with each upsampling method: */
+			for (i = 0; i <= n_upsampling_methods; i++) {
+				e = &table[n++];
+				e->device = d < device_custom ? d : device_custom;
+				e->catalog_index = d < device_custom ? -1 : d - device_custom;
+				e->player_width = max(1, (int)(p->display_width * player_scales[k] + 0.5));
+				e->player_height = max(1, (int)(p->display_height * player_scales[k] + 0.5));
+				e->hdr = i > 0;
+				e->upsampling = i > 0 ? i - 1 : upsampling_bicubic;
+				e->width = e->height = 0;
+				e->status = saturation_width(e->player_width, e->player_height, e->hdr, e->upsampling, e->device, p, epsilon, &e->width, &e->height);
+			}
+		}
+	}
+
+	return n;
+}
+
 /* pmos.c -- end of file */
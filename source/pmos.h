@@ -11,6 +11,7 @@
 
 #ifndef _PMOS_H_
 #define _PMOS_H_ 1
+#include <stddef.h>
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -43,12 +44,90 @@ enum upsampling_methods {
 	n_upsampling_methods		/* the number of upsampling methods defined by this enum */
 };
 
+/*! Metric types: */
+enum metric_types {
+	metric_psnr = 0,		/* PSNR [dB] */
+	metric_ssim,			/* SSIM */
+	metric_vif,			/* VIF */
+	metric_vmaf,			/* VMAF */
+	n_metric_types			/* the number of metric types defined by this enum */
+};
+
+/*! Parameters of generalized WR model: */
+struct wr_params {
+	double alpha, beta;		/* scale of WR score */
+	double gamma, delta;		/* exponents of viewing angle and angular resolution terms */
+	double k, l;			/* shape parameters of viewing angle and angular resolution terms */
+	double phi_s, u_s;		/* viewing angle [degrees] and angular resolution [cpd] at half-saturation */
+};
+
+/*! Parameters of fused (WR+metric) models: */
+struct fusion_params {
+	double alpha, beta, gamma, delta;	/* fusion coefficients */
+	double epsilon, zeta;			/* slope and center of logistic metric mapping (not used for VMAF) */
+};
+
+/*! Viewing setup - device and player parameters (independent of encoded video resolution): */
+struct viewing_setup {
+	int device;			/* device type (see enum device_types) */
+	struct device_params* params;	/* custom device parameters (for device_custom) */
+	int player_width;		/* player width [pixels] */
+	int player_height;		/* player height [pixels] */
+	int hdr;			/* indicator if video is hdr (1) or sdr (0) */
+	int upsampling;			/* assumed upsampling method (see enum upsampling_methods) */
+};
+
+/*! Viewing context - validated viewing setup with cached angular parameters and WR score: */
+struct viewing_context {
+	double phi;			/* effective viewing angle [degrees] */
+	double u;			/* effective angular resolution [cycles per degree] */
+	int hdr;			/* indicator if video is hdr (1) or sdr (0) */
+	int upsampling;			/* assumed upsampling method (see enum upsampling_methods) */
+	double qwr;			/* WR quality score for this setup */
+};
+
+/*! Saturation table entry: */
+struct saturation_entry {
+	int device;			/* device type (see enum device_types) */
+	int catalog_index;		/* index of custom device in the catalog, -1 - standard device */
+	int player_width;		/* player width [pixels] */
+	int player_height;		/* player height [pixels] */
+	int hdr;			/* indicator if video is hdr (1) or sdr (0) */
+	int upsampling;			/* assumed upsampling method (see enum upsampling_methods) */
+	int width;			/* saturation width [pixels] */
+	int height;			/* video height at saturation width [pixels] */
+	int status;			/* 0 - success, <0 - error (see saturation_width()) */
+};
+
 /*! Function prototypes: */
+double viewing_angle(int player_width, double distance, double ppi_x);
+double angular_resolution(int video_width, int player_width, double distance, double ppi_x);
+int device_to_viewing_params(int width, int height, int player_width, int player_height, int hdr, int upsampling, int device, struct device_params* params, double* p_phi, double* p_u);
+
 double psnr2mos(double psnr, int width, int height, int player_width, int player_height, int hdr, int upsampling, int device, struct device_params* params);
 double ssim2mos(double ssim, int width, int height, int player_width, int player_height, int hdr, int upsampling, int device, struct device_params* params);
 double vif2mos(double vif, int width, int height, int player_width, int player_height, int hdr, int upsampling, int device, struct device_params* params);
 double vmaf2mos(double vmaf, int width, int height, int player_width, int player_height, int hdr, int upsampling, int device, struct device_params* params);
 
+int viewing_context_init(struct viewing_context* ctx, int width, int height, int player_width, int player_height, int hdr, int upsampling, int device, struct device_params* params);
+double metric2mos(const struct viewing_context* ctx, int metric, double value);
+int metric2mos_batch(const struct viewing_context* ctx, int metric, const double* values, double* mos, int n);
+double mos2metric(const struct viewing_context* ctx, int metric, double mos);
+
+const struct wr_params* wr_model_params(int hdr, int upsampling);
+const struct fusion_params* fusion_model_params(int metric);
+double wr_score(double phi, double u, int hdr, int upsampling);
+double metric_scale(int metric, double value);
+int metric_range(int metric, double* p_min, double* p_max);
+int device_geometry(int device, struct device_params* params, struct device_params* p_display, double* p_distance);
+unsigned long long model_hash(void);
+unsigned long long hash_bytes(unsigned long long h, const void* p, size_t n);
+void set_reproducible_mode(int on);
+int reproducible_mode(void);
+
+int saturation_width(int player_width, int player_height, int hdr, int upsampling, int device, struct device_params* params, double epsilon, int* p_width, int* p_height);
+int saturation_table(struct device_params* catalog, int n_catalog, const double* player_scales, int n_scales, double epsilon, struct saturation_entry* table, int max_entries);
+
 #ifdef __cplusplus
 }
 #endif
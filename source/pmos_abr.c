@@ -0,0 +1,150 @@
+/*!
+ *  \file  pmos_abr.c
+ *  \brief Player-side ABR decision engine maximizing device-specific MOS.
+ *
+ *  For a given ladder and viewing setup (device, player size), MOS of each rendition is predicted once,
+ *  and renditions are sorted by bitrates, with running best (highest MOS) rendition stored for each prefix.
+ *  The best rendition under a given bandwidth is then found by binary search over bitrates, without any
+ *  model evaluation per decision. MOS values are recomputed only when player size changes.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#include <stddef.h>
+#include "pmos.h"
+#include "pmos_abr.h"
+
+/*!
+ *  \brief Predicts MOS of all renditions, and rebuilds best-rendition table.
+ */
+static void abr_update(struct abr_engine* e)
+{
+	const struct viewing_setup* vs = &e->setup;
+	const struct abr_rendition* r;
+	struct viewing_context ctx;
+	double mos;
+	int i, err;
+
+	/* predict MOS of each rendition: */
+	for (i = 0; i < e->n; i++) {
+		r = &e->renditions[i];
+		err = viewing_context_init(&ctx, r->width, r->height, vs->player_width, vs->player_height, vs->hdr, vs->upsampling, vs->device, vs->params);
+		e->mos[i] = err ? err : metric2mos(&ctx, r->metric, r->score);
+	}
+
+	/* best rendition within each prefix of bitrate-ordered list (lower bitrates win ties): */
+	for (i = 0; i < e->n; i++) {
+		mos = e->mos[e->order[i]];
+		e->best[i] = e->order[i];
+		if (i > 0 && e->mos[e->best[i - 1]] >= mos)
+			e->best[i] = e->best[i - 1];
+	}
+}
+
+/*!
+ * \brief Initializes ABR engine for a given ladder and viewing setup.
+ *
+ * \param[out] e				ABR engine
+ * \param[in]  setup			viewing setup (device and player parameters)
+ * \param[in]  renditions		renditions in the ladder
+ * \param[in]  n				number of renditions (<= ABR_MAX_RENDITIONS)
+ *
+ * \returns    0				success
+ *			  -6				NULL pointer
+ *			  -12				invalid number of renditions
+ *			  -13				invalid rendition bitrate
+ */
+int abr_init(struct abr_engine* e, const struct viewing_setup* setup, const struct abr_rendition* renditions, int n)
+{
+	int i, j;
+
+	/* check parameters */
+	if (e == NULL || setup == NULL || renditions == NULL) return -6;
+	if (n < 1 || n > ABR_MAX_RENDITIONS) return -12;
+
+	e->setup = *setup;
+	e->n = n;
+
+	/* sort renditions by bitrates: */
+	for (i = 0; i < n; i++) {
+		if (!(renditions[i].bitrate > 0)) return -13;
+		e->renditions[i] = renditions[i];
+		for (j = i; j > 0 && e->bitrate[j - 1] > renditions[i].bitrate; j--) {
+			e->bitrate[j] = e->bitrate[j - 1];
+			e->order[j] = e->order[j - 1];
+		}
+		e->bitrate[j] = renditions[i].bitrate;
+		e->order[j] = i;
+	}
+
+	abr_update(e);
+	return 0;
+}
+
+/*!
+ * \brief Updates ABR engine after change of player size.
+ *
+ * \param[in,out] e			ABR engine
+ * \param[in]     player_width		new player width [pixels]
+ * \param[in]     player_height	new player height [pixels]
+ *
+ * \returns    0				success
+ *			  -6				NULL pointer
+ *			  <0				no rendition can be viewed in a player of this size (see viewing_context_init()); the engine is not changed
+ */
+int abr_resize(struct abr_engine* e, int player_width, int player_height)
+{
+	const struct viewing_setup* vs;
+	const struct abr_rendition* r;
+	struct viewing_context ctx;
+	int i, err = 0;
+
+	if (e == NULL) return -6;
+	vs = &e->setup;
+
+	/* recompute MOS only if player size has changed, and is valid for at least one rendition: */
+	if (vs->player_width != player_width || vs->player_height != player_height) {
+		for (i = 0; i < e->n; i++) {
+			r = &e->renditions[i];
+			if ((err = viewing_context_init(&ctx, r->width, r->height, player_width, player_height, vs->hdr, vs->upsampling, vs->device, vs->params)) == 0) break;
+		}
+		if (err) return err;
+		e->setup.player_width = player_width;
+		e->setup.player_height = player_height;
+		abr_update(e);
+	}
+	return 0;
+}
+
+/*!
+ * \brief Selects rendition with the highest MOS among renditions with bitrates not exceeding given bandwidth.
+ *
+ *  If no rendition fits, the rendition with the lowest bitrate is selected.
+ *
+ * \param[in]  e				ABR engine
+ * \param[in]  bandwidth		available bandwidth [bits/s]
+ *
+ * \returns   >=0				index of selected rendition
+ *			  -6				NULL pointer
+ */
+int abr_select(const struct abr_engine* e, double bandwidth)
+{
+	int lo = 0, hi, k;
+
+	if (e == NULL) return -6;
+
+	/* find the last rendition with bitrate <= bandwidth: */
+	hi = e->n;
+	while (lo < hi) {
+		k = (lo + hi) >> 1;
+		if (e->bitrate[k] <= bandwidth) lo = k + 1; else hi = k;
+	}
+
+	return lo ? e->best[lo - 1] : e->order[0];
+}
+
+/* pmos_abr.c -- end of file */
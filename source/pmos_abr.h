@@ -0,0 +1,49 @@
+/*!
+ *  \file  pmos_abr.h
+ *  \brief Player-side ABR decision engine maximizing device-specific MOS.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _PMOS_ABR_H_
+#define _PMOS_ABR_H_ 1
+#include "pmos.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ABR_MAX_RENDITIONS  32	/* max number of renditions in a ladder */
+
+/*! Rendition, as described in a manifest: */
+struct abr_rendition {
+	double bitrate;			/* bitrate [bits/s] */
+	int width;			/* video width [pixels] */
+	int height;			/* video height [pixels] */
+	int metric;			/* metric type (see enum metric_types) */
+	double score;			/* metric score */
+};
+
+/*! ABR engine - per-rendition MOS precomputed for current viewing setup: */
+struct abr_engine {
+	struct viewing_setup setup;				/* current viewing setup */
+	int n;							/* number of renditions */
+	struct abr_rendition renditions[ABR_MAX_RENDITIONS];	/* renditions, as given */
+	double mos[ABR_MAX_RENDITIONS];				/* predicted MOS of each rendition, <0 - error */
+	int order[ABR_MAX_RENDITIONS];				/* renditions in the order of increasing bitrates */
+	double bitrate[ABR_MAX_RENDITIONS];			/* bitrates in the same order */
+	int best[ABR_MAX_RENDITIONS];				/* best rendition among order[0..k] */
+};
+
+/*! Function prototypes: */
+int abr_init(struct abr_engine* e, const struct viewing_setup* setup, const struct abr_rendition* renditions, int n);
+int abr_resize(struct abr_engine* e, int player_width, int player_height);
+int abr_select(const struct abr_engine* e, double bandwidth);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
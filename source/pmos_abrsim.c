@@ -0,0 +1,365 @@
+/*!
+ *  \file  pmos_abrsim.c
+ *  \brief Trace-driven ABR simulator with device-specific MOS scoring.
+ *
+ *  Each session streams all segments of the content over a network throughput trace:
+ *
+ *   - renditions are selected by the ABR engine (see pmos_abr.c) using a fraction of the harmonic mean
+ *     of throughputs measured over the last few segment downloads (the lowest rendition is used for the
+ *     first segment);
+ *   - downloads are paused while the buffer is full, playback starts when the buffer reaches startup level,
+ *     and stalls when the buffer runs empty;
+ *   - each downloaded segment is scored by MOS predicted for the viewing setup; segment MOS values are
+ *     computed once, using cached viewing contexts of renditions, and shared by all sessions.
+ *
+ *  Sessions are simulated in parallel.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "pmos.h"
+#include "pmos_abr.h"
+#include "pmos_thread.h"
+#include "pmos_abrsim.h"
+
+#define SIM_THROUGHPUT_HISTORY  5	/* number of downloads used for throughput estimation */
+
+/****************************
+ *
+ * Network traces:
+ *
+ *   sim_trace_load()  - loads trace from a text file
+ *   sim_trace_free()  - releases memory allocated for trace
+ *   download_time()   - computes time needed to download given number of bits
+ *
+ ***/
+
+/*!
+ * \brief Loads network throughput trace from a text file.
+ *
+ *  Each line contains sample time [s] and throughput [Mbit/s] (as in "cooked" traces used by Pensieve
+ *  and similar tools). Empty lines and lines starting with '#' are ignored.
+ *
+ * \param[in]  path			file name
+ * \param[out] trace			trace
+ *
+ * \returns    0				success
+ *			  -6				NULL pointer
+ *			  -13				invalid trace
+ *			  -15				memory allocation failure
+ *			  -16				file cannot be read
+ */
+int sim_trace_load(const char* path, struct sim_trace* trace)
+{
+	char line[256], *s;
+	double t, bw, *p, total = 0;
+	int size = 0, n = 0;
+	FILE* f;
+
+	if (path == NULL || trace == NULL) return -6;
+	trace->n = 0;
+	trace->time = trace->bandwidth = NULL;
+
+	f = fopen(path, "r");
+	if (f == NULL) return -16;
+
+	while (fgets(line, sizeof(line), f)) {
+		for (s = line; *s == ' ' || *s == '\t'; s++);
+		if (*s == '#' || *s == '\n' || *s == '\r' || *s == 0) continue;
+		if (sscanf(s, "%lf %lf", &t, &bw) != 2 || bw < 0 || (n && !(t > trace->time[n - 1]))) {
+			fclose(f);
+			sim_trace_free(trace);
+			return -13;
+		}
+		if (n == size) {
+			size = size ? size * 2 : 1024;
+			p = (double*)realloc(trace->time, size * sizeof(double));
+			if (p) trace->time = p;
+			p = p ? (double*)realloc(trace->bandwidth, size * sizeof(double)) : NULL;
+			if (p) trace->bandwidth = p;
+			if (p == NULL) {
+				fclose(f);
+				sim_trace_free(trace);
+				return -15;
+			}
+		}
+		trace->time[n] = t;
+		trace->bandwidth[n] = bw * 1e6;
+		total += bw;
+		n++;
+		trace->n = n;
+	}
+	fclose(f);
+
+	/* there must be some throughput: */
+	if (n < 1 || !(total > 0)) {
+		sim_trace_free(trace);
+		return -13;
+	}
+	return 0;
+}
+
+/*!
+ * \brief Releases memory allocated for a trace.
+ */
+void sim_trace_free(struct sim_trace* trace)
+{
+	if (trace == NULL) return;
+	free(trace->time);
+	free(trace->bandwidth);
+	trace->time = trace->bandwidth = NULL;
+	trace->n = 0;
+}
+
+/*!
+ * \brief Computes time needed to download given number of bits, starting at given time.
+ */
+static double download_time(const struct sim_trace* tr, double t, double bits)
+{
+	double last, period, tau, end, cap, elapsed = 0;
+	int lo, hi, k, i;
+
+	if (!(bits > 0)) return 0;
+
+	/* duration of the last sample, and period of the trace: */
+	last = tr->n > 1 ? tr->time[tr->n - 1] - tr->time[tr->n - 2] : 1.0;
+	period = tr->time[tr->n - 1] + last - tr->time[0];
+
+	/* position in the trace: */
+	tau = tr->time[0] + fmod(t, period);
+	for (lo = 0, hi = tr->n; hi - lo > 1; ) {
+		k = (lo + hi) >> 1;
+		if (tr->time[k] <= tau) lo = k; else hi = k;
+	}
+
+	/* integrate throughput until all bits are downloaded: */
+	for (i = lo; ; ) {
+		end = i + 1 < tr->n ? tr->time[i + 1] : tr->time[i] + last;
+		cap = tr->bandwidth[i] * (end - tau);
+		if (cap >= bits)
+			return elapsed + bits / tr->bandwidth[i];
+		bits -= cap;
+		elapsed += end - tau;
+		tau = end;
+		if (++i == tr->n) {
+			i = 0;
+			tau = tr->time[0];
+		}
+	}
+}
+
+/*!
+ * \brief Checks that trace has increasing sample times, non-negative throughput, and some throughput in each period.
+ */
+static int trace_valid(const struct sim_trace* tr)
+{
+	double total = 0;
+	int i;
+
+	for (i = 0; i < tr->n; i++) {
+		if (!(tr->bandwidth[i] >= 0 && tr->bandwidth[i] < HUGE_VAL)) return 0;
+		if (i > 0 && !(tr->time[i] > tr->time[i - 1])) return 0;
+		total += tr->bandwidth[i];
+	}
+	return total > 0;
+}
+
+/****************************
+ *
+ * Simulator:
+ *
+ *   sim_init()  - initializes simulator, and predicts MOS of all segments
+ *   sim_run()   - simulates streaming sessions over given traces (in parallel)
+ *   sim_free()  - releases memory allocated by simulator
+ *
+ ***/
+
+/*!
+ * \brief Initializes simulator for given viewing setup, content and player parameters.
+ *
+ * \param[out] sim				simulator
+ * \param[in]  setup			viewing setup (device and player parameters)
+ * \param[in]  content			content (ladder with per-segment sizes and scores)
+ * \param[in]  params			player parameters
+ *
+ * \returns    0				success
+ *			  -6				NULL pointer
+ *			  -12				invalid number of renditions or segments, or invalid player parameters
+ *			  -13				invalid rendition
+ *			  -15				memory allocation failure
+ */
+int sim_init(struct abr_sim* sim, const struct viewing_setup* setup, const struct sim_content* content, const struct sim_params* params)
+{
+	const struct abr_rendition* r;
+	struct viewing_context ctx;
+	double* mos;
+	int i, k, n, err;
+
+	/* check parameters */
+	if (sim == NULL || setup == NULL || content == NULL || params == NULL || content->renditions == NULL) return -6;
+	if (content->n_segments < 1 || !(content->segment_duration > 0)) return -12;
+	if (!(params->safety > 0) || params->startup_buffer < 0 || params->startup_buffer > params->max_buffer || params->max_buffer < content->segment_duration || params->n_threads < 0) return -12;
+
+	sim->mos = NULL;
+	err = abr_init(&sim->abr, setup, content->renditions, content->n_renditions);
+	if (err) return err;
+	sim->content = *content;
+	sim->params = *params;
+
+	/* predict MOS of all segments (using one viewing context per rendition): */
+	n = content->n_segments;
+	if ((size_t)content->n_renditions > (size_t)-1 / sizeof(double) / (size_t)n) return -15;
+	sim->mos = (double*)malloc((size_t)content->n_renditions * n * sizeof(double));
+	if (sim->mos == NULL) return -15;
+	for (i = 0; i < content->n_renditions; i++) {
+		r = &content->renditions[i];
+		err = viewing_context_init(&ctx, r->width, r->height, setup->player_width, setup->player_height, setup->hdr, setup->upsampling, setup->device, setup->params);
+		if (err) break;
+		if (content->scores) {
+			err = metric2mos_batch(&ctx, r->metric, content->scores + (size_t)i * n, sim->mos + (size_t)i * n, n);
+		} else {
+			mos = sim->mos + (size_t)i * n;
+			mos[0] = metric2mos(&ctx, r->metric, r->score);
+			err = mos[0] < 0 ? (int)mos[0] : 0;
+			for (k = 1; k < n; k++) mos[k] = mos[0];
+		}
+		if (err) break;
+	}
+	if (err) {
+		sim_free(sim);
+		return -13;
+	}
+
+	return 0;
+}
+
+/*!
+ * \brief Simulates one streaming session.
+ */
+static void sim_session(const struct abr_sim* sim, const struct sim_trace* tr, struct sim_session* res)
+{
+	const struct sim_content* c = &sim->content;
+	const struct sim_params* p = &sim->params;
+	double hist[SIM_THROUGHPUT_HISTORY], est, size, dt, wait;
+	double t = 0, buffer = 0, quality = 0, bits = 0;
+	int s, r, prev = -1, n_hist = 0, playing = 0, k;
+
+	res->startup_delay = res->stall_time = 0;
+	res->switches = 0;
+	res->status = 0;
+	if (tr == NULL || tr->n < 1 || tr->time == NULL || tr->bandwidth == NULL) {
+		res->status = -6;
+		return;
+	}
+	if (!trace_valid(tr)) {
+		res->status = -13;
+		return;
+	}
+
+	for (s = 0; s < c->n_segments; s++) {
+		/* wait while buffer is full (it only drains during playback; until then, it may exceed max_buffer by less than a segment): */
+		wait = buffer + c->segment_duration - p->max_buffer;
+		if (playing && wait > 0) {
+			t += wait;
+			buffer -= wait;
+		}
+
+		/* select rendition: */
+		if (n_hist == 0)
+			r = sim->abr.order[0];
+		else {
+			for (k = 0, est = 0; k < n_hist; k++) est += 1.0 / hist[k];
+			r = abr_select(&sim->abr, p->safety * n_hist / est);
+		}
+
+		/* download segment: */
+		size = c->sizes ? c->sizes[(size_t)r * c->n_segments + s] : c->renditions[r].bitrate * c->segment_duration;
+		dt = download_time(tr, t, size);
+		t += dt;
+		bits += size;
+		if (!playing)
+			res->startup_delay += dt;
+		else if (dt > buffer) {
+			res->stall_time += dt - buffer;
+			buffer = 0;
+		} else
+			buffer -= dt;
+		buffer += c->segment_duration;
+		if (!playing && buffer >= p->startup_buffer)
+			playing = 1;
+
+		/* update throughput history: */
+		if (dt > 0)
+			hist[n_hist < SIM_THROUGHPUT_HISTORY ? n_hist++ : s % SIM_THROUGHPUT_HISTORY] = size / dt;
+
+		/* score segment: */
+		quality += sim->mos[(size_t)r * c->n_segments + s] * c->segment_duration;
+		if (prev >= 0 && r != prev)
+			res->switches++;
+		prev = r;
+	}
+
+	res->mos = quality / (c->n_segments * c->segment_duration);
+	res->bitrate = bits / (c->n_segments * c->segment_duration);
+}
+
+/*! Simulation job: */
+struct sim_job {
+	const struct abr_sim* sim;
+	const struct sim_trace* traces;
+	struct sim_session* sessions;
+};
+
+/*!
+ * \brief Simulates sessions [begin, end).
+ */
+static void sim_sessions(void* arg, int begin, int end)
+{
+	struct sim_job* job = (struct sim_job*)arg;
+	int i;
+
+	for (i = begin; i < end; i++)
+		sim_session(job->sim, &job->traces[i], &job->sessions[i]);
+}
+
+/*!
+ * \brief Simulates streaming sessions over given traces (in parallel).
+ *
+ * \param[in]  sim				simulator (see sim_init())
+ * \param[in]  traces			network throughput traces
+ * \param[in]  n_traces		number of traces
+ * \param[out] sessions		per-session results [n_traces]
+ *
+ * \returns    0				success (per-session errors are reported in sessions)
+ *			  -6				NULL pointer
+ */
+int sim_run(const struct abr_sim* sim, const struct sim_trace* traces, int n_traces, struct sim_session* sessions)
+{
+	struct sim_job job;
+
+	if (sim == NULL || sim->mos == NULL || traces == NULL || sessions == NULL) return -6;
+
+	job.sim = sim;
+	job.traces = traces;
+	job.sessions = sessions;
+	return parallel_for(n_traces, sim->params.n_threads, sim_sessions, &job);
+}
+
+/*!
+ * \brief Releases memory allocated by simulator.
+ */
+void sim_free(struct abr_sim* sim)
+{
+	if (sim == NULL) return;
+	free(sim->mos);
+	sim->mos = NULL;
+}
+
+/* pmos_abrsim.c -- end of file */
@@ -0,0 +1,73 @@
+/*!
+ *  \file  pmos_abrsim.h
+ *  \brief Trace-driven ABR simulator with device-specific MOS scoring.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _PMOS_ABRSIM_H_
+#define _PMOS_ABRSIM_H_ 1
+#include "pmos.h"
+#include "pmos_abr.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! Network throughput trace (piecewise-constant, repeated when exhausted): */
+struct sim_trace {
+	int n;				/* number of samples */
+	double* time;			/* sample times [s], increasing */
+	double* bandwidth;		/* throughput from this sample time to the next one [bits/s] */
+};
+
+/*! Content - ladder with per-segment sizes and metric scores: */
+struct sim_content {
+	int n_renditions;			/* number of renditions */
+	const struct abr_rendition* renditions;	/* renditions (nominal bitrates, resolutions and metric scores) */
+	int n_segments;				/* number of segments */
+	double segment_duration;		/* segment duration [s] */
+	const double* sizes;			/* segment sizes [bits], [n_renditions x n_segments] (NULL - nominal bitrates) */
+	const double* scores;			/* segment metric scores, [n_renditions x n_segments] (NULL - rendition scores) */
+};
+
+/*! Player parameters: */
+struct sim_params {
+	double startup_buffer;		/* buffer level to start playback [s] */
+	double max_buffer;		/* maximum buffer level [s] */
+	double safety;			/* fraction of estimated throughput used for rendition selection */
+	int n_threads;			/* number of threads (0 - all cores) */
+};
+
+/*! Simulator: */
+struct abr_sim {
+	struct abr_engine abr;		/* ABR engine (selects renditions) */
+	struct sim_content content;	/* content */
+	struct sim_params params;	/* player parameters */
+	double* mos;			/* predicted MOS of each segment, [n_renditions x n_segments] */
+};
+
+/*! Per-session simulation results: */
+struct sim_session {
+	int status;			/* 0 - success, -6 - NULL trace data, -13 - invalid trace (no throughput) */
+	double mos;			/* time-weighted average MOS of played segments */
+	double startup_delay;		/* time to start playback [s] */
+	double stall_time;		/* total rebuffering time after startup [s] */
+	int switches;			/* number of rendition switches */
+	double bitrate;			/* average bitrate of downloaded segments [bits/s] */
+};
+
+/*! Function prototypes: */
+int sim_trace_load(const char* path, struct sim_trace* trace);
+void sim_trace_free(struct sim_trace* trace);
+int sim_init(struct abr_sim* sim, const struct viewing_setup* setup, const struct sim_content* content, const struct sim_params* params);
+int sim_run(const struct abr_sim* sim, const struct sim_trace* traces, int n_traces, struct sim_session* sessions);
+void sim_free(struct abr_sim* sim);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
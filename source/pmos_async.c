@@ -0,0 +1,337 @@
+/*!
+ *  \file  pmos_async.c
+ *  \brief Asynchronous scoring with submission and completion rings.
+ *
+ *  Event-driven servers submit scoring jobs (scores with per-row geometry, or with a viewing context
+ *  for all rows) to a submission ring without blocking, and reap completions from a completion ring.
+ *  Jobs are split into chunks of up to ASYNC_CHUNK_ROWS rows, which are scored by a pool of worker
+ *  threads (with score_batch() or metric2mos_batch()), in order of submission, so that large jobs
+ *  are scored by all workers. Jobs complete when all their chunks are scored, possibly out of order.
+ *
+ *  Completions are signalled through a file descriptor (see async_fd()): an eventfd on Linux, and a
+ *  pipe on other POSIX systems. It becomes readable when completions are available, so it can be
+ *  added to epoll/kqueue/poll sets of an event loop, and is reset by async_reap(). On Windows, there
+ *  is no descriptor, and completions are polled with async_reap() or awaited with async_wait().
+ *
+ *  Rings have the same capacity, and a submission is rejected (-11) when the job would not fit in
+ *  the completion ring, so completions are never lost: callers should reap completions, and retry.
+ *  Buffers of a job (scores, geometry columns, output, context) must stay valid until its completion.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pmos.h"
+#include "pmos_batch.h"
+#include "pmos_thread.h"
+#include "pmos_async.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+#endif
+
+/*!
+ * \brief Scores a chunk of rows of a job.
+ *
+ * \returns 0 - success, <0 - error code of the first failed row of the chunk
+ */
+static int async_chunk(const struct async_submission* job, int chunk)
+{
+	struct score_batch b = job->batch;
+	struct batch_column* columns[7];
+	int begin = chunk * ASYNC_CHUNK_ROWS, n, i, err = 0;
+	double mos;
+
+	n = b.n - begin < ASYNC_CHUNK_ROWS ? b.n - begin : ASYNC_CHUNK_ROWS;
+	b.values += (ptrdiff_t)begin * b.values_stride;
+
+	/* same context for all rows: */
+	if (job->ctx != NULL) {
+		if (b.values_stride == 1)
+			return metric2mos_batch(job->ctx, job->metric, b.values, job->mos + begin, n);
+		for (i = 0; i < n; i++) {
+			mos = metric2mos(job->ctx, job->metric, b.values[(ptrdiff_t)i * b.values_stride]);
+			job->mos[begin + i] = mos;
+			if (mos < 0 && !err) err = (int)mos;
+		}
+		return err;
+	}
+
+	/* per-row geometry: */
+	columns[0] = &b.width;
+	columns[1] = &b.height;
+	columns[2] = &b.player_width;
+	columns[3] = &b.player_height;
+	columns[4] = &b.hdr;
+	columns[5] = &b.upsampling;
+	columns[6] = &b.device;
+	for (i = 0; i < 7; i++)
+		columns[i]->data += (ptrdiff_t)begin * columns[i]->stride;
+	b.n = n;
+	return score_batch(job->metric, &b, job->mos + begin, 1);
+}
+
+/*!
+ * \brief Posts completion of a job, and signals it (called with the lock held).
+ */
+static void async_complete(struct async_queue* q, struct async_slot* slot)
+{
+	struct async_completion* c = &q->cq[q->cq_tail & (q->depth - 1)];
+#ifndef _WIN32
+	unsigned long long one = 1;
+	ssize_t written;
+#endif
+
+	c->user_data = slot->job.user_data;
+	c->status = slot->status;
+	q->cq_tail++;
+	slot->busy = 0;
+	parallel_signal_wake(&q->done);
+#ifndef _WIN32
+	if (q->fd[1] >= 0) {
+		written = write(q->fd[1], &one, q->fd[0] == q->fd[1] ? sizeof(one) : 1);	/* a full pipe is readable anyway */
+		(void)written;
+	}
+#endif
+}
+
+/*!
+ * \brief Worker thread: scores chunks of submitted jobs until the queue is stopped and drained.
+ */
+static void async_worker(void* arg)
+{
+	struct async_queue* q = (struct async_queue*)arg;
+	struct async_slot* slot;
+	int chunk, err;
+
+	parallel_lock_acquire(&q->lock);
+	for (;;) {
+		while (q->dispatched == q->sq_tail && !q->stop)
+			parallel_signal_wait(&q->work, &q->lock);
+		if (q->dispatched == q->sq_tail) break;
+
+		/* take the next chunk: */
+		slot = &q->sq[q->dispatched & (q->depth - 1)];
+		chunk = q->next_chunk++;
+		if (q->next_chunk == slot->n_chunks) {
+			q->dispatched++;
+			q->next_chunk = 0;
+		}
+
+		parallel_lock_release(&q->lock);
+		err = async_chunk(&slot->job, chunk);
+		parallel_lock_acquire(&q->lock);
+
+		if (err && chunk < slot->error_chunk) {
+			slot->error_chunk = chunk;
+			slot->status = err;
+		}
+		if (--slot->remaining == 0) async_complete(q, slot);
+	}
+	parallel_lock_release(&q->lock);
+}
+
+/*!
+ * \brief Initializes a queue, and starts its workers.
+ *
+ * \param[out] q				queue
+ * \param[in]  depth			capacity of submission and completion rings (power of 2)
+ * \param[in]  n_workers		number of worker threads (0 - use all cores)
+ *
+ * \returns    0				success
+ *			  -6				invalid parameters
+ *			  -14				completion descriptor could not be created
+ *			  -15				out of memory, or threads could not be started
+ */
+int async_queue_init(struct async_queue* q, int depth, int n_workers)
+{
+	int i;
+
+	if (q == NULL || depth < 1 || depth > (1 << 20) || (depth & (depth - 1)) || n_workers < 0) return -6;
+	memset(q, 0, sizeof(*q));
+	q->fd[0] = q->fd[1] = -1;
+	q->depth = depth;
+	q->sq = (struct async_slot*)calloc((size_t)depth, sizeof(struct async_slot));
+	q->cq = (struct async_completion*)calloc((size_t)depth, sizeof(struct async_completion));
+	if (q->sq == NULL || q->cq == NULL || parallel_lock_init(&q->lock) || parallel_signal_init(&q->work) || parallel_signal_init(&q->done)) {
+		async_queue_free(q);
+		return -15;
+	}
+
+	/* completion descriptor: */
+#ifdef __linux__
+	q->fd[0] = q->fd[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#elif !defined(_WIN32)
+	if (pipe(q->fd) == 0) {
+		for (i = 0; i < 2; i++) {
+			fcntl(q->fd[i], F_SETFL, O_NONBLOCK);
+			fcntl(q->fd[i], F_SETFD, FD_CLOEXEC);
+		}
+	} else
+		q->fd[0] = q->fd[1] = -1;
+#endif
+#ifndef _WIN32
+	if (q->fd[0] < 0) { async_queue_free(q); return -14; }
+#endif
+
+	/* workers: */
+	if (n_workers == 0) n_workers = cpu_count();
+	if (n_workers > PMOS_MAX_THREADS) n_workers = PMOS_MAX_THREADS;
+	for (i = 0; i < n_workers; i++)
+		if (parallel_thread_start(&q->workers[i], async_worker, q)) break;
+	q->n_workers = i;
+	if (q->n_workers == 0) { async_queue_free(q); return -15; }
+	return 0;
+}
+
+/*!
+ * \brief Stops workers (after all submitted jobs are scored), and releases resources of a queue.
+ */
+void async_queue_free(struct async_queue* q)
+{
+	int i;
+
+	if (q == NULL) return;
+	if (q->n_workers) {
+		parallel_lock_acquire(&q->lock);
+		q->stop = 1;
+		parallel_signal_wake(&q->work);
+		parallel_lock_release(&q->lock);
+		for (i = 0; i < q->n_workers; i++)
+			parallel_thread_join(&q->workers[i]);
+		q->n_workers = 0;
+	}
+#ifndef _WIN32
+	if (q->fd[1] >= 0 && q->fd[1] != q->fd[0]) close(q->fd[1]);
+	if (q->fd[0] >= 0) close(q->fd[0]);
+#endif
+	q->fd[0] = q->fd[1] = -1;
+	parallel_signal_free(&q->done);
+	parallel_signal_free(&q->work);
+	parallel_lock_free(&q->lock);
+	free(q->sq);
+	free(q->cq);
+	q->sq = NULL;
+	q->cq = NULL;
+}
+
+/*!
+ * \brief Returns descriptor that becomes readable when completions are available (-1 - none, on Windows).
+ */
+int async_fd(const struct async_queue* q)
+{
+	return q != NULL ? q->fd[0] : -1;
+}
+
+/*!
+ * \brief Submits a job (without blocking).
+ *
+ * \param[in]  q				queue
+ * \param[in]  s				job (copied; its buffers must stay valid until completion)
+ *
+ * \returns    0				success
+ *			  -6				NULL pointer or invalid number of rows
+ *			  -10				invalid metric type
+ *			  -11				rings are full (reap completions, and retry)
+ */
+int async_submit(struct async_queue* q, const struct async_submission* s)
+{
+	const struct score_batch* b;
+	struct async_slot* slot;
+
+	if (q == NULL || s == NULL || s->mos == NULL || s->batch.values == NULL || s->batch.n < 0) return -6;
+	b = &s->batch;
+	if (s->ctx == NULL && (b->width.data == NULL || b->height.data == NULL || b->player_width.data == NULL || b->player_height.data == NULL
+		|| b->hdr.data == NULL || b->upsampling.data == NULL || b->device.data == NULL)) return -6;
+	if (s->metric < 0 || s->metric >= n_metric_types) return -10;
+
+	parallel_lock_acquire(&q->lock);
+	slot = &q->sq[q->sq_tail & (q->depth - 1)];
+	if (slot->busy || q->sq_tail - q->cq_head >= (unsigned int)q->depth) {
+		parallel_lock_release(&q->lock);
+		return -11;
+	}
+	slot->job = *s;
+	slot->n_chunks = b->n > 0 ? (b->n + ASYNC_CHUNK_ROWS - 1) / ASYNC_CHUNK_ROWS : 1;
+	slot->remaining = slot->n_chunks;
+	slot->error_chunk = slot->n_chunks;
+	slot->status = 0;
+	slot->busy = 1;
+	q->sq_tail++;
+	parallel_signal_wake(&q->work);
+	parallel_lock_release(&q->lock);
+	return 0;
+}
+
+/*!
+ * \brief Reaps available completions (without blocking), and resets the completion descriptor.
+ *
+ * \param[in]  q				queue
+ * \param[out] c				completions
+ * \param[in]  max			max number of completions to reap
+ *
+ * \returns   >=0				number of reaped completions
+ *			  -6				invalid parameters
+ */
+int async_reap(struct async_queue* q, struct async_completion* c, int max)
+{
+	int n;
+#ifndef _WIN32
+	unsigned char buffer[64];
+	unsigned long long one = 1;
+	ssize_t done;
+#endif
+
+	if (q == NULL || c == NULL || max < 0) return -6;
+
+#ifndef _WIN32
+	/* reset descriptor before taking completions, so that later ones signal it again: */
+	while (read(q->fd[0], buffer, q->fd[0] == q->fd[1] ? sizeof(one) : sizeof(buffer)) > 0 && q->fd[0] != q->fd[1]);
+#endif
+
+	parallel_lock_acquire(&q->lock);
+	for (n = 0; n < max && q->cq_head != q->cq_tail; n++)
+		c[n] = q->cq[q->cq_head++ & (q->depth - 1)];
+#ifndef _WIN32
+	/* completions left in the ring keep the descriptor readable: */
+	if (q->cq_head != q->cq_tail) {
+		done = write(q->fd[1], &one, q->fd[0] == q->fd[1] ? sizeof(one) : 1);
+		(void)done;
+	}
+#endif
+	parallel_lock_release(&q->lock);
+	return n;
+}
+
+/*!
+ * \brief Waits until completions are available (or no jobs are in flight), and reaps them.
+ *
+ * \returns   >=0				number of reaped completions (0 - no jobs in flight)
+ *			  -6				invalid parameters
+ */
+int async_wait(struct async_queue* q, struct async_completion* c, int max)
+{
+	if (q == NULL || c == NULL || max < 0) return -6;
+
+	parallel_lock_acquire(&q->lock);
+	while (q->cq_head == q->cq_tail && q->cq_tail != q->sq_tail)
+		parallel_signal_wait(&q->done, &q->lock);
+	parallel_lock_release(&q->lock);
+	return async_reap(q, c, max);
+}
+
+/* pmos_async.c -- end of file */
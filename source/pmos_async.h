@@ -0,0 +1,77 @@
+/*!
+ *  \file  pmos_async.h
+ *  \brief Asynchronous scoring with submission and completion rings.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _PMOS_ASYNC_H_
+#define _PMOS_ASYNC_H_ 1
+#include "pmos.h"
+#include "pmos_batch.h"
+#include "pmos_thread.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ASYNC_CHUNK_ROWS  16384	/* max number of rows scored by a worker at once */
+
+/*! Scoring job: */
+struct async_submission {
+	unsigned long long user_data;	/* caller's tag, returned with the completion */
+	int metric;			/* metric type (see enum metric_types) */
+	struct score_batch batch;	/* rows (scores, and geometry if ctx is NULL) */
+	const struct viewing_context* ctx;	/* viewing context of all rows (NULL - use geometry of rows) */
+	double* mos;			/* MOS scores (batch.n values) */
+};
+
+/*! Completed job: */
+struct async_completion {
+	unsigned long long user_data;	/* tag of the submission */
+	int status;			/* 0 - all rows scored, <0 - error code of the first failed row */
+};
+
+/*! Job in the submission ring: */
+struct async_slot {
+	struct async_submission job;	/* submission */
+	int n_chunks;			/* number of chunks of rows */
+	int remaining;			/* number of chunks not yet scored */
+	int error_chunk;		/* first chunk with an error (n_chunks - none) */
+	int status;			/* error code of that chunk */
+	int busy;			/* 1 - job is not completed yet */
+};
+
+/*! Queue: */
+struct async_queue {
+	int depth;			/* capacity of rings (power of 2) */
+	struct async_slot* sq;		/* submission ring */
+	struct async_completion* cq;	/* completion ring */
+	unsigned int sq_tail;		/* number of submitted jobs */
+	unsigned int dispatched;	/* number of jobs with all chunks taken by workers */
+	int next_chunk;			/* next chunk of the first job not yet dispatched */
+	unsigned int cq_head, cq_tail;	/* number of reaped and completed jobs */
+	int n_workers;			/* number of worker threads */
+	struct parallel_thread workers[PMOS_MAX_THREADS];
+	struct parallel_lock lock;	/* lock of rings */
+	struct parallel_signal work;	/* signalled on submissions and shutdown */
+	struct parallel_signal done;	/* signalled on completions */
+	int stop;			/* 1 - workers exit when rings are drained */
+	int fd[2];			/* eventfd (both), or read and write ends of a pipe; -1 - none */
+};
+
+/*! Function prototypes: */
+int async_queue_init(struct async_queue* q, int depth, int n_workers);
+void async_queue_free(struct async_queue* q);
+int async_fd(const struct async_queue* q);
+int async_submit(struct async_queue* q, const struct async_submission* s);
+int async_reap(struct async_queue* q, struct async_completion* c, int max);
+int async_wait(struct async_queue* q, struct async_completion* c, int max);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
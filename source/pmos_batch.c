@@ -0,0 +1,117 @@
+/*!
+ *  \file  pmos_batch.c
+ *  \brief Scoring of tables of metric scores with per-row viewing geometry.
+ *
+ *  Rows are split into contiguous blocks processed by parallel threads (see parallel_for()). Each
+ *  thread keeps its own cache of viewing contexts (see pmos_cache.h), so repeated geometries cost
+ *  only evaluation of the metric mapping. Caches of all threads can share a persistent cache (see
+ *  geometry_store_open()), so that short-lived processes start warm. Columns are strided, which
+ *  allows scoring of columns of larger records, or of arrays broadcast over rows (stride 0), without
+ *  copying.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include "pmos.h"
+#include "pmos_cache.h"
+#include "pmos_thread.h"
+#include "pmos_batch.h"
+#include "pmos_probes.h"
+
+/*! Scoring job: */
+struct batch_job {
+	int metric;
+	const struct score_batch* batch;
+	double* mos;
+};
+
+/*! Element of a column in a given row: */
+#define column_at(c, i)  ((c).data[(ptrdiff_t)(i) * (c).stride])
+
+/*!
+ * \brief Scores rows [begin, end) of the table.
+ */
+static void batch_rows(void* arg, int begin, int end)
+{
+	struct batch_job* job = (struct batch_job*)arg;
+	const struct score_batch* b = job->batch;
+	const struct viewing_context* ctx;
+	struct geometry_cache* cache;
+	struct geometry_key key;
+	int i, err;
+
+	cache = (struct geometry_cache*)malloc(sizeof(struct geometry_cache));
+	if (cache == NULL) {
+		for (i = begin; i < end; i++) job->mos[i] = -15;
+		return;
+	}
+	geometry_cache_init(cache, b->params);
+	geometry_cache_attach(cache, b->store);
+
+	for (i = begin; i < end; i++) {
+		key.width = column_at(b->width, i);
+		key.height = column_at(b->height, i);
+		key.player_width = column_at(b->player_width, i);
+		key.player_height = column_at(b->player_height, i);
+		key.hdr = column_at(b->hdr, i);
+		key.upsampling = column_at(b->upsampling, i);
+		key.device = column_at(b->device, i);
+		err = geometry_cache_lookup(cache, &key, &ctx);
+		job->mos[i] = err ? err : metric2mos(ctx, job->metric, b->values[(ptrdiff_t)i * b->values_stride]);
+	}
+
+	free(cache);
+}
+
+/*!
+ * \brief Maps metric scores to MOS for all rows of a table.
+ *
+ *  Rows with invalid scores or geometry produce negative error codes (see psnr2mos()) at
+ *  corresponding positions in the output array.
+ *
+ * \param[in]  metric			metric type (see enum metric_types)
+ * \param[in]  batch			table of scores and geometries
+ * \param[out] mos			MOS scores (batch->n values)
+ * \param[in]  n_threads		number of threads (0 - use all cores, 1 - run in the calling thread)
+ *
+ * \returns    0				all rows have been scored successfully
+ *			  <0				error code of the first row that failed
+ */
+int score_batch(int metric, const struct score_batch* batch, double* mos, int n_threads)
+{
+	struct batch_job job;
+	int i, err = 0;
+
+	PMOS_PROBE3(score_batch_entry, metric, batch ? batch->n : 0, n_threads);
+
+	/* check parameters: */
+	if (batch == NULL || mos == NULL || batch->values == NULL
+		|| batch->width.data == NULL || batch->height.data == NULL || batch->player_width.data == NULL || batch->player_height.data == NULL
+		|| batch->hdr.data == NULL || batch->upsampling.data == NULL || batch->device.data == NULL)
+		err = -6;
+	else if (metric < 0 || metric >= n_metric_types)
+		err = -10;
+	else if (batch->n < 0)
+		err = -12;
+	else {
+		job.metric = metric;
+		job.batch = batch;
+		job.mos = mos;
+		if (parallel_for(batch->n, n_threads, batch_rows, &job))
+			err = -12;
+		else
+			for (i = 0; i < batch->n && !err; i++)
+				if (mos[i] < 0) err = (int)mos[i];
+	}
+
+	PMOS_PROBE1(score_batch_return, err);
+	return err;
+}
+
+/* pmos_batch.c -- end of file */
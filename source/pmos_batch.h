@@ -0,0 +1,45 @@
+/*!
+ *  \file  pmos_batch.h
+ *  \brief Scoring of tables of metric scores with per-row viewing geometry.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _PMOS_BATCH_H_
+#define _PMOS_BATCH_H_ 1
+#include "pmos.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! Column of integer geometry parameters (stride 0 - same value in all rows): */
+struct batch_column {
+	const int* data;		/* first element */
+	int stride;			/* distance between elements of consecutive rows [elements] */
+};
+
+/*! Table of metric scores and viewing geometries: */
+struct score_batch {
+	int n;				/* number of rows */
+	const double* values;		/* metric scores */
+	int values_stride;		/* distance between scores of consecutive rows [elements], 0 - same score */
+	struct batch_column width, height;	/* video resolution [pixels] */
+	struct batch_column player_width, player_height;	/* player size [pixels] */
+	struct batch_column hdr;	/* hdr (1) or sdr (0) indicators */
+	struct batch_column upsampling;	/* upsampling methods (see enum upsampling_methods) */
+	struct batch_column device;	/* device types (see enum device_types) */
+	struct device_params* params;	/* custom device parameters (for device_custom) */
+	struct geometry_store* store;	/* persistent cache of viewing contexts (may be NULL, see pmos_cache.h) */
+};
+
+/*! Function prototypes: */
+int score_batch(int metric, const struct score_batch* batch, double* mos, int n_threads);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,238 @@
+/*!
+ *  \file  pmos_bd.c
+ *  \brief Bjontegaard-delta comparisons of codecs in device-specific MOS domain (BD-MOS).
+ *
+ *  This code extends Bjontegaard-delta metrics [1,2] to device-specific MOS domain: metric scores of
+ *  all encodings are first mapped to MOS for a given viewing setup (accounting for resolution of each
+ *  encoding, see [3]), and BD metrics are then computed over the resulting rate-MOS curves:
+ *
+ *   - rate-MOS curve of each sequence is the upper envelope of all its encodings (across all resolutions);
+ *   - curves are interpolated by monotone piecewise cubic Hermite interpolants in log-bitrate domain [2],
+ *     and integrated in closed form;
+ *   - BD-MOS is the average MOS difference over the common bitrate range, and BD-rate is the average
+ *     relative bitrate difference over the common MOS range.
+ *
+ *    [1] G. Bjontegaard, "Calculation of Average PSNR Differences between RD-curves," VCEG-M33, April 2001.
+ *    [2] F. Bossen, "Common test conditions and software reference configurations," JCTVC-L1100, January 2013.
+ *    [3] N. Barman, R. Vanam, Y. Reznik, "Parametric Quality Models for Multiscreen Video Systems," EUVIP'22, September 11-14, 2022.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#include <stddef.h>
+#include <math.h>
+#include "pmos.h"
+#include "pmos_interp.h"
+#include "pmos_bd.h"
+
+#ifndef min
+#define min(a,b) ((a)<=(b)?(a):(b))
+#endif
+#ifndef max
+#define max(a,b) ((a)>=(b)?(a):(b))
+#endif
+
+/*! Viewing contexts cached for one viewing setup, indexed by resolution: */
+struct bd_contexts {
+	const struct viewing_setup* setup;
+	int n;
+	int width[BD_MAX_CONTEXTS];
+	int height[BD_MAX_CONTEXTS];
+	int status[BD_MAX_CONTEXTS];
+	struct viewing_context ctx[BD_MAX_CONTEXTS];
+};
+
+/*!
+ *  \brief Maps metric score of an encoding to MOS, using cached viewing contexts.
+ */
+static int point_mos(struct bd_contexts* c, int metric, const struct rd_point* p, double* p_mos)
+{
+	const struct viewing_setup* vs = c->setup;
+	struct viewing_context tmp, *ctx = &tmp;
+	double mos;
+	int i, err;
+
+	/* find viewing context for this resolution: */
+	for (i = 0; i < c->n; i++)
+		if (c->width[i] == p->width && c->height[i] == p->height) break;
+
+	if (i < c->n) {
+		ctx = &c->ctx[i];
+		err = c->status[i];
+	} else {
+		/* compute (and cache, if there is space): */
+		if (i < BD_MAX_CONTEXTS) {
+			ctx = &c->ctx[i];
+			c->width[i] = p->width;
+			c->height[i] = p->height;
+			c->n++;
+		}
+		err = viewing_context_init(ctx, p->width, p->height, vs->player_width, vs->player_height, vs->hdr, vs->upsampling, vs->device, vs->params);
+		if (i < BD_MAX_CONTEXTS)
+			c->status[i] = err;
+	}
+	if (err)
+		return err;
+
+	mos = metric2mos(ctx, metric, p->metric);
+	if (mos < 0)
+		return (int)mos;
+
+	*p_mos = mos;
+	return 0;
+}
+
+/*!
+ *  \brief Builds rate-MOS curve (upper envelope of all encodings of a sequence).
+ *
+ *  \return number of points in the curve (>= 2), <0 - error
+ */
+static int rate_mos_curve(struct bd_contexts* c, int metric, const struct rd_curve* curve, double* x, double* y)
+{
+	double b[BD_MAX_POINTS], m[BD_MAX_POINTS], bk, mk = 0;
+	int k, j, n = 0, err;
+
+	/* check parameters */
+	if (curve == NULL || curve->points == NULL) return -6;
+	if (curve->n_points < 2 || curve->n_points > BD_MAX_POINTS) return -13;
+
+	/* map all points to MOS, and sort them by bitrates (and MOS scores, in the reverse order): */
+	for (k = 0; k < curve->n_points; k++) {
+		bk = curve->points[k].bitrate;
+		if (!(bk > 0)) return -13;
+		err = point_mos(c, metric, &curve->points[k], &mk);
+		if (err) return err;
+		for (j = k; j > 0 && (b[j - 1] > bk || (b[j - 1] == bk && m[j - 1] < mk)); j--) {
+			b[j] = b[j - 1];
+			m[j] = m[j - 1];
+		}
+		b[j] = bk;
+		m[j] = mk;
+	}
+
+	/* keep upper envelope (strictly increasing in both bitrate and MOS): */
+	for (k = 0; k < curve->n_points; k++) {
+		if (n && (m[k] <= y[n - 1] || log(b[k]) <= x[n - 1])) continue;
+		x[n] = log(b[k]);
+		y[n] = m[k];
+		n++;
+	}
+
+	return n < 2 ? -13 : n;
+}
+
+/*!
+ *  \brief BD-MOS and BD-rate for one sequence, using cached viewing contexts.
+ */
+static int bd_compute(struct bd_contexts* c, int metric, const struct rd_curve* anchor, const struct rd_curve* test, struct bd_result* result)
+{
+	double xa[BD_MAX_POINTS], ya[BD_MAX_POINTS], da[BD_MAX_POINTS];
+	double xt[BD_MAX_POINTS], yt[BD_MAX_POINTS], dt[BD_MAX_POINTS];
+	double lo, hi;
+	int na, nt;
+
+	result->status = 0;
+	result->bd_rate = result->bd_mos = 0;
+
+	/* build rate-MOS curves: */
+	na = rate_mos_curve(c, metric, anchor, xa, ya);
+	if (na < 0) return result->status = na;
+	nt = rate_mos_curve(c, metric, test, xt, yt);
+	if (nt < 0) return result->status = nt;
+
+	/* BD-MOS - average MOS difference over common log-bitrate range: */
+	lo = max(xa[0], xt[0]);
+	hi = min(xa[na - 1], xt[nt - 1]);
+	if (!(hi > lo)) return result->status = -14;
+	pchip_init(xa, ya, da, na);
+	pchip_init(xt, yt, dt, nt);
+	result->bd_mos = (pchip_integral(xt, yt, dt, nt, lo, hi) - pchip_integral(xa, ya, da, na, lo, hi)) / (hi - lo);
+
+	/* BD-rate - average log-bitrate difference over common MOS range: */
+	lo = max(ya[0], yt[0]);
+	hi = min(ya[na - 1], yt[nt - 1]);
+	if (!(hi > lo)) return result->status = -14;
+	pchip_init(ya, xa, da, na);
+	pchip_init(yt, xt, dt, nt);
+	result->bd_rate = exp((pchip_integral(yt, xt, dt, nt, lo, hi) - pchip_integral(ya, xa, da, na, lo, hi)) / (hi - lo)) - 1;
+
+	return 0;
+}
+
+/*!
+ * \brief Computes BD-rate and BD-MOS between two rate-quality curves of a sequence, for a given viewing setup.
+ *
+ * \param[in]  setup			viewing setup (device and player parameters)
+ * \param[in]  metric			metric type (see enum metric_types)
+ * \param[in]  anchor			rate-quality curve of the anchor codec
+ * \param[in]  test			rate-quality curve of the tested codec
+ * \param[out] result			BD comparison result
+ *
+ * \returns    0				success
+ *			  -1..-10			invalid viewing setup, metric type or score (see metric2mos())
+ *			  -13				invalid rate-quality curve
+ *			  -14				rate-MOS curves do not overlap
+ */
+int bd_mos(const struct viewing_setup* setup, int metric, const struct rd_curve* anchor, const struct rd_curve* test, struct bd_result* result)
+{
+	struct bd_contexts c;
+
+	if (setup == NULL || result == NULL) return -6;
+
+	c.setup = setup;
+	c.n = 0;
+	return bd_compute(&c, metric, anchor, test, result);
+}
+
+/*!
+ * \brief Computes BD-rate and BD-MOS for a set of sequences and viewing setups.
+ *
+ *  Viewing contexts are computed once per setup and resolution, and reused across all sequences.
+ *
+ * \param[in]  setups			viewing setups (device and player parameters)
+ * \param[in]  n_setups		number of viewing setups
+ * \param[in]  metric			metric type (see enum metric_types)
+ * \param[in]  anchors			rate-quality curves of the anchor codec, one per sequence
+ * \param[in]  tests			rate-quality curves of the tested codec, one per sequence
+ * \param[in]  n_sequences		number of sequences
+ * \param[out] results			BD comparison results [n_setups x n_sequences] (may be NULL)
+ * \param[out] averages		BD comparison results averaged over all sequences [n_setups]
+ *
+ * \returns    0				success (per-sequence errors are reported in results)
+ *			  -6				NULL pointer
+ */
+int bd_compare(const struct viewing_setup* setups, int n_setups, int metric, const struct rd_curve* anchors, const struct rd_curve* tests, int n_sequences, struct bd_result* results, struct bd_result* averages)
+{
+	struct bd_contexts c;
+	struct bd_result r, *pr;
+	int s, q, n;
+
+	if (setups == NULL || anchors == NULL || tests == NULL || averages == NULL) return -6;
+
+	for (s = 0; s < n_setups; s++) {
+		c.setup = &setups[s];
+		c.n = 0;
+		averages[s].bd_rate = averages[s].bd_mos = 0;
+		averages[s].status = -14;
+		for (q = 0, n = 0; q < n_sequences; q++) {
+			pr = results ? &results[s * n_sequences + q] : &r;
+			if (bd_compute(&c, metric, &anchors[q], &tests[q], pr)) continue;
+			averages[s].bd_rate += pr->bd_rate;
+			averages[s].bd_mos += pr->bd_mos;
+			n++;
+		}
+		if (n) {
+			averages[s].bd_rate /= n;
+			averages[s].bd_mos /= n;
+			averages[s].status = 0;
+		}
+	}
+
+	return 0;
+}
+
+/* pmos_bd.c -- end of file */
@@ -0,0 +1,50 @@
+/*!
+ *  \file  pmos_bd.h
+ *  \brief Bjontegaard-delta comparisons of codecs in device-specific MOS domain (BD-MOS).
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _PMOS_BD_H_
+#define _PMOS_BD_H_ 1
+#include "pmos.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BD_MAX_POINTS       64	/* max number of points in a rate-quality curve */
+#define BD_MAX_CONTEXTS     32	/* max number of distinct resolutions with cached viewing contexts per device */
+
+/*! Rate-quality point (an encoding of a sequence at some resolution and bitrate): */
+struct rd_point {
+	double bitrate;			/* bitrate [kbps] */
+	int width;			/* video width [pixels] */
+	int height;			/* video height [pixels] */
+	double metric;			/* metric score */
+};
+
+/*! Rate-quality curve of a sequence: */
+struct rd_curve {
+	int n_points;			/* number of points (any order, any mix of resolutions) */
+	const struct rd_point* points;	/* points */
+};
+
+/*! BD comparison result: */
+struct bd_result {
+	int status;			/* 0 - success, <0 - error (see bd_mos()) */
+	double bd_rate;			/* average relative bitrate difference of test vs. anchor at equal MOS (e.g. -0.2 = 20% savings) */
+	double bd_mos;			/* average MOS difference of test vs. anchor at equal bitrates */
+};
+
+/*! Function prototypes: */
+int bd_mos(const struct viewing_setup* setup, int metric, const struct rd_curve* anchor, const struct rd_curve* test, struct bd_result* result);
+int bd_compare(const struct viewing_setup* setups, int n_setups, int metric, const struct rd_curve* anchors, const struct rd_curve* tests, int n_sequences, struct bd_result* results, struct bd_result* averages);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,532 @@
+/*!
+ *  \file  pmos_cache.c
+ *  \brief Cache of viewing contexts, keyed by viewing geometry.
+ *
+ *  Tables of encodings typically contain few distinct combinations of resolutions, player sizes and
+ *  devices. The cache keeps viewing contexts (validated geometry, viewing angle, angular resolution
+ *  and WR score) for recently seen combinations, so that each row only costs evaluation of the metric
+ *  mapping. Results of failed validations are cached as well.
+ *
+ *  The cache is direct-mapped: each geometry hashes to one entry, which is replaced on a miss. It is
+ *  not thread-safe; each thread should use its own cache.
+ *
+ *  A persistent cache (geometry store) can be attached to caches, so that short-lived processes start
+ *  warm. It is a file of records (geometry, status, viewing context), each protected by a checksum,
+ *  following a header with model_hash() and the reproducible mode of the writer (see pmos.c). On
+ *  open, the file is mapped, valid records are indexed, and records computed later (on misses of
+ *  attached caches) are appended to it, one write per record, so that processes sharing the file
+ *  add to it concurrently. Files written with other models, or with a torn record at the end (e.g.
+ *  after a crash), are rewritten at open. Custom devices are not stored. The store is thread-safe,
+ *  and can be shared by caches of all threads.
+ *
+ *  Processes sharing the file lock <path>.lock: exclusively to open (and possibly rewrite) it, and
+ *  shared to append records. Before appending, a process checks if the file was replaced by another
+ *  one, and if so, reopens it (or stops appending, if it was written with another model).
+ *
+ *  Records are written in native byte order and layout (checked at open), so files are meant to
+ *  be shared on the same platform.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pmos.h"
+#include "pmos_cache.h"
+#include "pmos_probes.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*! Header of geometry store file: */
+struct store_header {
+	char magic[8];			/* "PMOSGEOM" */
+	unsigned int version;		/* GEOMETRY_STORE_VERSION */
+	unsigned int record_size;	/* sizeof(struct geometry_record) */
+	unsigned long long model_hash;	/* model_hash() of the writer */
+	int reproducible;		/* reproducible_mode() of the writer */
+	int reserved;
+};
+
+/*! Record of geometry store: */
+struct geometry_record {
+	struct geometry_key key;	/* viewing geometry */
+	int status;			/* result of viewing_context_init() for this geometry */
+	struct viewing_context ctx;	/* viewing context (if status == 0) */
+	unsigned long long checksum;	/* checksum of the fields above */
+};
+
+static const char store_magic[8] = {'P', 'M', 'O', 'S', 'G', 'E', 'O', 'M'};
+
+/*!
+ * \brief Initializes header of files written by this process.
+ */
+static void store_header_init(struct store_header* h)
+{
+	memset(h, 0, sizeof(*h));
+	memcpy(h->magic, store_magic, sizeof(h->magic));
+	h->version = GEOMETRY_STORE_VERSION;
+	h->record_size = sizeof(struct geometry_record);
+	h->model_hash = model_hash();
+	h->reproducible = reproducible_mode();
+}
+
+/*!
+ * \brief Initializes (empties) the cache.
+ *
+ * \param[out] cache			geometry cache
+ * \param[in]  params			custom device parameters (used for device_custom, may be NULL)
+ */
+void geometry_cache_init(struct geometry_cache* cache, struct device_params* params)
+{
+	int i;
+
+	cache->params = params;
+	cache->store = NULL;
+	cache->hits = cache->misses = 0;
+	for (i = 0; i < GEOMETRY_CACHE_SIZE; i++)
+		cache->entries[i].valid = 0;
+}
+
+/*!
+ * \brief Attaches persistent cache to a cache (NULL - detaches it).
+ *
+ *  Misses of the cache are then looked up in the persistent cache, and contexts computed on its
+ *  misses are added to it (see geometry_store_lookup()).
+ */
+void geometry_cache_attach(struct geometry_cache* cache, struct geometry_store* store)
+{
+	cache->store = store;
+}
+
+/*!
+ * \brief Hash of viewing geometry.
+ */
+static unsigned int geometry_hash(const struct geometry_key* key)
+{
+	unsigned int h;
+
+	h = (unsigned int)key->width * 2654435761u;
+	h = (h ^ (unsigned int)key->height) * 2654435761u;
+	h = (h ^ (unsigned int)key->player_width) * 2654435761u;
+	h = (h ^ (unsigned int)key->player_height) * 2654435761u;
+	h = (h ^ (unsigned int)(key->device * 8 + key->upsampling * 2 + key->hdr)) * 2654435761u;
+	return h;
+}
+
+/*!
+ * \brief Returns viewing context for a given geometry, computing it on a miss.
+ *
+ * \param[in]  cache			geometry cache
+ * \param[in]  key			viewing geometry
+ * \param[out] p_ctx			pointer to cached viewing context (valid until the next lookup)
+ *
+ * \returns    0				success
+ *			  <0				invalid geometry (see viewing_context_init())
+ */
+int geometry_cache_lookup(struct geometry_cache* cache, const struct geometry_key* key, const struct viewing_context** p_ctx)
+{
+	struct geometry_entry* e;
+	int hit;
+
+	if (cache == NULL || key == NULL || p_ctx == NULL) return -6;
+	PMOS_PROBE3(geometry_cache_lookup_entry, key->width, key->height, key->device);
+
+	e = &cache->entries[(geometry_hash(key) >> 16) & (GEOMETRY_CACHE_SIZE - 1)];
+	hit = e->valid && e->key.width == key->width && e->key.height == key->height
+		&& e->key.player_width == key->player_width && e->key.player_height == key->player_height
+		&& e->key.hdr == key->hdr && e->key.upsampling == key->upsampling && e->key.device == key->device;
+	if (hit) {
+		cache->hits++;
+	} else {
+		cache->misses++;
+		e->valid = 1;
+		e->key = *key;
+		if (cache->store != NULL && key->device >= 0 && key->device < device_custom)
+			geometry_store_lookup(cache->store, key, e);
+		else
+			e->status = viewing_context_init(&e->ctx, key->width, key->height, key->player_width, key->player_height, key->hdr, key->upsampling, key->device, cache->params);
+	}
+
+	*p_ctx = &e->ctx;
+	PMOS_PROBE2(geometry_cache_lookup_return, e->status, hit);
+	return e->status;
+}
+
+/****************************
+ *
+ * Persistent cache:
+ *
+ ***/
+
+static unsigned long long record_checksum(const struct geometry_record* r)
+{
+	return hash_bytes(14695981039346656037ull, r, offsetof(struct geometry_record, checksum));
+}
+
+/*!
+ * \brief Home slot of a geometry in the index of given size.
+ */
+static int store_slot(const struct geometry_key* key, int size)
+{
+	unsigned int h = geometry_hash(key);
+	return (int)((h ^ (h >> 16)) & (unsigned int)(size - 1));
+}
+
+/*!
+ * \brief Returns i-th record (mapped records first, then added ones).
+ */
+static const struct geometry_record* store_record(const struct geometry_store* s, int i)
+{
+	if (i < s->n_mapped)
+		return (const struct geometry_record*)((const char*)s->mapping + sizeof(struct store_header)) + i;
+	return s->added + (i - s->n_mapped);
+}
+
+/*!
+ * \brief Finds a record, NULL - not in the store.
+ */
+static const struct geometry_record* store_find(const struct geometry_store* s, const struct geometry_key* key)
+{
+	const struct geometry_record* r;
+	int i;
+
+	if (s->index_size == 0) return NULL;
+	for (i = store_slot(key, s->index_size); s->index[i]; i = (i + 1) & (s->index_size - 1)) {
+		r = store_record(s, s->index[i] - 1);
+		if (!memcmp(&r->key, key, sizeof(*key))) return r;
+	}
+	return NULL;
+}
+
+/*!
+ * \brief Adds record number i to the index, growing the index if needed.
+ *
+ * \returns 0 - success, -15 - out of memory
+ */
+static int store_index(struct geometry_store* s, int i)
+{
+	int *index, size, j, k;
+
+	/* keep the index at most half full: */
+	if (2 * (i + 1) > s->index_size) {
+		size = s->index_size ? 2 * s->index_size : 1024;
+		if ((index = (int*)calloc((size_t)size, sizeof(int))) == NULL) return -15;
+		for (j = 0; j < s->index_size; j++) {
+			if (!s->index[j]) continue;
+			for (k = store_slot(&store_record(s, s->index[j] - 1)->key, size); index[k]; k = (k + 1) & (size - 1));
+			index[k] = s->index[j];
+		}
+		free(s->index);
+		s->index = index;
+		s->index_size = size;
+	}
+
+	for (k = store_slot(&store_record(s, i)->key, s->index_size); s->index[k]; k = (k + 1) & (s->index_size - 1));
+	s->index[k] = i + 1;
+	return 0;
+}
+
+/*!
+ * \brief Locks the file against other processes (exclusive - to open or rewrite it, shared - to append to it).
+ */
+static void store_lock(struct geometry_store* s, int exclusive)
+{
+#ifndef _WIN32
+	struct flock fl;
+
+	if (s->lock_file == NULL) return;
+	memset(&fl, 0, sizeof(fl));
+	fl.l_type = exclusive ? F_WRLCK : F_RDLCK;
+	fl.l_whence = SEEK_SET;
+	while (fcntl(fileno(s->lock_file), F_SETLKW, &fl) == -1 && errno == EINTR);
+#endif
+}
+
+static void store_unlock(struct geometry_store* s)
+{
+#ifndef _WIN32
+	struct flock fl;
+
+	if (s->lock_file == NULL) return;
+	memset(&fl, 0, sizeof(fl));
+	fl.l_type = F_UNLCK;
+	fl.l_whence = SEEK_SET;
+	fcntl(fileno(s->lock_file), F_SETLK, &fl);
+#endif
+}
+
+/*!
+ * \brief Reopens the file for appending, if another process has replaced it (called with the file locked).
+ */
+static void store_reopen(struct geometry_store* s)
+{
+#ifndef _WIN32
+	struct store_header h, found;
+	struct stat a, b;
+	FILE* f;
+	int same;
+
+	if (s->file == NULL || stat(s->path, &a) || fstat(fileno(s->file), &b) || (a.st_dev == b.st_dev && a.st_ino == b.st_ino)) return;
+	fclose(s->file);
+	s->file = NULL;
+
+	/* only append to files written with the same model: */
+	store_header_init(&h);
+	if ((f = fopen(s->path, "rb")) == NULL) return;
+	same = fread(&found, sizeof(found), 1, f) == 1 && !memcmp(&found, &h, sizeof(h));
+	fclose(f);
+	if (same && (s->file = fopen(s->path, "ab")) != NULL)
+		setvbuf(s->file, NULL, _IONBF, 0);
+#endif
+}
+
+/*!
+ * \brief Adds a record to the store, and appends it to the file.
+ *
+ * \returns 0 - success, -14 - I/O error, -15 - out of memory
+ */
+static int store_add(struct geometry_store* s, const struct geometry_record* r)
+{
+	struct geometry_record* added;
+	int capacity, err;
+
+	if (s->n_added == s->capacity) {
+		capacity = s->capacity ? 2 * s->capacity : 256;
+		if ((added = (struct geometry_record*)realloc(s->added, (size_t)capacity * sizeof(*r))) == NULL) return -15;
+		s->added = added;
+		s->capacity = capacity;
+	}
+	s->added[s->n_added++] = *r;
+	if (store_index(s, s->n_mapped + s->n_added - 1)) { s->n_added--; return -15; }
+
+	/* one write per record (the file is opened for appending and unbuffered): */
+	if (s->file == NULL) return 0;
+	store_lock(s, 0);
+	store_reopen(s);
+	err = s->file != NULL && fwrite(r, sizeof(*r), 1, s->file) != 1;
+	store_unlock(s);
+	return err ? -14 : 0;
+}
+
+/*!
+ * \brief Loads store file (mapped read-only, if possible).
+ *
+ * \returns 0 - success, -14 - I/O error, -15 - out of memory, -18 - truncated file (no complete header)
+ */
+static int store_load(const char* path, void** p_data, size_t* p_size)
+{
+#ifndef _WIN32
+	struct stat st;
+	void* p;
+	int fd;
+
+	if ((fd = open(path, O_RDONLY)) < 0) return -14;
+	if (fstat(fd, &st) || st.st_size < (off_t)sizeof(struct store_header)) { close(fd); return -18; }
+	p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (p == MAP_FAILED) return -14;
+	*p_data = p;
+	*p_size = (size_t)st.st_size;
+	return 0;
+#else
+	FILE* f;
+	long size;
+	char* p;
+
+	if ((f = fopen(path, "rb")) == NULL) return -14;
+	if (fseek(f, 0, SEEK_END) || (size = ftell(f)) < (long)sizeof(struct store_header) || fseek(f, 0, SEEK_SET)) { fclose(f); return -18; }
+	if ((p = (char*)malloc((size_t)size)) == NULL) { fclose(f); return -15; }
+	if (fread(p, 1, (size_t)size, f) != (size_t)size) { fclose(f); free(p); return -14; }
+	fclose(f);
+	*p_data = p;
+	*p_size = (size_t)size;
+	return 0;
+#endif
+}
+
+static void store_unload(struct geometry_store* s)
+{
+	if (s->mapping == NULL) return;
+#ifndef _WIN32
+	munmap(s->mapping, s->mapping_size);
+#else
+	free(s->mapping);
+#endif
+	s->mapping = NULL;
+}
+
+/*!
+ * \brief Writes header and valid records into a new file, replacing the previous one.
+ */
+static int store_rewrite(struct geometry_store* s, const char* path, const struct store_header* h)
+{
+	char tmp[4096];
+	FILE* f;
+	int i, err;
+
+#ifndef _WIN32
+	/* temporary file of this process (not truncating one being written by another): */
+	snprintf(tmp, sizeof(tmp), "%s.%ld.tmp", path, (long)getpid());
+	if ((i = open(tmp, O_WRONLY | O_CREAT | O_EXCL, 0644)) < 0) return -14;
+	if ((f = fdopen(i, "wb")) == NULL) { close(i); remove(tmp); return -14; }
+#else
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	if ((f = fopen(tmp, "wb")) == NULL) return -14;
+#endif
+	fwrite(h, sizeof(*h), 1, f);
+	for (i = 0; i < s->n_mapped + s->n_added; i++)
+		fwrite(store_record(s, i), sizeof(struct geometry_record), 1, f);
+	err = fflush(f) != 0 || ferror(f);
+	if (fclose(f) || err) { remove(tmp); return -14; }
+#ifdef _WIN32
+	remove(path);
+#endif
+	if (rename(tmp, path)) { remove(tmp); return -14; }
+	return 0;
+}
+
+/*!
+ * \brief Opens persistent cache of viewing contexts, creating the file if needed.
+ *
+ * \param[out] s				geometry store
+ * \param[in]  path			store file
+ *
+ * \returns    0				success (if the file cannot be appended to, new records are kept in memory only)
+ *			  -6				invalid parameters
+ *			  -14				file can neither be read nor created
+ *			  -15				out of memory
+ */
+int geometry_store_open(struct geometry_store* s, const char* path)
+{
+	const struct store_header* mapped;
+	const struct geometry_record* r;
+	struct store_header h;
+	char lock_path[4096];
+	size_t n, i;
+	int rewrite = 1, err;
+
+	if (s == NULL || path == NULL) return -6;
+	memset(s, 0, sizeof(*s));
+	if (parallel_lock_init(&s->lock)) return -15;
+	if ((s->path = (char*)malloc(strlen(path) + 1)) == NULL) { parallel_lock_free(&s->lock); return -15; }
+	strcpy(s->path, path);
+	store_header_init(&h);
+
+	/* exclude other processes until the file is ready for appending (without a lock file, e.g. in a read-only directory, the store is only read): */
+	snprintf(lock_path, sizeof(lock_path), "%s.lock", path);
+	s->lock_file = fopen(lock_path, "a+b");
+	store_lock(s, 1);
+
+	/* index valid records of a compatible file (the first one of each geometry): */
+	if (store_load(path, &s->mapping, &s->mapping_size) == 0) {
+		mapped = (const struct store_header*)s->mapping;
+		if (memcmp(mapped, &h, sizeof(h))) store_unload(s);
+		else {
+			n = (s->mapping_size - sizeof(h)) / sizeof(struct geometry_record);
+			rewrite = n * sizeof(struct geometry_record) != s->mapping_size - sizeof(h);	/* torn record at the end */
+			for (i = 0; i < n; i++) {
+				r = (const struct geometry_record*)(mapped + 1) + i;
+				if (r->checksum != record_checksum(r) || r->key.device < 0 || r->key.device >= device_custom) { rewrite = 1; continue; }
+				if (store_find(s, &r->key) != NULL) continue;
+				if (i == (size_t)s->n_mapped) {
+					/* contiguous records are used in place: */
+					s->n_mapped++;
+					err = store_index(s, s->n_mapped - 1);
+				} else
+					err = store_add(s, r);
+				if (err) { store_unlock(s); geometry_store_close(s); return err; }
+			}
+		}
+	}
+
+	/* start a new file, or compact a damaged one (if it cannot be replaced, new records are not appended to it): */
+	if (rewrite && (err = store_rewrite(s, path, &h)) != 0) {
+		store_unlock(s);
+		if (s->mapping == NULL) { geometry_store_close(s); return err; }
+		return 0;
+	}
+
+	if ((s->file = fopen(path, "ab")) != NULL)
+		setvbuf(s->file, NULL, _IONBF, 0);
+	store_unlock(s);
+	return 0;
+}
+
+/*!
+ * \brief Closes persistent cache, and releases its memory.
+ */
+void geometry_store_close(struct geometry_store* s)
+{
+	if (s == NULL) return;
+	if (s->file != NULL) fclose(s->file);
+	if (s->lock_file != NULL) fclose(s->lock_file);
+	store_unload(s);
+	free(s->path);
+	free(s->added);
+	free(s->index);
+	parallel_lock_free(&s->lock);
+	memset(s, 0, sizeof(*s));
+}
+
+/*!
+ * \brief Returns viewing context for a given geometry, computing and storing it if it is not in the store.
+ *
+ * \param[in]  s				geometry store
+ * \param[in]  key			viewing geometry (standard devices only)
+ * \param[out] e				entry (key, status and viewing context)
+ *
+ * \returns    0				success
+ *			  <0				invalid geometry (see viewing_context_init())
+ */
+int geometry_store_lookup(struct geometry_store* s, const struct geometry_key* key, struct geometry_entry* e)
+{
+	const struct geometry_record* found;
+	struct geometry_record r;
+
+	if (s == NULL || key == NULL || e == NULL) return -6;
+	if (key->device < 0 || key->device >= device_custom) return -5;
+	e->valid = 1;
+	e->key = *key;
+
+	parallel_lock_acquire(&s->lock);
+	if ((found = store_find(s, key)) != NULL) {
+		s->hits++;
+		e->status = found->status;
+		e->ctx = found->ctx;
+	}
+	parallel_lock_release(&s->lock);
+	if (found != NULL) return e->status;
+
+	/* compute outside of the lock, and add unless another thread did it meanwhile: */
+	memset(&r, 0, sizeof(r));
+	r.key = *key;
+	r.status = viewing_context_init(&r.ctx, key->width, key->height, key->player_width, key->player_height, key->hdr, key->upsampling, key->device, NULL);
+	r.checksum = record_checksum(&r);
+	parallel_lock_acquire(&s->lock);
+	if (store_find(s, key) == NULL) {
+		s->misses++;
+		store_add(s, &r);	/* the context is valid even if it could not be stored */
+	}
+	parallel_lock_release(&s->lock);
+
+	e->status = r.status;
+	e->ctx = r.ctx;
+	return e->status;
+}
+
+/* pmos_cache.c -- end of file */
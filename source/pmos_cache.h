@@ -0,0 +1,78 @@
+/*!
+ *  \file  pmos_cache.h
+ *  \brief Cache of viewing contexts, keyed by viewing geometry.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _PMOS_CACHE_H_
+#define _PMOS_CACHE_H_ 1
+#include <stdio.h>
+#include <stddef.h>
+#include "pmos.h"
+#include "pmos_thread.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GEOMETRY_CACHE_SIZE  256	/* number of cache entries (power of 2) */
+#define GEOMETRY_STORE_VERSION  1	/* version of persistent cache format */
+
+/*! Viewing geometry: */
+struct geometry_key {
+	int width, height;		/* video resolution [pixels] */
+	int player_width, player_height;	/* player size [pixels] */
+	int hdr;			/* indicator if video is hdr (1) or sdr (0) */
+	int upsampling;			/* assumed upsampling method (see enum upsampling_methods) */
+	int device;			/* device type (see enum device_types) */
+};
+
+/*! Cache entry: */
+struct geometry_entry {
+	int valid;			/* 1 - entry is used */
+	struct geometry_key key;	/* viewing geometry */
+	int status;			/* result of viewing_context_init() for this geometry */
+	struct viewing_context ctx;	/* viewing context (if status == 0) */
+};
+
+/*! Persistent cache of viewing contexts (file shared by processes, standard devices only): */
+struct geometry_store {
+	void* mapping;			/* mapped file, as found at open */
+	size_t mapping_size;		/* size of mapped file [bytes] */
+	int n_mapped;			/* number of valid records in the mapping */
+	struct geometry_record* added;	/* records added since open */
+	int n_added, capacity;		/* number of added records, and capacity of the array */
+	int* index;			/* hash index of records (record number + 1, 0 - empty slot) */
+	int index_size;			/* number of index slots (power of 2) */
+	char* path;			/* store file */
+	FILE* file;			/* file opened for appending (NULL - new records are kept in memory only) */
+	FILE* lock_file;		/* <path>.lock, locked against other processes (NULL - none) */
+	struct parallel_lock lock;	/* lock of index and file */
+	long long hits, misses;		/* statistics */
+};
+
+/*! Direct-mapped cache of viewing contexts: */
+struct geometry_cache {
+	struct device_params* params;	/* custom device parameters (for device_custom) */
+	struct geometry_store* store;	/* persistent cache consulted on misses (NULL - none) */
+	long long hits, misses;		/* statistics */
+	struct geometry_entry entries[GEOMETRY_CACHE_SIZE];
+};
+
+/*! Function prototypes: */
+void geometry_cache_init(struct geometry_cache* cache, struct device_params* params);
+void geometry_cache_attach(struct geometry_cache* cache, struct geometry_store* store);
+int geometry_cache_lookup(struct geometry_cache* cache, const struct geometry_key* key, const struct viewing_context** p_ctx);
+
+int geometry_store_open(struct geometry_store* store, const char* path);
+void geometry_store_close(struct geometry_store* store);
+int geometry_store_lookup(struct geometry_store* store, const struct geometry_key* key, struct geometry_entry* e);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,150 @@
+/*!
+ *  \file  pmos_ci.c
+ *  \brief Standard errors of predicted MOS scores (delta method).
+ *
+ *  Given covariance C of model parameters, standard error of predicted MOS is computed as
+ *  se = sqrt(g' C g), where g is the gradient of MOS with respect to parameters. The gradient
+ *  is obtained analytically, in the same pass as the MOS score itself.
+ *
+ *  Since WR parameters affect MOS only through the WR score Qwr, the gradient has the form
+ *  g = [s * g_wr, g_f], where g_wr = dQwr/d(WR parameters) depends only on the viewing setup, and
+ *  s = dMOS/dQwr and g_f = dMOS/d(fused model parameters) depend on the metric score. Covariance
+ *  C = [A B; B' D] is split accordingly, and terms g_wr' A g_wr and B' g_wr are computed once per
+ *  viewing context, leaving only a 6x6 quadratic form per metric score:
+ *
+ *    se^2 = s^2 g_wr' A g_wr + 2 s (B' g_wr)' g_f + g_f' D g_f
+ *
+ *  Where MOS or WR score is clamped to [1..5] range, the corresponding gradient is zero.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#include <stddef.h>
+#include <math.h>
+#include "pmos.h"
+#include "pmos_ci.h"
+
+#define n_fusion_params  (n_model_params - n_wr_params)
+
+/*!
+ *  \brief Computes gradient of WR score [2, formulae 8] with respect to parameters of WR model.
+ */
+static void wr_gradient(const struct viewing_context* ctx, double* g)
+{
+	const struct wr_params* wr = wr_model_params(ctx->hdr, ctx->upsampling);
+	double x, y, f_phi, f_u, f, r, h;
+	int i;
+
+	/* terms of WR model: */
+	x = pow(ctx->phi / wr->phi_s, -wr->k);
+	y = pow(ctx->u / wr->u_s, -wr->l);
+	f_phi = pow(1.0 + x, -wr->gamma / wr->k);
+	f_u = pow(1.0 + y, -wr->delta / wr->l);
+	f = f_phi * f_u;
+	r = wr->alpha + wr->beta * f;
+
+	/* WR score is clamped -> no dependency on parameters: */
+	if (log(r) < 1 || log(r) > 5) {
+		for (i = 0; i < n_wr_params; i++) g[i] = 0;
+		return;
+	}
+
+	/* Qwr = log(r), derivatives of log(f_phi) and log(f_u) scaled by dQwr/dlog(f) = beta * f / r: */
+	h = wr->beta * f / r;
+	g[param_wr_alpha] = 1.0 / r;
+	g[param_wr_beta] = f / r;
+	g[param_wr_gamma] = -h * log(1.0 + x) / wr->k;
+	g[param_wr_delta] = -h * log(1.0 + y) / wr->l;
+	g[param_wr_k] = h * wr->gamma / wr->k * (log(1.0 + x) / wr->k + log(ctx->phi / wr->phi_s) * x / (1.0 + x));
+	g[param_wr_l] = h * wr->delta / wr->l * (log(1.0 + y) / wr->l + log(ctx->u / wr->u_s) * y / (1.0 + y));
+	g[param_wr_phi_s] = -h * wr->gamma * x / (wr->phi_s * (1.0 + x));
+	g[param_wr_u_s] = -h * wr->delta * y / (wr->u_s * (1.0 + y));
+}
+
+/*!
+ * \brief Maps an array of metric scores to MOS, and computes standard errors of MOS predictions.
+ *
+ *  Invalid scores produce -9 at corresponding positions in both output arrays.
+ *
+ * \param[in]  ctx			viewing context (see viewing_context_init())
+ * \param[in]  metric			metric type (see enum metric_types)
+ * \param[in]  cov			covariance of model parameters (NULL - parameters are exact, se = 0)
+ * \param[in]  values			metric scores
+ * \param[out] mos			computed MOS scores (same as produced by metric2mos())
+ * \param[out] se				standard errors of MOS scores
+ * \param[in]  n				number of scores
+ *
+ * \returns    0				success
+ *			  -6				NULL pointer
+ *			  -9				some metric scores are invalid
+ *			  -10				invalid metric type
+ */
+int metric2mos_se(const struct viewing_context* ctx, int metric, const struct model_covariance* cov, const double* values, double* mos, double* se, int n)
+{
+	const struct fusion_params* fp;
+	double g_wr[n_wr_params], bg[n_fusion_params], g_f[n_fusion_params];
+	double a = 0, b, dq, q, m, s, dq_dx, v;
+	int i, j, k, err = 0;
+
+	/* check parameters: */
+	if (ctx == NULL || values == NULL || mos == NULL || se == NULL) return -6;
+	if ((fp = fusion_model_params(metric)) == NULL) return -10;
+
+	/* terms depending only on viewing setup: a = g_wr' A g_wr, bg = B' g_wr */
+	if (cov != NULL) {
+		wr_gradient(ctx, g_wr);
+		for (i = 0; i < n_wr_params; i++)
+			for (j = 0; j < n_wr_params; j++)
+				a += g_wr[i] * cov->c[i][j] * g_wr[j];
+		for (k = 0; k < n_fusion_params; k++)
+			for (bg[k] = 0, i = 0; i < n_wr_params; i++)
+				bg[k] += cov->c[i][n_wr_params + k] * g_wr[i];
+	}
+	b = fp->beta * (1 + fp->gamma * ctx->qwr);
+	dq = fp->delta * ctx->qwr;
+
+	for (i = 0; i < n; i++) {
+		/* MOS [3, formula 2], computed as in metric2mos(): */
+		q = metric_scale(metric, values[i]);
+		if (q < 0) {
+			mos[i] = se[i] = q;
+			err = -9;
+			continue;
+		}
+		m = fp->alpha + b * q + dq;
+		mos[i] = m < 1 ? 1 : m > 5 ? 5 : m;
+		se[i] = 0;
+		if (cov == NULL || m < 1 || m > 5) continue;
+
+		/* gradient with respect to parameters of fused model, and dMOS/dQwr: */
+		dq_dx = 0;
+		g_f[param_fusion_epsilon - n_wr_params] = g_f[param_fusion_zeta - n_wr_params] = 0;
+		if (metric != metric_vmaf) {
+			dq_dx = q * (1 - q);	/* derivative of logistic function */
+			g_f[param_fusion_epsilon - n_wr_params] = b * dq_dx * (values[i] - fp->zeta);
+			g_f[param_fusion_zeta - n_wr_params] = -b * dq_dx * fp->epsilon;
+		}
+		g_f[param_fusion_alpha - n_wr_params] = 1;
+		g_f[param_fusion_beta - n_wr_params] = (1 + fp->gamma * ctx->qwr) * q;
+		g_f[param_fusion_gamma - n_wr_params] = fp->beta * ctx->qwr * q;
+		g_f[param_fusion_delta - n_wr_params] = ctx->qwr;
+		s = fp->beta * fp->gamma * q + fp->delta;
+
+		/* quadratic form: */
+		v = s * s * a;
+		for (j = 0; j < n_fusion_params; j++) {
+			v += 2 * s * bg[j] * g_f[j];
+			for (k = 0; k < n_fusion_params; k++)
+				v += g_f[j] * cov->c[n_wr_params + j][n_wr_params + k] * g_f[k];
+		}
+		se[i] = v > 0 ? sqrt(v) : 0;
+	}
+
+	return err;
+}
+
+/* pmos_ci.c -- end of file */
@@ -0,0 +1,51 @@
+/*!
+ *  \file  pmos_ci.h
+ *  \brief Standard errors of predicted MOS scores (delta method).
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _PMOS_CI_H_
+#define _PMOS_CI_H_ 1
+#include "pmos.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! Model parameters, in the order of rows/columns of the covariance matrix: */
+enum model_params {
+	param_wr_alpha = 0,		/* WR model parameters (see struct wr_params) */
+	param_wr_beta,
+	param_wr_gamma,
+	param_wr_delta,
+	param_wr_k,
+	param_wr_l,
+	param_wr_phi_s,
+	param_wr_u_s,
+	param_fusion_alpha,		/* fused model parameters (see struct fusion_params) */
+	param_fusion_beta,
+	param_fusion_gamma,
+	param_fusion_delta,
+	param_fusion_epsilon,
+	param_fusion_zeta,
+	n_model_params			/* the number of model parameters */
+};
+
+#define n_wr_params  (param_fusion_alpha)	/* number of WR model parameters */
+
+/*! Covariance of model parameters (for a given metric, type of content and upsampling method): */
+struct model_covariance {
+	double c[n_model_params][n_model_params];	/* symmetric covariance matrix */
+};
+
+/*! Function prototypes: */
+int metric2mos_se(const struct viewing_context* ctx, int metric, const struct model_covariance* cov, const double* values, double* mos, double* se, int n);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
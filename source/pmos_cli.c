@@ -0,0 +1,854 @@
+/*!
+ *  \file  pmos_cli.c
+ *  \brief Command-line interface to pmos models.
+ *
+ *  Modes:
+ *
+ *    pmos_cli [options] --value V --width W --height H    - prints MOS for a single encoding
+ *    pmos_cli [options] --rowbinary [--chunked]           - scores RowBinary rows from stdin
+ *    pmos_cli [options] --columnar                        - scores column blocks from stdin
+ *    pmos_cli [options] --logs [--queue-depth Q]          - scores metric log files listed on stdin
+ *    pmos_cli [options] --jsonl                           - scores JSON-lines records from stdin
+ *
+ *  Options:
+ *
+ *    --metric psnr|ssim|vif|vmaf     metric type (default: psnr)
+ *    --player-width PW, --player-height PH   player size (default: 3840x2160)
+ *    --hdr 0|1, --upsampling U, --device D   defaults for single-encoding mode (0, 0, 3 - TV)
+ *    --threads N                     number of threads in streaming and log modes (default: 0 - all cores)
+ *    --max-decompressed MB           limit on size of decompressed logs (default: 1024 MB), larger ones are decompress_error
+ *    --streams N, --half-life S      capacity of stream table (default: 65536), and half-life of rolling MOS (default: 30 s)
+ *    --checkpoint PATH, --checkpoint-every N   checkpoints of stream states in JSON-lines mode
+ *    --geometry-cache PATH           persistent cache of viewing contexts in streaming modes (see pmos_cache.c)
+ *
+ *  Streaming modes are meant for executable UDFs of analytic databases, and process input in blocks
+ *  of up to CLI_BLOCK_ROWS rows, scored with score_batch(). The process stays alive between blocks,
+ *  and output is flushed after each block. With --geometry-cache, viewing contexts computed by previous
+ *  processes are loaded from PATH at startup, and new ones are appended to it, so that short-lived
+ *  workers start warm.
+ *
+ *  RowBinary mode: each row is Float64 score, followed by Int32 width, height, player_width,
+ *  player_height, hdr, upsampling, device (all little-endian, 36 bytes per row). With --chunked,
+ *  each chunk of rows is preceded by the number of rows as a text line (ClickHouse setting
+ *  send_chunk_header = 1), otherwise rows are read until end of input. For each row, a Float64
+ *  MOS (or negative error code, see psnr2mos()) is written to stdout. Example of UDF definition:
+ *
+ *    <function>
+ *      <type>executable_pool</type> <name>psnr2mos</name> <return_type>Float64</return_type>
+ *      <argument><type>Float64</type></argument> <argument><type>Int32</type></argument> (x7)
+ *      <format>RowBinary</format> <send_chunk_header>1</send_chunk_header>
+ *      <command>pmos_cli --rowbinary --chunked --metric psnr</command>
+ *    </function>
+ *
+ *  Columnar mode: each block is UInt32 number of rows n (at most CLI_BLOCK_ROWS), followed by n Float64 scores, and then
+ *  n Int32 values of each of the 7 geometry columns (in the order listed above). For each block,
+ *  n Float64 MOS values are written. Input ends with n = 0 or end of input.
+ *
+ *  Log mode: each input line is a path of a metric log (see pmos_logs.c for supported formats),
+ *  followed by video width and height, separated by spaces. Files are read in parallel (see
+ *  pmos_ingest.c, with up to Q reads in flight per thread when built with io_uring), decompressed
+ *  if they are gzip or zstd compressed (see pmos_decompress.c), and parsed as they arrive, in blocks
+ *  of up to CLI_BLOCK_ROWS files. For each file, a CSV line with path, status (ok, read_error,
+ *  bad_format, no_metric, decompress_error), number of frames, mean score and MOS is written.
+ *  Reading statistics (files/s, GB/s read and decompressed) are reported to stderr.
+ *
+ *  JSON-lines mode: each input line is a JSON object with fields "value", "width", "height", and
+ *  optionally "player_width", "player_height", "hdr", "upsampling", "device" (defaulting to options)
+ *  and "id". For each line, {"id": ..., "mos": M} or {"id": ..., "error": E, "message": "..."} is written, in input
+ *  order, with E a negative error code (-16 - invalid record, -17 - record too long, others - see pmos.h).
+ *  Records are read into a fixed buffer of JSONL_BUFFER bytes, and all complete records in it are
+ *  scored in micro-batches of up to JSONL_BATCH records and written before more input is read. Under
+ *  load, batches fill up; at low rates, each record is answered as soon as it arrives. Memory use is
+ *  fixed: when the consumer of stdout is slow, writes block and input is not read, so backpressure
+ *  propagates to the producer through the pipe.
+ *
+ *  Records with a "stream" field (non-zero integer id) are also aggregated per stream (see
+ *  pmos_stream.c), with optional "duration" of the segment (default: 1 s), and "end": true to end
+ *  the stream. Their output adds "rolling" and "session" (duration-weighted) MOS of the stream. With
+ *  --checkpoint PATH, stream states are restored from PATH at startup (if it exists), checkpointed
+ *  incrementally every --checkpoint-every N aggregated records (default: 100000), with every 16th
+ *  and the final checkpoint being full.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include "pmos.h"
+#include "pmos_batch.h"
+#include "pmos_cache.h"
+#include "pmos_thread.h"
+#include "pmos_ingest.h"
+#include "pmos_logs.h"
+#include "pmos_stream.h"
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#define read _read
+#else
+#include <unistd.h>
+#endif
+
+#define CLI_BLOCK_ROWS      65536	/* max number of rows scored at once */
+#define CLI_GEOMETRY        7	/* number of geometry columns (width .. device) */
+#define ROWBINARY_ROW_SIZE  (8 + 4 * CLI_GEOMETRY)	/* size of RowBinary row [bytes] */
+
+/*! Metric names (in the order of enum metric_types): */
+static const char* metric_names[n_metric_types] = {"psnr", "ssim", "vif", "vmaf"};
+
+/*! Command-line options: */
+struct cli_options {
+	int metric;			/* metric type */
+	double value;			/* metric score (single-encoding mode) */
+	int geometry[CLI_GEOMETRY];	/* width, height, player_width, player_height, hdr, upsampling, device */
+	int mode;			/* 0 - single, 1 - RowBinary, 2 - columnar, 3 - logs, 4 - JSON lines */
+	int chunked;			/* 1 - RowBinary chunks are preceded by row counts */
+	int n_threads;			/* number of threads */
+	int queue_depth;		/* reads in flight per thread (log mode) */
+	int n_streams;			/* capacity of stream table (JSON-lines mode) */
+	double half_life;		/* half-life of rolling MOS [s] */
+	const char* checkpoint;		/* checkpoint file of stream states (NULL - none) */
+	int checkpoint_every;		/* number of aggregated records between checkpoints */
+	const char* geometry_cache;	/* persistent cache of viewing contexts (NULL - none) */
+	struct geometry_store* store;	/* opened persistent cache */
+	int max_decompressed;		/* limit on size of decompressed logs [MB] (0 - default) */
+};
+
+/*! Block of rows (columns): */
+struct cli_block {
+	int n;				/* number of rows */
+	double values[CLI_BLOCK_ROWS];
+	int geometry[CLI_GEOMETRY][CLI_BLOCK_ROWS];
+	double mos[CLI_BLOCK_ROWS];
+	unsigned char io[CLI_BLOCK_ROWS * ROWBINARY_ROW_SIZE];	/* raw input/output */
+};
+
+/****************************
+ *
+ * Little-endian encoding:
+ *
+ ***/
+
+static unsigned int get_le32(const unsigned char* p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+static double get_le_double(const unsigned char* p)
+{
+	unsigned long long u = get_le32(p) | ((unsigned long long)get_le32(p + 4) << 32);
+	double d;
+	memcpy(&d, &u, sizeof(d));
+	return d;
+}
+
+static void put_le_double(unsigned char* p, double d)
+{
+	unsigned long long u;
+	int i;
+	memcpy(&u, &d, sizeof(u));
+	for (i = 0; i < 8; i++, u >>= 8) p[i] = (unsigned char)u;
+}
+
+/****************************
+ *
+ * Streaming modes:
+ *
+ ***/
+
+/*!
+ * \brief Scores a block.
+ */
+static void block_mos(struct cli_block* b, const struct cli_options* o)
+{
+	struct score_batch batch;
+	struct batch_column* columns[CLI_GEOMETRY];
+	int i;
+
+	batch.n = b->n;
+	batch.values = b->values;
+	batch.values_stride = 1;
+	columns[0] = &batch.width;
+	columns[1] = &batch.height;
+	columns[2] = &batch.player_width;
+	columns[3] = &batch.player_height;
+	columns[4] = &batch.hdr;
+	columns[5] = &batch.upsampling;
+	columns[6] = &batch.device;
+	for (i = 0; i < CLI_GEOMETRY; i++) {
+		columns[i]->data = b->geometry[i];
+		columns[i]->stride = 1;
+	}
+	batch.params = NULL;
+	batch.store = o->store;
+	score_batch(o->metric, &batch, b->mos, o->n_threads);	/* per-row errors are reported in the output */
+}
+
+/*!
+ * \brief Scores a block, and writes MOS values to stdout.
+ *
+ * \returns 0 - success, -1 - write error
+ */
+static int block_score(struct cli_block* b, const struct cli_options* o)
+{
+	int i;
+
+	if (b->n == 0) return 0;
+	block_mos(b, o);
+	for (i = 0; i < b->n; i++)
+		put_le_double(b->io + i * 8, b->mos[i]);
+	if (fwrite(b->io, 8, b->n, stdout) != (size_t)b->n) return -1;
+	return 0;
+}
+
+/*!
+ * \brief Reads up to n RowBinary rows into a block.
+ *
+ * \returns number of rows read
+ */
+static int rowbinary_read(struct cli_block* b, int n)
+{
+	const unsigned char* p;
+	int i, j;
+
+	b->n = (int)fread(b->io, ROWBINARY_ROW_SIZE, n, stdin);
+	for (i = 0, p = b->io; i < b->n; i++, p += ROWBINARY_ROW_SIZE) {
+		b->values[i] = get_le_double(p);
+		for (j = 0; j < CLI_GEOMETRY; j++)
+			b->geometry[j][i] = (int)get_le32(p + 8 + 4 * j);
+	}
+	return b->n;
+}
+
+/*!
+ * \brief RowBinary mode.
+ */
+static int mode_rowbinary(struct cli_block* b, const struct cli_options* o)
+{
+	char line[64];
+	long rows;
+	int n;
+
+	for (;;) {
+		/* number of rows in the next chunk: */
+		rows = CLI_BLOCK_ROWS;
+		if (o->chunked) {
+			if (fgets(line, sizeof(line), stdin) == NULL) return 0;
+			rows = strtol(line, NULL, 10);
+			if (rows < 0) { fprintf(stderr, "pmos_cli: invalid chunk header\n"); return 1; }
+		}
+
+		/* score the chunk in blocks: */
+		do {
+			n = rowbinary_read(b, rows < CLI_BLOCK_ROWS ? (int)rows : CLI_BLOCK_ROWS);
+			if (block_score(b, o)) return 1;
+			if (o->chunked) {
+				rows -= n;
+				if (n == 0 && rows > 0) { fprintf(stderr, "pmos_cli: unexpected end of input\n"); return 1; }
+			}
+		} while (o->chunked ? rows > 0 : n == CLI_BLOCK_ROWS);
+		fflush(stdout);
+
+		if (!o->chunked) return 0;
+	}
+}
+
+/*!
+ * \brief Columnar mode.
+ */
+static int mode_columnar(struct cli_block* b, const struct cli_options* o)
+{
+	unsigned char header[4];
+	unsigned int rows;
+	int i, j, n;
+
+	while (fread(header, 4, 1, stdin) == 1 && (rows = get_le32(header)) != 0) {
+		if (rows > CLI_BLOCK_ROWS) { fprintf(stderr, "pmos_cli: blocks must have at most %d rows\n", CLI_BLOCK_ROWS); return 1; }
+		n = (int)rows;
+
+		/* columns: */
+		if (fread(b->io, 8, n, stdin) != (size_t)n) goto truncated;
+		for (i = 0; i < n; i++)
+			b->values[i] = get_le_double(b->io + i * 8);
+		for (j = 0; j < CLI_GEOMETRY; j++) {
+			if (fread(b->io, 4, n, stdin) != (size_t)n) goto truncated;
+			for (i = 0; i < n; i++)
+				b->geometry[j][i] = (int)get_le32(b->io + i * 4);
+		}
+
+		b->n = n;
+		if (block_score(b, o)) return 1;
+		fflush(stdout);
+	}
+	return 0;
+
+truncated:
+	fprintf(stderr, "pmos_cli: unexpected end of input\n");
+	return 1;
+}
+
+/****************************
+ *
+ * Log mode:
+ *
+ ***/
+
+/*! Files of a block: */
+struct cli_logs {
+	struct cli_block* b;		/* scores and geometries */
+	int metric;			/* metric type */
+	char* paths[CLI_BLOCK_ROWS];	/* file names */
+	int status[CLI_BLOCK_ROWS];	/* 0 - ok, <0 - error (see log_status_names) */
+	int frames[CLI_BLOCK_ROWS];	/* number of frames */
+};
+
+/*! Names of file statuses (indexed by -status): */
+static const char* log_status_names[] = {"ok", "read_error", "bad_format", "no_metric", "decompress_error"};
+
+/*!
+ * \brief Parses a log (called from ingestion threads).
+ */
+static void log_parse(void* arg, int index, const char* data, size_t size, int err)
+{
+	struct cli_logs* l = (struct cli_logs*)arg;
+	struct log_summary s;
+
+	(void)size;
+	if (err == -2) err = -4;	/* cannot decompress */
+	else if (!err) err = parse_metric_log(data, l->metric, &s);
+	l->status[index] = err;
+	l->frames[index] = err ? 0 : s.n_frames;
+	l->b->values[index] = err ? 0 : s.mean;
+}
+
+/*!
+ * \brief Reads up to CLI_BLOCK_ROWS lines of file names and geometries.
+ *
+ * \returns number of files read, -1 - invalid line
+ */
+static int logs_read(struct cli_logs* l, const struct cli_options* o)
+{
+	struct cli_block* b = l->b;
+	char line[4096], *p;
+	int j, len;
+
+	for (b->n = 0; b->n < CLI_BLOCK_ROWS && fgets(line, sizeof(line), stdin) != NULL; ) {
+		len = (int)strlen(line);
+		while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r' || line[len - 1] == ' ')) line[--len] = 0;
+		if (len == 0) continue;
+
+		/* last two fields are width and height: */
+		for (j = 1; j >= 0; j--) {
+			if ((p = strrchr(line, ' ')) == NULL) { fprintf(stderr, "pmos_cli: expected 'path width height': %s\n", line); return -1; }
+			b->geometry[j][b->n] = atoi(p + 1);
+			while (p > line && p[-1] == ' ') p--;
+			*p = 0;
+		}
+		for (j = 2; j < CLI_GEOMETRY; j++)
+			b->geometry[j][b->n] = o->geometry[j];
+		if ((l->paths[b->n] = (char*)malloc(strlen(line) + 1)) == NULL) return -1;
+		strcpy(l->paths[b->n++], line);
+	}
+	return b->n;
+}
+
+/*!
+ * \brief Log mode.
+ */
+static int mode_logs(struct cli_block* b, const struct cli_options* o)
+{
+	struct cli_logs* l;
+	struct ingest_stats stats, total = {0, 0, 0, 0, 0, 1};
+	int i, n, err = 0;
+
+	if ((l = (struct cli_logs*)malloc(sizeof(struct cli_logs))) == NULL) { fprintf(stderr, "pmos_cli: out of memory\n"); return 1; }
+	l->b = b;
+	l->metric = o->metric;
+	printf("path,status,frames,score,mos\n");
+
+	while ((n = logs_read(l, o)) > 0) {
+		/* read and parse files, then score blocks of files: */
+		if ((err = ingest_files((const char* const*)l->paths, n, o->n_threads, o->queue_depth, INGEST_DECOMPRESS, (size_t)o->max_decompressed << 20, log_parse, l, &stats)) != 0) {
+			fprintf(stderr, "pmos_cli: cannot read files (error %d)\n", err);
+			err = 1;
+			break;
+		}
+		block_mos(b, o);
+		for (i = 0; i < n; i++) {
+			if (l->status[i]) printf("%s,%s,0,,\n", l->paths[i], log_status_names[-l->status[i]]);
+			else printf("%s,ok,%d,%.6f,%.6f\n", l->paths[i], l->frames[i], b->values[i], b->mos[i]);
+			free(l->paths[i]);
+		}
+		fflush(stdout);
+
+		total.files += stats.files;
+		total.failed += stats.failed;
+		total.bytes += stats.bytes;
+		total.output_bytes += stats.output_bytes;
+		total.seconds += stats.seconds;
+		total.io_uring &= stats.io_uring;
+	}
+	if (n < 0) err = 1;
+
+	if (total.seconds > 0)
+		fprintf(stderr, "pmos_cli: read %d files (%d failed), %.1f MB (%.1f MB decompressed) in %.3f s: %.0f files/s, %.3f GB/s read, %.3f GB/s decompressed (%s)\n",
+			total.files, total.failed, total.bytes * 1e-6, total.output_bytes * 1e-6, total.seconds, (total.files + total.failed) / total.seconds,
+			total.bytes * 1e-9 / total.seconds, total.output_bytes * 1e-9 / total.seconds, total.io_uring ? "io_uring" : "blocking reads");
+	free(l);
+	return err;
+}
+
+/****************************
+ *
+ * JSON-lines mode:
+ *
+ ***/
+
+#define JSONL_BUFFER  (1 << 20)	/* size of input buffer [bytes], longer records are rejected */
+#define JSONL_BATCH   4096	/* max number of records scored at once */
+#define JSONL_MAX_ID  256	/* max length of record id [bytes] */
+#define JSONL_FULL_CHECKPOINT  16	/* every 16th checkpoint is full */
+#define JSONL_INVALID  -16	/* error code of invalid records */
+#define JSONL_TOO_LONG -17	/* error code of records longer than JSONL_BUFFER */
+
+/*! Messages of error codes (indexed by -code): */
+static const char* jsonl_messages[] = {
+	"", "invalid resolution", "invalid player size", "invalid HDR/SDR indicator", "invalid upsampling method", "invalid device type",
+	"invalid parameters", "invalid custom device parameters", "invalid viewing setup", "invalid metric score", "invalid metric type",
+	"stream table is full", "", "", "", "", "invalid record", "record too long"
+};
+
+/*! Names of geometry fields (in the order of cli_block.geometry): */
+static const char* jsonl_geometry_keys[CLI_GEOMETRY] = {"width", "height", "player_width", "player_height", "hdr", "upsampling", "device"};
+
+/*! Records of a micro-batch: */
+struct cli_jsonl {
+	const char* id[JSONL_BATCH];	/* JSON tokens of record ids (NULL - no id), pointing into the input buffer */
+	int id_len[JSONL_BATCH];	/* lengths of ids */
+	int status[JSONL_BATCH];	/* 0 - ok, JSONL_INVALID, or JSONL_TOO_LONG */
+	unsigned long long stream[JSONL_BATCH];	/* stream ids (0 - not aggregated) */
+	double duration[JSONL_BATCH];	/* segment durations [s] */
+	int end[JSONL_BATCH];		/* 1 - last record of the stream */
+	struct stream_table streams;	/* stream states */
+	int n_aggregated;		/* records aggregated since the last checkpoint */
+	int n_checkpoints;		/* number of checkpoints written */
+	char buffer[JSONL_BUFFER + 1];	/* input buffer (+ room for terminating NUL) */
+};
+
+static const char* jsonl_spaces(const char* p)
+{
+	while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+	return p;
+}
+
+/*!
+ * \brief Skips a JSON string.
+ *
+ * \returns pointer past the closing quote, NULL - unterminated string
+ */
+static const char* jsonl_string(const char* p)
+{
+	for (p++; *p != '"'; p++) {
+		if (*p == 0) return NULL;
+		if (*p == '\\' && *++p == 0) return NULL;
+	}
+	return p + 1;
+}
+
+/*!
+ * \brief Skips a JSON value (string, number, literal, or nested object or array).
+ *
+ * \returns pointer past the value, NULL - invalid value
+ */
+static const char* jsonl_value(const char* p)
+{
+	int depth = 0;
+
+	if (*p == '"') return jsonl_string(p);
+	if (*p != '{' && *p != '[') {
+		while (*p != 0 && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\t' && *p != '\r') p++;
+		return p;
+	}
+	for (;;) {
+		if (*p == 0) return NULL;
+		if (*p == '"') { if ((p = jsonl_string(p)) == NULL) return NULL; continue; }
+		if (*p == '{' || *p == '[') depth++;
+		else if ((*p == '}' || *p == ']') && --depth == 0) return p + 1;
+		p++;
+	}
+}
+
+/*!
+ * \brief Parses a number or a boolean literal.
+ *
+ * \returns pointer past the value, NULL - not a number
+ */
+static const char* jsonl_number(const char* p, double* v)
+{
+	char* e;
+
+	if (!strncmp(p, "true", 4)) { *v = 1; return p + 4; }
+	if (!strncmp(p, "false", 5)) { *v = 0; return p + 5; }
+	*v = strtod(p, &e);
+	return e == p ? NULL : e;
+}
+
+/*!
+ * \brief Parses a record (NUL-terminated JSON object) into row i of a block.
+ *
+ *  Fields: "value" (metric score), "width", "height", "player_width", "player_height", "hdr",
+ *  "upsampling", "device" (missing geometry fields default to command-line options), "id" (any
+ *  JSON value, copied to the output), and "stream", "duration", "end". Other fields are ignored.
+ *
+ * \returns 0 - success, -1 - invalid record
+ */
+static int jsonl_parse(const char* p, struct cli_block* b, struct cli_jsonl* j, int i, const struct cli_options* o)
+{
+	const char *key, *q;
+	char* e;
+	double v;
+	int k, len, has_value = 0;
+
+	for (k = 0; k < CLI_GEOMETRY; k++)
+		b->geometry[k][i] = o->geometry[k];
+	b->values[i] = -1;
+	j->id[i] = NULL;
+	j->stream[i] = 0;
+	j->duration[i] = 1;
+	j->end[i] = 0;
+
+	p = jsonl_spaces(p);
+	if (*p++ != '{') return -1;
+	for (p = jsonl_spaces(p); *p != '}'; ) {
+		/* key: */
+		if (*p != '"' || (q = jsonl_string(p)) == NULL) return -1;
+		key = p + 1;
+		len = (int)(q - p) - 2;
+		p = jsonl_spaces(q);
+		if (*p++ != ':') return -1;
+		p = jsonl_spaces(p);
+
+		/* value: */
+		if (len == 2 && !strncmp(key, "id", 2)) {
+			if ((q = jsonl_value(p)) == NULL || q - p > JSONL_MAX_ID) return -1;
+			j->id[i] = p;
+			j->id_len[i] = (int)(q - p);
+		} else if (len == 5 && !strncmp(key, "value", 5)) {
+			if ((q = jsonl_number(p, &v)) == NULL) return -1;
+			b->values[i] = v;
+			has_value = 1;
+		} else if (len == 6 && !strncmp(key, "stream", 6)) {
+			j->stream[i] = strtoull(p, &e, 10);	/* full 64-bit ids */
+			if (e == p || j->stream[i] == 0) return -1;
+			q = e;
+		} else if (len == 8 && !strncmp(key, "duration", 8)) {
+			if ((q = jsonl_number(p, &v)) == NULL || !(v >= 0)) return -1;
+			j->duration[i] = v;
+		} else if (len == 3 && !strncmp(key, "end", 3)) {
+			if ((q = jsonl_number(p, &v)) == NULL) return -1;
+			j->end[i] = v != 0;
+		} else {
+			for (k = 0; k < CLI_GEOMETRY; k++)
+				if ((int)strlen(jsonl_geometry_keys[k]) == len && !strncmp(key, jsonl_geometry_keys[k], len)) break;
+			if (k < CLI_GEOMETRY) {
+				if ((q = jsonl_number(p, &v)) == NULL || !(v >= INT_MIN && v <= INT_MAX)) return -1;
+				b->geometry[k][i] = (int)v;
+			} else if ((q = jsonl_value(p)) == NULL) return -1;
+		}
+
+		/* separator: */
+		p = jsonl_spaces(q);
+		if (*p == ',') p = jsonl_spaces(p + 1);
+		else if (*p != '}') return -1;
+	}
+	return has_value ? 0 : -1;
+}
+
+/*!
+ * \brief Writes error code and message, ending the output record.
+ */
+static void jsonl_error(int code)
+{
+	const char* message = code < 0 && -code < (int)(sizeof(jsonl_messages) / sizeof(jsonl_messages[0])) ? jsonl_messages[-code] : "";
+
+	printf("\"error\":%d,\"message\":\"%s\"}\n", code, *message ? message : "error");
+}
+
+/*!
+ * \brief Scores records of a micro-batch, and writes results to stdout.
+ *
+ * \returns 0 - success, -1 - write error
+ */
+static int jsonl_flush(struct cli_block* b, struct cli_jsonl* j, const struct cli_options* o)
+{
+	const struct stream_state* st;
+	struct geometry_key key;
+	int i, err;
+
+	if (b->n == 0) return 0;
+	block_mos(b, o);
+	for (i = 0; i < b->n; i++) {
+		putchar('{');
+		if (j->id[i] != NULL) printf("\"id\":%.*s,", j->id_len[i], j->id[i]);
+		if (j->status[i]) { jsonl_error(j->status[i]); continue; }
+		if (b->mos[i] < 0) { jsonl_error((int)b->mos[i]); continue; }
+		if (j->stream[i] == 0) { printf("\"mos\":%.6f}\n", b->mos[i]); continue; }
+
+		/* aggregate: */
+		key.width = b->geometry[0][i];
+		key.height = b->geometry[1][i];
+		key.player_width = b->geometry[2][i];
+		key.player_height = b->geometry[3][i];
+		key.hdr = b->geometry[4][i];
+		key.upsampling = b->geometry[5][i];
+		key.device = b->geometry[6][i];
+		if ((err = stream_add(&j->streams, j->stream[i], &key, j->duration[i], b->mos[i], &st)) != 0) { printf("\"mos\":%.6f,", b->mos[i]); jsonl_error(err); continue; }
+		printf("\"mos\":%.6f,\"stream\":%llu,\"rolling\":%.6f,\"session\":%.6f}\n", b->mos[i], j->stream[i], st->rolling, st->duration > 0 ? st->mos_sum / st->duration : st->rolling);
+		if (j->end[i]) stream_remove(&j->streams, j->stream[i]);
+		j->n_aggregated++;
+	}
+	b->n = 0;
+	if (fflush(stdout)) return -1;
+
+	/* checkpoint: */
+	if (o->checkpoint != NULL && j->n_aggregated >= o->checkpoint_every) {
+		if ((err = stream_checkpoint(&j->streams, o->checkpoint, ++j->n_checkpoints % JSONL_FULL_CHECKPOINT != 0)) != 0)
+			fprintf(stderr, "pmos_cli: cannot write checkpoint %s (error %d)\n", o->checkpoint, err);
+		j->n_aggregated = 0;
+	}
+	return 0;
+}
+
+/*!
+ * \brief Adds a record to the micro-batch, scoring it when full.
+ *
+ * \returns 0 - success, -1 - write error
+ */
+static int jsonl_record(struct cli_block* b, struct cli_jsonl* j, const char* line, int status, const struct cli_options* o)
+{
+	int i = b->n++;
+
+	if (status == 0 && jsonl_parse(line, b, j, i, o)) status = JSONL_INVALID;
+	if (status) j->id[i] = NULL;
+	j->status[i] = status;
+	return b->n == JSONL_BATCH ? jsonl_flush(b, j, o) : 0;
+}
+
+/*!
+ * \brief JSON-lines mode.
+ */
+static int mode_jsonl(struct cli_block* b, const struct cli_options* o)
+{
+	struct cli_jsonl* j;
+	char *p, *end, *nl;
+	size_t have = 0;
+	double t;
+	long n;
+	int skipping = 0, eof = 0, err = 0;
+
+	if ((j = (struct cli_jsonl*)malloc(sizeof(struct cli_jsonl))) == NULL) { fprintf(stderr, "pmos_cli: out of memory\n"); return 1; }
+	b->n = 0;
+	j->n_aggregated = j->n_checkpoints = 0;
+
+	/* stream states - restored from the last checkpoint, or empty: */
+	t = wall_clock();
+	if (o->checkpoint != NULL && (err = stream_restore(&j->streams, o->checkpoint, NULL)) == 0)
+		fprintf(stderr, "pmos_cli: restored %d streams from %s in %.3f ms\n", j->streams.n, o->checkpoint, (wall_clock() - t) * 1e3);
+	else {
+		if (err == -18) fprintf(stderr, "pmos_cli: ignoring invalid checkpoint %s\n", o->checkpoint);
+		if (err == -15 || (err = stream_table_init(&j->streams, o->n_streams, o->half_life, NULL)) != 0) {
+			fprintf(stderr, err == -15 ? "pmos_cli: out of memory\n" : "pmos_cli: invalid --streams or --half-life\n");
+			free(j);
+			return 1;
+		}
+	}
+
+	while (!eof && !err) {
+		/* blocks only when all complete records received so far have been scored and written: */
+		n = (long)read(0, j->buffer + have, (unsigned)(JSONL_BUFFER - have));
+		if (n < 0) {
+			if (errno == EINTR) continue;
+			fprintf(stderr, "pmos_cli: read error\n");
+			err = 1;
+			break;
+		}
+		eof = n == 0;
+		have += (size_t)n;
+
+		/* complete records (and the last one at the end of input): */
+		for (p = j->buffer, end = j->buffer + have; !err && p < end; p = nl + 1) {
+			if ((nl = (char*)memchr(p, '\n', (size_t)(end - p))) == NULL) {
+				if (!eof) break;
+				nl = end;
+			}
+			*nl = 0;
+			if (skipping) {
+				skipping = 0;
+				err = jsonl_record(b, j, p, JSONL_TOO_LONG, o);
+			} else if (*jsonl_spaces(p) != 0)
+				err = jsonl_record(b, j, p, 0, o);
+		}
+		if (!err) err = jsonl_flush(b, j, o);
+
+		/* keep incomplete record, or drop it if it does not fit into the buffer: */
+		if (p >= end) have = 0;
+		else if (p == j->buffer && have == JSONL_BUFFER) {
+			skipping = 1;
+			have = 0;
+		} else {
+			have = (size_t)(end - p);
+			memmove(j->buffer, p, have);
+		}
+	}
+	if (skipping && !err) err = jsonl_record(b, j, "", JSONL_TOO_LONG, o) || jsonl_flush(b, j, o);
+	if (o->checkpoint != NULL && stream_checkpoint(&j->streams, o->checkpoint, 0)) {
+		fprintf(stderr, "pmos_cli: cannot write checkpoint %s\n", o->checkpoint);
+		err = 1;
+	}
+
+	stream_table_free(&j->streams);
+	free(j);
+	return err ? 1 : 0;
+}
+
+/****************************
+ *
+ * Main:
+ *
+ ***/
+
+/*!
+ * \brief Parses integer option value (whole argument, in [lo, hi]).
+ *
+ * \returns 0 - success, -1 - invalid value
+ */
+static int parse_int(const char* s, long lo, long hi, int* v)
+{
+	char* e;
+	long x;
+
+	errno = 0;
+	x = strtol(s, &e, 10);
+	if (e == s || *e || errno || x < lo || x > hi) return -1;
+	*v = (int)x;
+	return 0;
+}
+
+/*!
+ * \brief Parses floating-point option value (whole argument, finite, in [lo, hi]).
+ *
+ * \returns 0 - success, -1 - invalid value
+ */
+static int parse_double(const char* s, double lo, double hi, double* v)
+{
+	char* e;
+	double x;
+
+	errno = 0;
+	x = strtod(s, &e);
+	if (e == s || *e || errno || !(x >= lo && x <= hi)) return -1;
+	*v = x;
+	return 0;
+}
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"usage: pmos_cli [--metric psnr|ssim|vif|vmaf] [--player-width PW] [--player-height PH]\n"
+		"                [--hdr 0|1] [--upsampling U] [--device D] [--threads N]\n"
+		"                [--streams N] [--half-life S] [--checkpoint PATH] [--checkpoint-every N]\n"
+		"                [--geometry-cache PATH]\n"
+		"                (--value V --width W --height H | --rowbinary [--chunked] | --columnar |\n"
+		"                 --logs [--queue-depth Q] [--max-decompressed MB] | --jsonl)\n");
+}
+
+int main(int argc, char* argv[])
+{
+	static const char* geometry_options[CLI_GEOMETRY] = {"--width", "--height", "--player-width", "--player-height", "--hdr", "--upsampling", "--device"};
+	struct cli_options o = {metric_psnr, -1, {0, 0, 3840, 2160, 0, upsampling_bicubic, device_tv}, 0, 0, 0, 0, 65536, 30, NULL, 100000};
+	struct cli_block* b;
+	struct geometry_store store;
+	struct viewing_context ctx;
+	double mos;
+	int i, j, err;
+
+	/* parse options: */
+	for (i = 1, err = 0; i < argc && !err; i++) {
+		for (j = 0; j < CLI_GEOMETRY; j++)
+			if (!strcmp(argv[i], geometry_options[j]) && i + 1 < argc) break;
+		if (j < CLI_GEOMETRY)
+			err = parse_int(argv[++i], 0, 65535, &o.geometry[j]);
+		else if (!strcmp(argv[i], "--metric") && i + 1 < argc) {
+			for (i++, o.metric = 0; o.metric < n_metric_types && strcmp(argv[i], metric_names[o.metric]); o.metric++);
+			err = o.metric == n_metric_types;
+		}
+		else if (!strcmp(argv[i], "--value") && i + 1 < argc) err = parse_double(argv[++i], -1e308, 1e308, &o.value);
+		else if (!strcmp(argv[i], "--threads") && i + 1 < argc) err = parse_int(argv[++i], 0, PMOS_MAX_THREADS, &o.n_threads);
+		else if (!strcmp(argv[i], "--max-decompressed") && i + 1 < argc) err = parse_int(argv[++i], 1, 4095, &o.max_decompressed);
+		else if (!strcmp(argv[i], "--queue-depth") && i + 1 < argc) err = parse_int(argv[++i], 1, INGEST_MAX_DEPTH, &o.queue_depth);
+		else if (!strcmp(argv[i], "--streams") && i + 1 < argc) err = parse_int(argv[++i], 1, 1 << 24, &o.n_streams);
+		else if (!strcmp(argv[i], "--half-life") && i + 1 < argc) err = parse_double(argv[++i], 1e-3, 1e9, &o.half_life);
+		else if (!strcmp(argv[i], "--checkpoint") && i + 1 < argc) o.checkpoint = argv[++i];
+		else if (!strcmp(argv[i], "--checkpoint-every") && i + 1 < argc) err = parse_int(argv[++i], 0, 0x7fffffff, &o.checkpoint_every);
+		else if (!strcmp(argv[i], "--geometry-cache") && i + 1 < argc) o.geometry_cache = argv[++i];
+		else if (!strcmp(argv[i], "--rowbinary")) o.mode = 1;
+		else if (!strcmp(argv[i], "--columnar")) o.mode = 2;
+		else if (!strcmp(argv[i], "--logs")) o.mode = 3;
+		else if (!strcmp(argv[i], "--jsonl")) o.mode = 4;
+		else if (!strcmp(argv[i], "--chunked")) o.chunked = 1;
+		else err = 1;
+	}
+	if (err) {
+		fprintf(stderr, "pmos_cli: invalid option %s\n", argv[i - 1]);
+		usage();
+		return 1;
+	}
+
+	/* single encoding (validated by viewing_context_init() and metric2mos()): */
+	if (o.mode == 0) {
+		if (o.value < 0 || o.geometry[0] <= 0 || o.geometry[1] <= 0) { usage(); return 1; }
+		if ((err = viewing_context_init(&ctx, o.geometry[0], o.geometry[1], o.geometry[2], o.geometry[3], o.geometry[4], o.geometry[5], o.geometry[6], NULL)) != 0
+			|| (err = (int)(mos = metric2mos(&ctx, o.metric, o.value))) < 0) {
+			fprintf(stderr, "pmos_cli: invalid parameters (error %d)\n", err);
+			return 1;
+		}
+		printf("%g\n", mos);
+		return 0;
+	}
+
+	/* streaming modes: */
+#ifdef _WIN32
+	if (o.mode != 3) {
+		_setmode(_fileno(stdin), _O_BINARY);
+		_setmode(_fileno(stdout), _O_BINARY);
+	}
+#endif
+	if (o.geometry_cache != NULL) {
+		if (geometry_store_open(&store, o.geometry_cache)) { fprintf(stderr, "pmos_cli: cannot open %s\n", o.geometry_cache); return 1; }
+		o.store = &store;
+	}
+	b = (struct cli_block*)malloc(sizeof(struct cli_block));
+	if (b == NULL) { fprintf(stderr, "pmos_cli: out of memory\n"); geometry_store_close(o.store); return 1; }
+	switch (o.mode) {
+	case 1: err = mode_rowbinary(b, &o); break;
+	case 2: err = mode_columnar(b, &o); break;
+	case 3: err = mode_logs(b, &o); break;
+	default: err = mode_jsonl(b, &o); break;
+	}
+	free(b);
+	geometry_store_close(o.store);
+	return err;
+}
+
+/* pmos_cli.c -- end of file */
@@ -0,0 +1,96 @@
+/*!
+ *  \file  pmos_codegen.c
+ *  \brief Generator of specialized scoring kernels for fixed viewing setups.
+ *
+ *  Usage: pmos_codegen config [output.c]
+ *
+ *  For a fixed device, player size, type of content and ladder of renditions, the viewing angle,
+ *  angular resolution and WR score of each rendition are constants. This tool evaluates them once,
+ *  and emits a self-contained C source (depending only on <math.h>) with per-rendition factors of
+ *  the fused model [3, formula 2] folded into tables, and a branch-free scoring loop:
+ *
+ *    double <name>_mos(int rendition, double value);
+ *    void <name>_mos_batch(const int* renditions, const double* values, double* mos, int n);
+ *
+ *  Generated functions produce the same values as metric2mos(), but do not validate their inputs
+ *  (renditions must be in [0, <NAME>_N_RENDITIONS), and scores within the range of the metric).
+ *
+ *  See pmos_config.c for the format of configuration files.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "pmos.h"
+#include "pmos_config.h"
+
+/*!
+ * \brief Writes generated source.
+ */
+static void emit(FILE* out, const char* path, const struct tool_config* c, const struct viewing_context* ctx)
+{
+	const struct fusion_params* f = fusion_model_params(c->metric);
+	char upper[64];
+	int i;
+
+	for (i = 0; c->name[i]; i++) upper[i] = (char)toupper((unsigned char)c->name[i]);
+	upper[i] = 0;
+
+	fprintf(out, "/*\n * %s.c -- MOS scoring kernel generated by pmos_codegen from %s.\n *\n", c->name, path);
+	fprintf(out, " * metric = %s, device = %s, hdr = %d, upsampling = %s, player = %dx%d\n", config_metric_names[c->metric], config_device_names[c->device], c->hdr, config_upsampling_names[c->upsampling], c->player_width, c->player_height);
+	fprintf(out, " *\n * Inputs are not validated: renditions must be in [0, %s_N_RENDITIONS), and %s scores within the range of the metric.\n */\n\n", upper, config_metric_names[c->metric]);
+	fprintf(out, "#include <math.h>\n\n#define %s_N_RENDITIONS %d\n\n", upper, c->n);
+
+	/* per-rendition factors of fused model: b = beta * (1 + gamma * Qwr), d = delta * Qwr */
+	fprintf(out, "/* rendition:          phi [deg], u [cpd], Qwr */\n");
+	for (i = 0; i < c->n; i++)
+		fprintf(out, "/* %2d: %4dx%-4d  ->  %.4f, %.4f, %.4f */\n", i, c->widths[i], c->heights[i], ctx[i].phi, ctx[i].u, ctx[i].qwr);
+	fprintf(out, "\nstatic const double %s_b[%s_N_RENDITIONS] = {\n", c->name, upper);
+	for (i = 0; i < c->n; i++)
+		fprintf(out, "\t%.17g,\n", f->beta * (1 + f->gamma * ctx[i].qwr));
+	fprintf(out, "};\n\nstatic const double %s_d[%s_N_RENDITIONS] = {\n", c->name, upper);
+	for (i = 0; i < c->n; i++)
+		fprintf(out, "\t%.17g,\n", f->delta * ctx[i].qwr);
+	fprintf(out, "};\n\n");
+
+	/* scoring function: */
+	fprintf(out, "double %s_mos(int rendition, double value)\n{\n", c->name);
+	if (c->metric == metric_vmaf)
+		fprintf(out, "\tdouble q = value;\n");
+	else
+		fprintf(out, "\tdouble q = 1.0 / (1.0 + exp(-%.17g * (value - %.17g)));\n", f->epsilon, f->zeta);
+	fprintf(out, "\tdouble m = %.17g + %s_b[rendition] * q + %s_d[rendition];\n", f->alpha, c->name, c->name);
+	fprintf(out, "\tm = m < 1 ? 1 : m;\n\treturn m > 5 ? 5 : m;\n}\n\n");
+
+	fprintf(out, "void %s_mos_batch(const int* renditions, const double* values, double* mos, int n)\n{\n", c->name);
+	fprintf(out, "\tint i;\n\tfor (i = 0; i < n; i++)\n\t\tmos[i] = %s_mos(renditions[i], values[i]);\n}\n", c->name);
+}
+
+int main(int argc, char* argv[])
+{
+	static struct viewing_context ctx[CONFIG_MAX_RENDITIONS];
+	static struct tool_config c;
+	FILE* out = stdout;
+
+	if (argc < 2 || argc > 3) {
+		fprintf(stderr, "usage: pmos_codegen config [output.c]\n");
+		return 1;
+	}
+	if (tool_config_read(argv[1], &c) || tool_config_contexts(&c, ctx)) return 1;
+
+	if (argc == 3 && (out = fopen(argv[2], "w")) == NULL) {
+		fprintf(stderr, "pmos_codegen: cannot create %s\n", argv[2]);
+		return 1;
+	}
+	emit(out, argv[1], &c, ctx);
+	if (out != stdout) fclose(out);
+	return 0;
+}
+
+/* pmos_codegen.c -- end of file */
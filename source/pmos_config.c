@@ -0,0 +1,171 @@
+/*!
+ *  \file  pmos_config.c
+ *  \brief Configuration files of command-line tools (fixed viewing setup and ladder of renditions).
+ *
+ *  Configuration file consists of "key = value" lines ('#' starts a comment):
+ *
+ *    name = tv_sdr_4k                 prefix of generated identifiers
+ *    metric = psnr                    psnr | ssim | vif | vmaf
+ *    device = tv                      mobile | tablet | pc | tv | custom
+ *    display = 3840x2160              custom device: display resolution
+ *    ppi = 80.1                       custom device: pixel density [ppi] (horizontal, vertical assumed equal)
+ *    distance = 3 heights             custom device: viewing distance [heights | inches]
+ *    hdr = 0                          0 | 1
+ *    upsampling = bicubic             bicubic | nn | sr
+ *    player = 3840x2160               player size
+ *    rendition = 1920x1080            one line per rendition (in order of indices)
+ *    tolerance = 0.01                 max error of surrogate models [MOS]
+ *    value_column = psnr              column names used in generated SQL expressions
+ *    rendition_column = rendition
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "pmos.h"
+#include "pmos_config.h"
+
+/*! Names of enumerated values (in the order of enums in pmos.h): */
+const char* config_metric_names[] = {"psnr", "ssim", "vif", "vmaf", NULL};
+const char* config_device_names[] = {"mobile", "tablet", "pc", "tv", "custom", NULL};
+const char* config_upsampling_names[] = {"bicubic", "nn", "sr", NULL};
+static const char* distance_units[] = {"inches", "heights", NULL};
+
+/*!
+ * \brief Finds value in a list of names (-1 - not found).
+ */
+static int lookup(const char* value, const char** names)
+{
+	int i;
+	for (i = 0; names[i] != NULL; i++)
+		if (!strcmp(value, names[i])) return i;
+	return -1;
+}
+
+/*!
+ * \brief Removes leading and trailing whitespace.
+ */
+static char* trim(char* s)
+{
+	char* e;
+	while (isspace((unsigned char)*s)) s++;
+	for (e = s + strlen(s); e > s && isspace((unsigned char)e[-1]); e--);
+	*e = 0;
+	return s;
+}
+
+/*!
+ * \brief Copies identifier (letters, digits, underscores, not starting with a digit).
+ *
+ * \returns 1 - success, 0 - invalid identifier
+ */
+static int identifier(char* dst, const char* value)
+{
+	const char* p;
+	for (p = value; *p && (isalnum((unsigned char)*p) || *p == '_'); p++);
+	if (*p != 0 || p == value || p - value >= 64 || isdigit((unsigned char)*value)) return 0;
+	strcpy(dst, value);
+	return 1;
+}
+
+/*!
+ * \brief Reads configuration file.
+ *
+ * \returns 0 - success, -1 - error (reported to stderr)
+ */
+int tool_config_read(const char* path, struct tool_config* c)
+{
+	char line[256], unit[16], *key, *value, *p;
+	int line_no = 0, ok;
+	FILE* f;
+
+	/* defaults: */
+	memset(c, 0, sizeof(*c));
+	strcpy(c->name, "pmos_kernel");
+	strcpy(c->value_column, "value");
+	strcpy(c->rendition_column, "rendition");
+	c->device = device_tv;
+	c->player_width = 3840;
+	c->player_height = 2160;
+	c->tolerance = 0.01;
+
+	if ((f = fopen(path, "r")) == NULL) {
+		fprintf(stderr, "cannot open %s\n", path);
+		return -1;
+	}
+	while (fgets(line, sizeof(line), f) != NULL) {
+		line_no++;
+		if ((p = strchr(line, '#')) != NULL) *p = 0;
+		if ((p = strchr(line, '=')) == NULL) {
+			if (*trim(line)) goto syntax;
+			continue;
+		}
+		*p = 0;
+		key = trim(line);
+		value = trim(p + 1);
+
+		if (!strcmp(key, "name")) ok = identifier(c->name, value);
+		else if (!strcmp(key, "value_column")) ok = identifier(c->value_column, value);
+		else if (!strcmp(key, "rendition_column")) ok = identifier(c->rendition_column, value);
+		else if (!strcmp(key, "metric")) ok = (c->metric = lookup(value, config_metric_names)) >= 0;
+		else if (!strcmp(key, "device")) ok = (c->device = lookup(value, config_device_names)) >= 0;
+		else if (!strcmp(key, "upsampling")) ok = (c->upsampling = lookup(value, config_upsampling_names)) >= 0;
+		else if (!strcmp(key, "hdr")) ok = sscanf(value, "%d", &c->hdr) == 1;
+		else if (!strcmp(key, "player")) ok = sscanf(value, "%dx%d", &c->player_width, &c->player_height) == 2;
+		else if (!strcmp(key, "display")) ok = sscanf(value, "%dx%d", &c->params.display_width, &c->params.display_height) == 2;
+		else if (!strcmp(key, "tolerance")) ok = sscanf(value, "%lf", &c->tolerance) == 1 && c->tolerance > 0;
+		else if (!strcmp(key, "ppi")) {
+			ok = sscanf(value, "%lf", &c->params.ppi_x) == 1;
+			c->params.ppi_y = c->params.ppi_x;
+		}
+		else if (!strcmp(key, "distance")) {
+			ok = sscanf(value, "%lf %15s", &c->params.distance, unit) == 2;
+			if (ok) ok = (c->params.distance_type = lookup(unit, distance_units)) >= 0;
+		}
+		else if (!strcmp(key, "rendition")) {
+			ok = c->n < CONFIG_MAX_RENDITIONS && sscanf(value, "%dx%d", &c->widths[c->n], &c->heights[c->n]) == 2;
+			if (ok) c->n++;
+		}
+		else ok = 0;
+		if (!ok) goto syntax;
+	}
+	fclose(f);
+
+	if (c->n == 0) {
+		fprintf(stderr, "%s: no renditions\n", path);
+		return -1;
+	}
+	return 0;
+
+syntax:
+	fprintf(stderr, "%s:%d: invalid line\n", path, line_no);
+	fclose(f);
+	return -1;
+}
+
+/*!
+ * \brief Computes viewing contexts of all renditions.
+ *
+ * \returns 0 - success, -1 - error (reported to stderr)
+ */
+int tool_config_contexts(const struct tool_config* c, struct viewing_context* ctx)
+{
+	int i, err;
+
+	for (i = 0; i < c->n; i++) {
+		err = viewing_context_init(&ctx[i], c->widths[i], c->heights[i], c->player_width, c->player_height, c->hdr, c->upsampling, c->device, (struct device_params*)&c->params);
+		if (err) {
+			fprintf(stderr, "rendition %dx%d: invalid viewing setup (error %d)\n", c->widths[i], c->heights[i], err);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/* pmos_config.c -- end of file */
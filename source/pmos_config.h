@@ -0,0 +1,46 @@
+/*!
+ *  \file  pmos_config.h
+ *  \brief Configuration files of command-line tools (fixed viewing setup and ladder of renditions).
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _PMOS_CONFIG_H_
+#define _PMOS_CONFIG_H_ 1
+#include "pmos.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CONFIG_MAX_RENDITIONS  64	/* max number of renditions */
+
+/*! Configuration: */
+struct tool_config {
+	char name[64];				/* prefix of generated identifiers */
+	int metric, device, hdr, upsampling;
+	struct device_params params;		/* custom device parameters */
+	int player_width, player_height;
+	int n;					/* number of renditions */
+	int widths[CONFIG_MAX_RENDITIONS], heights[CONFIG_MAX_RENDITIONS];
+	double tolerance;			/* max error of surrogate models [MOS] */
+	char value_column[64];			/* name of metric column (in generated SQL) */
+	char rendition_column[64];		/* name of rendition index column (in generated SQL) */
+};
+
+/*! Names of enumerated values: */
+extern const char* config_metric_names[];
+extern const char* config_device_names[];
+extern const char* config_upsampling_names[];
+
+/*! Function prototypes: */
+int tool_config_read(const char* path, struct tool_config* c);
+int tool_config_contexts(const struct tool_config* c, struct viewing_context* ctx);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,172 @@
+/*!
+ *  \file  pmos_decompress.c
+ *  \brief Decompression of gzip and zstd compressed logs.
+ *
+ *  Compressed data are recognized by magic numbers, and decompressed in DECOMPRESS_CHUNK chunks
+ *  into a growable buffer, which is reused across calls (e.g. one per ingestion thread, see
+ *  pmos_ingest.c), so that parsers get decompressed text without intermediate files.
+ *
+ *  gzip support requires zlib (compile with PMOS_ZLIB, link with -lz), and zstd support requires
+ *  libzstd (compile with PMOS_ZSTD, link with -lzstd). Concatenated gzip members and zstd frames
+ *  (e.g. produced by pzstd or zstd -T) are decompressed in sequence.
+ *
+ *  The size of decompressed data is limited (see decompress_buffer::max_size), so that small
+ *  malicious inputs (decompression bombs) cannot exhaust memory: output chunks are clipped at
+ *  the limit, and decompression stops as soon as it is exceeded.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "pmos_decompress.h"
+
+#ifdef PMOS_ZLIB
+#include <zlib.h>
+#endif
+#ifdef PMOS_ZSTD
+#include <zstd.h>
+#endif
+
+/*!
+ * \brief Detects compression format by magic number.
+ *
+ * \param[in]  data			data
+ * \param[in]  size			size of data [bytes]
+ *
+ * \returns    compression format (see enum compression_types)
+ */
+int compression_type(const void* data, size_t size)
+{
+	const unsigned char* p = (const unsigned char*)data;
+
+	if (p == NULL) return compression_none;
+	if (size >= 2 && p[0] == 0x1f && p[1] == 0x8b) return compression_gzip;
+	if (size >= 4 && p[0] == 0x28 && p[1] == 0xb5 && p[2] == 0x2f && p[3] == 0xfd) return compression_zstd;
+	return compression_none;
+}
+
+/*! Limit on size of decompressed data: */
+#define max_output(out)  ((out)->max_size ? (out)->max_size : DECOMPRESS_MAX_SIZE)
+
+/*!
+ * \brief Ensures room for one more chunk (and terminating NUL) in the buffer.
+ *
+ *  The chunk is clipped to one byte past the size limit, so that exceeding it is detected,
+ *  and the buffer never grows beyond the limit + 2 bytes.
+ *
+ * \param[in,out] out		output buffer
+ * \param[out] p_chunk		size of the chunk [bytes]
+ *
+ * \returns 0 - success, -3 - out of memory, -4 - size limit exceeded
+ */
+static int buffer_grow(struct decompress_buffer* out, size_t* p_chunk)
+{
+	size_t limit = max_output(out), chunk, need, capacity = out->capacity ? out->capacity : 4 * DECOMPRESS_CHUNK;
+	char* data;
+
+	if (out->size > limit) return -4;
+	chunk = limit - out->size < DECOMPRESS_CHUNK ? limit - out->size + 1 : DECOMPRESS_CHUNK;
+	need = out->size + chunk + 1;
+	*p_chunk = chunk;
+	if (need <= out->capacity) return 0;
+	while (capacity < need) capacity *= 2;
+	if (capacity - 2 > limit) capacity = limit + 2;
+	if ((data = (char*)realloc(out->data, capacity)) == NULL) return -3;
+	out->data = data;
+	out->capacity = capacity;
+	return 0;
+}
+
+#ifdef PMOS_ZLIB
+static int decompress_gzip(const void* data, size_t size, struct decompress_buffer* out)
+{
+	z_stream z;
+	size_t chunk;
+	int err = Z_OK, ret;
+
+	memset(&z, 0, sizeof(z));
+	if (inflateInit2(&z, 15 + 16) != Z_OK) return -3;
+	z.next_in = (Bytef*)data;
+	z.avail_in = (uInt)size;
+	while (err == Z_OK) {
+		if ((ret = buffer_grow(out, &chunk)) != 0) { inflateEnd(&z); return ret; }
+		z.next_out = (Bytef*)out->data + out->size;
+		z.avail_out = (uInt)chunk;
+		err = inflate(&z, Z_NO_FLUSH);
+		out->size += chunk - z.avail_out;
+
+		/* next member: */
+		if (err == Z_STREAM_END && z.avail_in >= 2 && z.next_in[0] == 0x1f && z.next_in[1] == 0x8b)
+			err = inflateReset(&z);
+	}
+	inflateEnd(&z);
+	return err == Z_STREAM_END ? 0 : err == Z_MEM_ERROR ? -3 : -2;
+}
+#endif
+
+#ifdef PMOS_ZSTD
+static int decompress_zstd(const void* data, size_t size, struct decompress_buffer* out)
+{
+	ZSTD_DCtx* dctx;
+	ZSTD_inBuffer in;
+	ZSTD_outBuffer o;
+	size_t ret = 1, chunk;
+	int err;
+
+	if ((dctx = ZSTD_createDCtx()) == NULL) return -3;
+	in.src = data;
+	in.size = size;
+	in.pos = 0;
+	while (in.pos < in.size || ret != 0) {
+		if ((err = buffer_grow(out, &chunk)) != 0) { ZSTD_freeDCtx(dctx); return err; }
+		o.dst = out->data + out->size;
+		o.size = chunk;
+		o.pos = 0;
+		ret = ZSTD_decompressStream(dctx, &o, &in);
+		out->size += o.pos;
+		if (ZSTD_isError(ret) || (in.pos == in.size && ret != 0 && o.pos == 0)) { ZSTD_freeDCtx(dctx); return -2; }	/* corrupted or truncated */
+	}
+	ZSTD_freeDCtx(dctx);
+	return 0;
+}
+#endif
+
+/*!
+ * \brief Decompresses gzip or zstd data into a buffer.
+ *
+ * \param[in]  data			compressed data
+ * \param[in]  size			size of compressed data [bytes]
+ * \param[in,out] out		output buffer (contents are replaced, memory is reused)
+ *
+ * \returns    0				success
+ *			  -1				compression format is not recognized or not supported by this build
+ *			  -2				corrupted or truncated data
+ *			  -3				out of memory
+ *			  -4				decompressed data exceed the size limit (out->max_size)
+ */
+int decompress(const void* data, size_t size, struct decompress_buffer* out)
+{
+	int err = -1;
+
+	if (out == NULL) return -1;
+	out->size = 0;
+	switch (compression_type(data, size)) {
+#ifdef PMOS_ZLIB
+	case compression_gzip: err = decompress_gzip(data, size, out); break;
+#endif
+#ifdef PMOS_ZSTD
+	case compression_zstd: err = decompress_zstd(data, size, out); break;
+#endif
+	default: break;
+	}
+	if (err == 0 && out->size > max_output(out)) err = -4;
+	if (err == 0) out->data[out->size] = 0;
+	return err;
+}
+
+/* pmos_decompress.c -- end of file */
@@ -0,0 +1,45 @@
+/*!
+ *  \file  pmos_decompress.h
+ *  \brief Decompression of gzip and zstd compressed logs.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _PMOS_DECOMPRESS_H_
+#define _PMOS_DECOMPRESS_H_ 1
+#include <stddef.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DECOMPRESS_CHUNK  65536	/* size of output chunks [bytes] */
+#define DECOMPRESS_MAX_SIZE  ((size_t)1 << 30)	/* default limit on size of decompressed data [bytes] */
+
+/*! Compression formats: */
+enum compression_types {
+	compression_none = 0,		/* not compressed */
+	compression_gzip,		/* gzip (RFC 1952), possibly with multiple members */
+	compression_zstd,		/* zstd, possibly with multiple frames */
+	n_compression_types		/* the number of compression formats defined by this enum */
+};
+
+/*! Growable output buffer: */
+struct decompress_buffer {
+	char* data;			/* decompressed data, NUL-terminated */
+	size_t size;			/* size of decompressed data [bytes] */
+	size_t capacity;		/* size of allocated memory [bytes] */
+	size_t max_size;		/* limit on size of decompressed data [bytes] (0 - DECOMPRESS_MAX_SIZE) */
+};
+
+/*! Function prototypes: */
+int compression_type(const void* data, size_t size);
+int decompress(const void* data, size_t size, struct decompress_buffer* out);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
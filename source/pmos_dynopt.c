@@ -0,0 +1,254 @@
+/*!
+ *  \file  pmos_dynopt.c
+ *  \brief Shot-based dynamic optimizer using device-specific MOS as quality measure.
+ *
+ *  This code implements a variant of the dynamic optimizer [1], in which quality of each operating point
+ *  is measured by MOS predicted for a target device [2], rather than by the full-reference metric itself:
+ *
+ *   - each shot is encoded at several resolutions and QPs (operating points), with known sizes and metric scores;
+ *   - metric scores are mapped to MOS for the target device, and weighted by shot durations;
+ *   - convex hull of (bits, quality) points is built for each shot (in parallel);
+ *   - Lagrangian optimization over all shots is performed by sweeping the Lagrange multiplier from infinity
+ *     down to 0: segments of all convex hulls are merged in the order of decreasing slopes, and the choice
+ *     in a shot advances to the next hull point when the sweep passes the slope of its segment. The sweep
+ *     stops when target bitrate would be exceeded, or when target MOS is reached.
+ *
+ *    [1] I. Katsavounidis, "Dynamic optimizer - a perceptual video encoding optimization framework," Netflix Technology Blog, March 2018.
+ *    [2] N. Barman, R. Vanam, Y. Reznik, "Parametric Quality Models for Multiscreen Video Systems," EUVIP'22, September 11-14, 2022.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include "pmos.h"
+#include "pmos_thread.h"
+#include "pmos_dynopt.h"
+
+/*! Segment of a convex hull: */
+struct hull_segment {
+	double slope;			/* quality gain per bit */
+	int shot;			/* shot index */
+};
+
+/*! Convex hull construction job: */
+struct hull_job {
+	const struct dynopt* d;
+	const struct shot* shots;
+	const int* offset;		/* offsets of shots in arrays below */
+	int* index;			/* indices of hull points */
+	double* bits;			/* sizes of hull points [bits] */
+	double* quality;		/* qualities of hull points (duration x MOS) */
+	int* n_hull;			/* numbers of points in hulls, <0 - error */
+};
+
+/*!
+ *  \brief Builds convex hulls of shots [begin, end).
+ */
+static void build_hulls(void* arg, int begin, int end)
+{
+	struct hull_job* job = (struct hull_job*)arg;
+	const struct dynopt* d = job->d;
+	const struct shot* sh;
+	const struct shot_point* p;
+	double *b, *q, bk, qk, mos;
+	int *h, s, i, j, k, m, n, ik;
+
+	for (s = begin; s < end; s++) {
+		sh = &job->shots[s];
+		h = job->index + job->offset[s];
+		b = job->bits + job->offset[s];
+		q = job->quality + job->offset[s];
+
+		/* map valid operating points to (bits, quality), sorted by bits (and quality, in the reverse order): */
+		for (i = 0, m = 0; i < sh->n_points; i++) {
+			p = &sh->points[i];
+			if (p->resolution < 0 || p->resolution >= d->n_resolutions || d->status[p->resolution]) continue;
+			if (!(p->bits > 0)) continue;
+			mos = metric2mos(&d->ctx[p->resolution], d->metric, p->metric);
+			if (mos < 0) continue;
+			bk = p->bits;
+			qk = sh->duration * mos;
+			for (j = m; j > 0 && (b[j - 1] > bk || (b[j - 1] == bk && q[j - 1] < qk)); j--) {
+				h[j] = h[j - 1];
+				b[j] = b[j - 1];
+				q[j] = q[j - 1];
+			}
+			h[j] = i;
+			b[j] = bk;
+			q[j] = qk;
+			m++;
+		}
+
+		/* upper convex hull, starting from the smallest point (built in place): */
+		for (k = 0, n = 0; k < m; k++) {
+			ik = h[k]; bk = b[k]; qk = q[k];
+			if (n && qk <= q[n - 1]) continue;
+			while (n >= 2 && (q[n - 1] - q[n - 2]) * (bk - b[n - 2]) <= (qk - q[n - 2]) * (b[n - 1] - b[n - 2])) n--;
+			h[n] = ik;
+			b[n] = bk;
+			q[n] = qk;
+			n++;
+		}
+
+		job->n_hull[s] = n ? n : -13;
+	}
+}
+
+/*!
+ *  \brief Orders hull segments by decreasing slopes (ties - by shot indices).
+ */
+static int compare_segments(const void* a, const void* b)
+{
+	const struct hull_segment* sa = (const struct hull_segment*)a;
+	const struct hull_segment* sb = (const struct hull_segment*)b;
+
+	if (sa->slope > sb->slope) return -1;
+	if (sa->slope < sb->slope) return 1;
+	return sa->shot - sb->shot;
+}
+
+/*!
+ * \brief Initializes dynamic optimizer for a given target device and set of encoding resolutions.
+ *
+ * \param[out] d				dynamic optimizer
+ * \param[in]  metric			metric type (see enum metric_types)
+ * \param[in]  setup			target viewing setup (device and player parameters)
+ * \param[in]  widths			widths of encoding resolutions [pixels]
+ * \param[in]  heights			heights of encoding resolutions [pixels]
+ * \param[in]  n_resolutions	number of encoding resolutions (<= DYNOPT_MAX_RESOLUTIONS)
+ * \param[in]  n_threads		number of threads used to build convex hulls (0 - all cores)
+ *
+ * \returns    0				success
+ *			  -6				NULL pointer
+ *			  -10				invalid metric type
+ *			  -12				invalid number of resolutions or threads
+ */
+int dynopt_init(struct dynopt* d, int metric, const struct viewing_setup* setup, const int* widths, const int* heights, int n_resolutions, int n_threads)
+{
+	int r;
+
+	/* check parameters */
+	if (d == NULL || setup == NULL || widths == NULL || heights == NULL) return -6;
+	if (metric < 0 || metric >= n_metric_types) return -10;
+	if (n_resolutions < 1 || n_resolutions > DYNOPT_MAX_RESOLUTIONS || n_threads < 0) return -12;
+
+	d->metric = metric;
+	d->n_resolutions = n_resolutions;
+	d->n_threads = n_threads;
+
+	/* compute viewing contexts for all resolutions: */
+	for (r = 0; r < n_resolutions; r++)
+		d->status[r] = viewing_context_init(&d->ctx[r], widths[r], heights[r], setup->player_width, setup->player_height, setup->hdr, setup->upsampling, setup->device, setup->params);
+
+	return 0;
+}
+
+/*!
+ * \brief Selects operating points of all shots reaching target bitrate or target MOS.
+ *
+ * \param[in]  d				dynamic optimizer (see dynopt_init())
+ * \param[in]  shots			shots
+ * \param[in]  n_shots			number of shots
+ * \param[in]  target_type		optimization target (see enum dynopt_targets)
+ * \param[in]  target			target average bitrate [bits/s] or target time-weighted MOS
+ * \param[out] choices			indices of selected operating points in each shot [n_shots]
+ * \param[out] result			totals for selected operating points
+ *
+ * \returns    0				success (if target cannot be reached, the closest solution is returned, see result->reached)
+ *			  -6				NULL pointer
+ *			  -12				invalid number of shots or target type
+ *			  -13				invalid shot, or shot without valid operating points
+ *			  -15				memory allocation failure
+ */
+int dynopt_optimize(const struct dynopt* d, const struct shot* shots, int n_shots, int target_type, double target, int* choices, struct dynopt_result* result)
+{
+	struct hull_job job;
+	struct hull_segment* segs = NULL;
+	int *offset = NULL, *pos = NULL;
+	double duration = 0, bits = 0, quality = 0, budget, db;
+	int s, j, k, n_segs, total, err = 0;
+
+	/* check parameters */
+	if (d == NULL || shots == NULL || choices == NULL || result == NULL) return -6;
+	if (n_shots < 1 || (target_type != dynopt_target_bitrate && target_type != dynopt_target_mos)) return -12;
+	for (s = 0, total = 0; s < n_shots; s++) {
+		if (shots[s].points == NULL) return -6;
+		if (shots[s].n_points < 1 || !(shots[s].duration > 0)) return -13;
+		total += shots[s].n_points;
+		duration += shots[s].duration;
+	}
+
+	/* allocate memory: */
+	offset = (int*)malloc((2 * n_shots + 1) * sizeof(int));
+	job.index = (int*)malloc(total * sizeof(int));
+	job.bits = (double*)malloc(total * sizeof(double));
+	job.quality = (double*)malloc(total * sizeof(double));
+	segs = (struct hull_segment*)malloc(total * sizeof(struct hull_segment));
+	if (offset == NULL || job.index == NULL || job.bits == NULL || job.quality == NULL || segs == NULL) {
+		err = -15;
+		goto cleanup;
+	}
+	job.n_hull = offset + n_shots + 1;
+	pos = job.n_hull;
+
+	/* build convex hulls of all shots (in parallel): */
+	for (s = 0, offset[0] = 0; s < n_shots; s++)
+		offset[s + 1] = offset[s] + shots[s].n_points;
+	job.d = d;
+	job.shots = shots;
+	job.offset = offset;
+	parallel_for(n_shots, d->n_threads, build_hulls, &job);
+
+	/* start from the smallest hull points, and collect segments of all hulls: */
+	for (s = 0, n_segs = 0; s < n_shots; s++) {
+		k = offset[s];
+		if (job.n_hull[s] < 0) { err = job.n_hull[s]; goto cleanup; }
+		for (j = 1; j < job.n_hull[s]; j++) {
+			segs[n_segs].slope = (job.quality[k + j] - job.quality[k + j - 1]) / (job.bits[k + j] - job.bits[k + j - 1]);
+			segs[n_segs].shot = s;
+			n_segs++;
+		}
+		bits += job.bits[k];
+		quality += job.quality[k];
+		pos[s] = 0;	/* (replaces number of hull points, which is no longer needed) */
+	}
+
+	/* Lagrangian sweep over segments in the order of decreasing slopes: */
+	qsort(segs, n_segs, sizeof(struct hull_segment), compare_segments);
+	budget = target * duration;
+	result->reached = target_type == dynopt_target_bitrate ? bits <= budget : quality >= target * duration;
+	for (j = 0; j < n_segs; j++) {
+		s = segs[j].shot;
+		k = offset[s] + pos[s];
+		db = job.bits[k + 1] - job.bits[k];
+		if (target_type == dynopt_target_bitrate && bits + db > budget) break;
+		if (target_type == dynopt_target_mos && quality >= target * duration) break;
+		bits += db;
+		quality += job.quality[k + 1] - job.quality[k];
+		pos[s]++;
+	}
+	if (target_type == dynopt_target_mos)
+		result->reached = quality >= target * duration;
+
+	/* store the results: */
+	for (s = 0; s < n_shots; s++)
+		choices[s] = job.index[offset[s] + pos[s]];
+	result->bits = bits;
+	result->bitrate = bits / duration;
+	result->mos = quality / duration;
+
+cleanup:
+	free(offset);
+	free(job.index);
+	free(job.bits);
+	free(job.quality);
+	free(segs);
+	return err;
+}
+
+/* pmos_dynopt.c -- end of file */
@@ -0,0 +1,66 @@
+/*!
+ *  \file  pmos_dynopt.h
+ *  \brief Shot-based dynamic optimizer using device-specific MOS as quality measure.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _PMOS_DYNOPT_H_
+#define _PMOS_DYNOPT_H_ 1
+#include "pmos.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DYNOPT_MAX_RESOLUTIONS  16	/* max number of encoding resolutions */
+
+/*! Operating point - encoding of a shot at some resolution and QP: */
+struct shot_point {
+	int resolution;			/* index of encoding resolution (see dynopt_init()) */
+	double qp;			/* quantization parameter (informative) */
+	double bits;			/* size of encoded shot [bits] */
+	double metric;			/* metric score */
+};
+
+/*! Shot: */
+struct shot {
+	double duration;		/* shot duration [s] */
+	int n_points;			/* number of operating points */
+	const struct shot_point* points;	/* operating points */
+};
+
+/*! Dynamic optimizer - viewing contexts for target device, cached per encoding resolution: */
+struct dynopt {
+	int metric;						/* metric type (see enum metric_types) */
+	int n_resolutions;					/* number of encoding resolutions */
+	int n_threads;						/* number of threads used to build convex hulls (0 - all cores) */
+	struct viewing_context ctx[DYNOPT_MAX_RESOLUTIONS];	/* viewing contexts */
+	int status[DYNOPT_MAX_RESOLUTIONS];			/* 0 - valid viewing setup, <0 - error */
+};
+
+/*! Optimization targets: */
+enum dynopt_targets {
+	dynopt_target_bitrate = 0,	/* highest MOS at average bitrate not exceeding target */
+	dynopt_target_mos		/* lowest average bitrate reaching target time-weighted MOS */
+};
+
+/*! Optimization result: */
+struct dynopt_result {
+	double bits;			/* total size of encoded title [bits] */
+	double bitrate;			/* average bitrate [bits/s] */
+	double mos;			/* time-weighted average MOS */
+	int reached;			/* indicator if target was reached (1) or not (0) */
+};
+
+/*! Function prototypes: */
+int dynopt_init(struct dynopt* d, int metric, const struct viewing_setup* setup, const int* widths, const int* heights, int n_resolutions, int n_threads);
+int dynopt_optimize(const struct dynopt* d, const struct shot* shots, int n_shots, int target_type, double target, int* choices, struct dynopt_result* result);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,176 @@
+/*!
+ *  \file  pmos_ensemble.c
+ *  \brief Ensemble MOS predictions combining fused models for several metrics.
+ *
+ *  When several metric scores are available for the same encoding, all fused models [3] share
+ *  the same WR score, computed once in a viewing context. Individual MOS predictions are then
+ *  combined as a weighted average, with weights renormalized over metrics that are present:
+ *
+ *    MOS = sum_m w_m MOS_m / sum_m w_m.
+ *
+ *  Weights can be fit to subjective scores by ensemble_fit(), which minimizes squared error
+ *  subject to w_m >= 0, sum_m w_m = 1 (by solving equality-constrained problems over all
+ *  subsets of metrics and keeping the best feasible solution).
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#include <stddef.h>
+#include <math.h>
+#include "pmos.h"
+#include "pmos_ensemble.h"
+
+/*!
+ * \brief Computes MOS using fused models for all given metrics, and their weighted combination.
+ *
+ * \param[in]  ctx			viewing context (see viewing_context_init())
+ * \param[in]  mask			metrics present (bitwise OR of METRIC_MASK() values)
+ * \param[in]  values			metric scores, indexed by metric type (only present ones are used)
+ * \param[in]  weights		weights of individual models (NULL - equal weights)
+ * \param[out] mos			MOS predicted by individual models, indexed by metric type (may be NULL)
+ * \param[out] p_combined		combined MOS prediction
+ *
+ * \returns    0				success
+ *			  -6				NULL pointer
+ *			  -9				invalid metric score
+ *			  -10				invalid mask
+ *			  -12				all metrics present have zero weights
+ */
+int ensemble_mos(const struct viewing_context* ctx, unsigned int mask, const double* values, const struct ensemble_weights* weights, double* mos, double* p_combined)
+{
+	double m, w, sum = 0, sum_w = 0;
+	int metric;
+
+	/* check parameters: */
+	if (ctx == NULL || values == NULL || p_combined == NULL) return -6;
+	if (mask == 0 || (mask & ~ALL_METRICS)) return -10;
+
+	for (metric = 0; metric < n_metric_types; metric++) {
+		if (!(mask & METRIC_MASK(metric))) continue;
+
+		/* individual model: */
+		m = metric2mos(ctx, metric, values[metric]);
+		if (m < 0) return (int)m;
+		if (mos != NULL) mos[metric] = m;
+
+		/* accumulate weighted sum: */
+		w = weights ? weights->w[metric] : 1;
+		sum += w * m;
+		sum_w += w;
+	}
+
+	if (!(sum_w > 0)) return -12;
+	*p_combined = sum / sum_w;
+	return 0;
+}
+
+/*!
+ * \brief Solves linear system a * x = b (n <= n_metric_types + 1) by Gaussian elimination with partial pivoting.
+ *
+ * \returns 0 - success, -1 - singular matrix
+ */
+static int solve(double a[n_metric_types + 1][n_metric_types + 1], double* b, double* x, int n)
+{
+	double t;
+	int i, j, k, p;
+
+	for (k = 0; k < n; k++) {
+		/* find pivot: */
+		for (p = k, i = k + 1; i < n; i++)
+			if (fabs(a[i][k]) > fabs(a[p][k])) p = i;
+		if (fabs(a[p][k]) < 1e-12) return -1;
+		if (p != k) {
+			for (j = 0; j < n; j++) { t = a[k][j]; a[k][j] = a[p][j]; a[p][j] = t; }
+			t = b[k]; b[k] = b[p]; b[p] = t;
+		}
+		/* eliminate: */
+		for (i = k + 1; i < n; i++) {
+			t = a[i][k] / a[k][k];
+			for (j = k; j < n; j++) a[i][j] -= t * a[k][j];
+			b[i] -= t * b[k];
+		}
+	}
+	/* back substitution: */
+	for (k = n - 1; k >= 0; k--) {
+		for (t = b[k], j = k + 1; j < n; j++) t -= a[k][j] * x[j];
+		x[k] = t / a[k][k];
+	}
+	return 0;
+}
+
+/*!
+ * \brief Fits weights of ensemble model to subjective scores.
+ *
+ * \param[in]  mask			metrics to use (bitwise OR of METRIC_MASK() values)
+ * \param[in]  mos			MOS predicted by individual models (n rows, n_metric_types columns, see ensemble_mos())
+ * \param[in]  true_mos		subjective scores (n values)
+ * \param[in]  n				number of samples
+ * \param[out] weights		fitted weights (zero for metrics not in the mask)
+ * \param[out] p_rms			RMS error of fitted ensemble (may be NULL)
+ *
+ * \returns    0				success
+ *			  -6				NULL pointer
+ *			  -9				no feasible weights (non-finite scores), weights are not changed
+ *			  -10				invalid mask
+ *			  -12				invalid number of samples
+ */
+int ensemble_fit(unsigned int mask, const double* mos, const double* true_mos, int n, struct ensemble_weights* weights, double* p_rms)
+{
+	double a[n_metric_types + 1][n_metric_types + 1], b[n_metric_types + 1], x[n_metric_types + 1];
+	double e, sse, best_sse = -1;
+	int idx[n_metric_types], k, i, j, s, metric;
+	unsigned int subset;
+
+	/* check parameters: */
+	if (mos == NULL || true_mos == NULL || weights == NULL) return -6;
+	if (mask == 0 || (mask & ~ALL_METRICS)) return -10;
+	if (n < 1) return -12;
+
+	/* try all non-empty subsets of the mask: */
+	for (subset = 1; subset <= mask; subset++) {
+		if (subset & ~mask) continue;
+		for (k = 0, metric = 0; metric < n_metric_types; metric++)
+			if (subset & METRIC_MASK(metric)) idx[k++] = metric;
+
+		/* KKT system of min |y - M w|^2 s.t. sum w = 1: [M'M 1; 1' 0] [w; lambda] = [M'y; 1] */
+		for (i = 0; i < k; i++) {
+			for (j = 0; j < k; j++)
+				for (a[i][j] = 0, s = 0; s < n; s++)
+					a[i][j] += mos[s * n_metric_types + idx[i]] * mos[s * n_metric_types + idx[j]];
+			for (b[i] = 0, s = 0; s < n; s++)
+				b[i] += mos[s * n_metric_types + idx[i]] * true_mos[s];
+			a[i][k] = a[k][i] = 1;
+		}
+		a[k][k] = 0;
+		b[k] = 1;
+		if (solve(a, b, x, k + 1)) continue;
+
+		/* keep only feasible solutions: */
+		for (i = 0; i < k && x[i] >= 0; i++);
+		if (i < k) continue;
+
+		/* squared error of this solution: */
+		for (sse = 0, s = 0; s < n; s++) {
+			for (e = true_mos[s], i = 0; i < k; i++)
+				e -= x[i] * mos[s * n_metric_types + idx[i]];
+			sse += e * e;
+		}
+		if (!isfinite(sse)) continue;
+		if (best_sse < 0 || sse < best_sse) {
+			best_sse = sse;
+			for (metric = 0; metric < n_metric_types; metric++) weights->w[metric] = 0;
+			for (i = 0; i < k; i++) weights->w[idx[i]] = x[i];
+		}
+	}
+
+	/* single-metric subsets have a feasible solution (w = 1), unless scores are not finite: */
+	if (best_sse < 0) return -9;
+	if (p_rms != NULL) *p_rms = sqrt(best_sse / n);
+	return 0;
+}
+
+/* pmos_ensemble.c -- end of file */
@@ -0,0 +1,34 @@
+/*!
+ *  \file  pmos_ensemble.h
+ *  \brief Ensemble MOS predictions combining fused models for several metrics.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _PMOS_ENSEMBLE_H_
+#define _PMOS_ENSEMBLE_H_ 1
+#include "pmos.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define METRIC_MASK(metric)  (1u << (metric))			/* bit indicating presence of a metric */
+#define ALL_METRICS          ((1u << n_metric_types) - 1)	/* all metrics */
+
+/*! Weights of individual models in the ensemble: */
+struct ensemble_weights {
+	double w[n_metric_types];	/* non-negative weights, indexed by metric type */
+};
+
+/*! Function prototypes: */
+int ensemble_mos(const struct viewing_context* ctx, unsigned int mask, const double* values, const struct ensemble_weights* weights, double* mos, double* p_combined);
+int ensemble_fit(unsigned int mask, const double* mos, const double* true_mos, int n, struct ensemble_weights* weights, double* p_rms);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
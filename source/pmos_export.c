@@ -0,0 +1,138 @@
+/*!
+ *  \file  pmos_export.c
+ *  \brief Exporter of piecewise-linear surrogate models as SQL, GLSL, or CSV.
+ *
+ *  Usage: pmos_export config sql|glsl|csv [output]
+ *
+ *  For each rendition of a fixed viewing setup (see pmos_config.c for the format of configuration
+ *  files), metric-to-MOS mapping is approximated by a piecewise-linear function within configured
+ *  tolerance (see pmos_surrogate.c), and emitted as:
+ *
+ *    sql   - CASE expression of columns <rendition_column> and <value_column>
+ *    glsl  - function float <name>_mos(int rendition, float value)
+ *    csv   - table of segments: rendition, width, height, x0, x1, y0, y1, slope, max_error
+ *
+ *  Measured max error of each surrogate is included in the output, and reported to stderr.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pmos.h"
+#include "pmos_config.h"
+#include "pmos_surrogate.h"
+
+/*! Slope of segment i: */
+#define slope(s, i)  (((s)->y[(i) + 1] - (s)->y[i]) / ((s)->x[(i) + 1] - (s)->x[i]))
+
+/*!
+ * \brief Emits SQL CASE expression.
+ */
+static void emit_sql(FILE* out, const struct tool_config* c, const struct surrogate* s)
+{
+	const char* v = c->value_column;
+	int r, i;
+
+	fprintf(out, "-- %s: %s to MOS, %s, player %dx%d\n", c->name, config_metric_names[c->metric], config_device_names[c->device], c->player_width, c->player_height);
+	fprintf(out, "CASE %s\n", c->rendition_column);
+	for (r = 0; r < c->n; r++) {
+		fprintf(out, "  WHEN %d THEN -- %dx%d, max error %.6f\n    CASE\n", r, c->widths[r], c->heights[r], s[r].max_error);
+		fprintf(out, "      WHEN %s <= %.10g THEN %.10g\n", v, s[r].x[0], s[r].y[0]);
+		for (i = 0; i < s[r].n - 1; i++)
+			fprintf(out, "      WHEN %s <= %.10g THEN %.10g + (%s - %.10g) * %.10g\n", v, s[r].x[i + 1], s[r].y[i], v, s[r].x[i], slope(&s[r], i));
+		fprintf(out, "      ELSE %.10g\n    END\n", s[r].y[s[r].n - 1]);
+	}
+	fprintf(out, "END\n");
+}
+
+/*!
+ * \brief Formats GLSL float literal (GLSL ES and GLSL 1.10 reject integer literals in float context).
+ * \param[out] buffer  buffer of at least 32 characters
+ * \param[in]  x       value
+ * \returns     buffer
+ */
+static const char* glsl_float(char* buffer, double x)
+{
+	snprintf(buffer, 32, "%.8g", x);
+	if (strpbrk(buffer, ".e") == NULL) strcat(buffer, ".0");
+	return buffer;
+}
+
+/*!
+ * \brief Emits GLSL functions.
+ */
+static void emit_glsl(FILE* out, const struct tool_config* c, const struct surrogate* s)
+{
+	char b0[32], b1[32], b2[32], b3[32];
+	int r, i;
+
+	fprintf(out, "// %s: %s to MOS, %s, player %dx%d\n\n", c->name, config_metric_names[c->metric], config_device_names[c->device], c->player_width, c->player_height);
+	for (r = 0; r < c->n; r++) {
+		fprintf(out, "// %dx%d, max error %.6f\nfloat %s_mos_%d(float v)\n{\n", c->widths[r], c->heights[r], s[r].max_error, c->name, r);
+		fprintf(out, "\tif (v <= %s) return %s;\n", glsl_float(b0, s[r].x[0]), glsl_float(b1, s[r].y[0]));
+		for (i = 0; i < s[r].n - 1; i++)
+			fprintf(out, "\tif (v <= %s) return %s + (v - %s) * %s;\n", glsl_float(b0, s[r].x[i + 1]), glsl_float(b1, s[r].y[i]),
+				glsl_float(b2, s[r].x[i]), glsl_float(b3, slope(&s[r], i)));
+		fprintf(out, "\treturn %s;\n}\n\n", glsl_float(b0, s[r].y[s[r].n - 1]));
+	}
+	fprintf(out, "float %s_mos(int rendition, float value)\n{\n", c->name);
+	for (r = 0; r < c->n; r++)
+		fprintf(out, "\tif (rendition == %d) return %s_mos_%d(value);\n", r, c->name, r);
+	fprintf(out, "\treturn -1.0;\n}\n");
+}
+
+/*!
+ * \brief Emits CSV table of segments.
+ */
+static void emit_csv(FILE* out, const struct tool_config* c, const struct surrogate* s)
+{
+	int r, i;
+
+	fprintf(out, "rendition,width,height,x0,x1,y0,y1,slope,max_error\n");
+	for (r = 0; r < c->n; r++)
+		for (i = 0; i < s[r].n - 1; i++)
+			fprintf(out, "%d,%d,%d,%.10g,%.10g,%.10g,%.10g,%.10g,%.6f\n", r, c->widths[r], c->heights[r],
+				s[r].x[i], s[r].x[i + 1], s[r].y[i], s[r].y[i + 1], slope(&s[r], i), s[r].max_error);
+}
+
+int main(int argc, char* argv[])
+{
+	static struct viewing_context ctx[CONFIG_MAX_RENDITIONS];
+	static struct surrogate s[CONFIG_MAX_RENDITIONS];
+	static struct tool_config c;
+	FILE* out = stdout;
+	int r, err;
+
+	if (argc < 3 || argc > 4 || (strcmp(argv[2], "sql") && strcmp(argv[2], "glsl") && strcmp(argv[2], "csv"))) {
+		fprintf(stderr, "usage: pmos_export config sql|glsl|csv [output]\n");
+		return 1;
+	}
+	if (tool_config_read(argv[1], &c) || tool_config_contexts(&c, ctx)) return 1;
+
+	/* fit surrogates: */
+	for (r = 0; r < c.n; r++) {
+		err = surrogate_fit(&ctx[r], c.metric, c.tolerance, &s[r]);
+		if (err) {
+			fprintf(stderr, "pmos_export: rendition %dx%d: cannot fit surrogate (error %d)\n", c.widths[r], c.heights[r], err);
+			return 1;
+		}
+		fprintf(stderr, "rendition %d (%dx%d): %d segments, max error %.6f\n", r, c.widths[r], c.heights[r], s[r].n - 1, s[r].max_error);
+	}
+
+	if (argc == 4 && (out = fopen(argv[3], "w")) == NULL) {
+		fprintf(stderr, "pmos_export: cannot create %s\n", argv[3]);
+		return 1;
+	}
+	if (!strcmp(argv[2], "sql")) emit_sql(out, &c, s);
+	else if (!strcmp(argv[2], "glsl")) emit_glsl(out, &c, s);
+	else emit_csv(out, &c, s);
+	if (out != stdout) fclose(out);
+	return 0;
+}
+
+/* pmos_export.c -- end of file */
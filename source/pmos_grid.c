@@ -0,0 +1,125 @@
+/*!
+ *  \file  pmos_grid.c
+ *  \brief Evaluation of MOS models over grids of metric scores and viewing parameters.
+ *
+ *  Fused models [3] are separable: the WR score depends only on viewing angle and angular resolution,
+ *  and the metric mapping only on the metric score. Over a grid, the metric mapping is therefore computed
+ *  once per metric score, and the WR score once per (distance, player width, encoding width) triple. Each
+ *  row of the output is then filled by a single multiply-add per element, giving the same values as
+ *  metric2mos() computed point by point.
+ *
+ *  Output is a dense array with dimensions [distance][player width][encoding width][metric score], with
+ *  metric scores changing fastest.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#include <stdlib.h>
+#include "pmos.h"
+#include "pmos_grid.h"
+
+/*!
+ * \brief Returns number of elements in the grid (0 - invalid axes).
+ */
+size_t grid_size(const struct grid_axes* axes)
+{
+	if (axes == NULL || axes->n_values < 1 || axes->n_widths < 1 || axes->n_player_widths < 1 || axes->n_distances < 0) return 0;
+	return (size_t)(axes->n_distances ? axes->n_distances : 1) * axes->n_player_widths * axes->n_widths * axes->n_values;
+}
+
+/*!
+ * \brief Fills one row of the grid (all metric scores for a given viewing setup).
+ */
+static void grid_row(const struct fusion_params* f, const double* q, int n, double qwr, double* out)
+{
+	double b, dq, m;
+	int i;
+
+	/* terms depending only on WR score: */
+	b = f->beta * (1 + f->gamma * qwr);
+	dq = f->delta * qwr;
+
+	for (i = 0; i < n; i++) {
+		if (q[i] < 0) { out[i] = q[i]; continue; }	/* invalid metric score */
+		m = f->alpha + b * q[i] + dq;
+		out[i] = m < 1 ? 1 : m > 5 ? 5 : m;
+	}
+}
+
+/*!
+ * \brief Computes MOS over a grid of metric scores, encoding widths, player widths, and viewing distances.
+ *
+ * \param[in]  metric			metric type (see enum metric_types)
+ * \param[in]  hdr				indicator if video is hdr (1) or sdr (0)
+ * \param[in]  upsampling		assumed upsampling method (see enum upsampling_methods)
+ * \param[in]  device			device type [device_type]
+ * \param[in]  params			custom device parameters
+ * \param[in]  axes			grid axes
+ * \param[out] out				MOS scores (grid_size(axes) elements); invalid metric scores produce -9,
+ *								and viewing setups outside of the model range produce -8
+ *
+ * \returns    0				success
+ *			  -1				invalid encoding width
+ *			  -2				invalid player width or viewing distance
+ *			  -3..-7			invalid HDR indicator, upsampling method or device (see psnr2mos())
+ *			  -10				invalid metric type
+ *			  -12				invalid axes
+ *			  -15				memory allocation failure
+ */
+int mos_grid(int metric, int hdr, int upsampling, int device, struct device_params* params, const struct grid_axes* axes, double* out)
+{
+	const struct fusion_params* f;
+	struct device_params display;
+	double default_distance, distance, phi, u, qwr, *q;
+	int n_distances, d, p, e, i, err;
+
+	/* check parameters: */
+	if (out == NULL) return -6;
+	if (!grid_size(axes)) return -12;
+	if (axes->values == NULL || axes->widths == NULL || axes->player_widths == NULL) return -12;
+	if (axes->n_distances && axes->distances == NULL) return -12;
+	if (hdr < 0 || hdr > 1) return -3;
+	if (upsampling < 0 || upsampling >= n_upsampling_methods) return -4;
+	if ((f = fusion_model_params(metric)) == NULL) return -10;
+	for (e = 0; e < axes->n_widths; e++)
+		if (axes->widths[e] < 1 || axes->widths[e] > 8192) return -1;
+	for (p = 0; p < axes->n_player_widths; p++)
+		if (axes->player_widths[p] < 1 || axes->player_widths[p] > 8192) return -2;
+	for (d = 0; d < axes->n_distances; d++)
+		if (!(axes->distances[d] > 0)) return -2;
+	err = device_geometry(device, params, &display, &default_distance);
+	if (err) return err;
+
+	/* metric mapping, once per metric score: */
+	q = (double*)malloc(axes->n_values * sizeof(double));
+	if (q == NULL) return -15;
+	for (i = 0; i < axes->n_values; i++)
+		q[i] = metric_scale(metric, axes->values[i]);
+
+	/* WR score, once per viewing setup, and broadcast over metric scores: */
+	n_distances = axes->n_distances ? axes->n_distances : 1;
+	for (d = 0; d < n_distances; d++) {
+		distance = axes->n_distances ? axes->distances[d] : default_distance;
+		for (p = 0; p < axes->n_player_widths; p++) {
+			phi = viewing_angle(axes->player_widths[p], distance, display.ppi_x);
+			for (e = 0; e < axes->n_widths; e++, out += axes->n_values) {
+				u = angular_resolution(axes->widths[e], axes->player_widths[p], distance, display.ppi_x);
+				qwr = wr_score(phi, u, hdr, upsampling);
+				if (qwr < 0) {
+					for (i = 0; i < axes->n_values; i++) out[i] = qwr;
+					continue;
+				}
+				grid_row(f, q, axes->n_values, qwr, out);
+			}
+		}
+	}
+
+	free(q);
+	return 0;
+}
+
+/* pmos_grid.c -- end of file */
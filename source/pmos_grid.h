@@ -0,0 +1,38 @@
+/*!
+ *  \file  pmos_grid.h
+ *  \brief Evaluation of MOS models over grids of metric scores and viewing parameters.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _PMOS_GRID_H_
+#define _PMOS_GRID_H_ 1
+#include "pmos.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! Grid axes: */
+struct grid_axes {
+	int n_values;			/* number of metric scores */
+	const double* values;		/* metric scores */
+	int n_widths;			/* number of encoding widths */
+	const int* widths;		/* encoding widths [pixels] */
+	int n_player_widths;		/* number of player widths */
+	const int* player_widths;	/* player widths [pixels] */
+	int n_distances;		/* number of viewing distances, 0 - use device default */
+	const double* distances;	/* viewing distances [inches] */
+};
+
+/*! Function prototypes: */
+size_t grid_size(const struct grid_axes* axes);
+int mos_grid(int metric, int hdr, int upsampling, int device, struct device_params* params, const struct grid_axes* axes, double* out);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
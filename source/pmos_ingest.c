@@ -0,0 +1,332 @@
+/*!
+ *  \file  pmos_ingest.c
+ *  \brief Parallel reading of large sets of small files (io_uring or thread pool).
+ *
+ *  Files are split into contiguous blocks, one per worker thread (see parallel_for()). Each worker
+ *  reads its files, and hands their contents to a callback (e.g. log parser and scoring stage),
+ *  so that reading, parsing and scoring of different files overlap across cores.
+ *
+ *  When compiled with PMOS_IO_URING (Linux, link with -luring), each worker keeps up to queue_depth
+ *  reads in flight on its own io_uring, and calls the callback as reads complete (in any order).
+ *  Otherwise, or if io_uring cannot be set up (old kernel, seccomp), workers read files one after
+ *  another with blocking reads; more threads than cores may then be used to keep the disk busy.
+ *
+ *  With INGEST_DECOMPRESS flag, gzip and zstd compressed files (recognized by magic numbers) are
+ *  decompressed by the worker that has read them, into a per-worker buffer, before being passed to
+ *  the callback. Compressed files are thus decompressed in parallel, and never written to disk.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifdef PMOS_IO_URING
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "pmos_thread.h"
+#include "pmos_ingest.h"
+#include "pmos_decompress.h"
+
+#ifdef PMOS_IO_URING
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <liburing.h>
+#endif
+
+#define INGEST_DEFAULT_DEPTH  32	/* default number of reads in flight per thread */
+
+/*! Ingestion job: */
+struct ingest_job {
+	const char* const* paths;	/* file names */
+	int n;				/* number of files */
+	int n_blocks;			/* number of blocks (threads) */
+	int queue_depth;		/* reads in flight per thread */
+	int flags;			/* INGEST_DECOMPRESS */
+	size_t max_size;		/* limit on size of decompressed files [bytes] */
+	ingest_callback callback;
+	void* arg;
+	struct ingest_stats stats[PMOS_MAX_THREADS];	/* per-block statistics */
+};
+
+/*! File buffer: */
+struct ingest_buffer {
+	char* data;
+	size_t size, capacity;
+};
+
+/*!
+ * \brief Ensures buffer capacity of at least n bytes.
+ *
+ * \returns 0 - success, -1 - out of memory
+ */
+static int buffer_reserve(struct ingest_buffer* b, size_t n)
+{
+	char* data;
+	size_t capacity = b->capacity ? b->capacity : 4096;
+
+	if (n <= b->capacity) return 0;
+	while (capacity < n) capacity *= 2;
+	data = (char*)realloc(b->data, capacity);
+	if (data == NULL) return -1;
+	b->data = data;
+	b->capacity = capacity;
+	return 0;
+}
+
+/*!
+ * \brief Passes a file (decompressed, if needed, and NUL-terminated) to the callback, and updates statistics.
+ */
+static void file_complete(struct ingest_job* job, struct ingest_stats* stats, int index, struct ingest_buffer* b, struct decompress_buffer* out, int err)
+{
+	if (err) {
+		stats->failed++;
+		job->callback(job->arg, index, NULL, 0, -1);
+		return;
+	}
+	stats->bytes += (double)b->size;
+
+	if ((job->flags & INGEST_DECOMPRESS) && compression_type(b->data, b->size) != compression_none) {
+		if (decompress(b->data, b->size, out)) {
+			stats->failed++;
+			job->callback(job->arg, index, NULL, 0, -2);
+			return;
+		}
+		stats->files++;
+		stats->output_bytes += (double)out->size;
+		job->callback(job->arg, index, out->data, out->size, 0);
+		return;
+	}
+	b->data[b->size] = 0;
+	stats->files++;
+	stats->output_bytes += (double)b->size;
+	job->callback(job->arg, index, b->data, b->size, 0);
+}
+
+/****************************
+ *
+ * Blocking reads:
+ *
+ ***/
+
+/*!
+ * \brief Reads a file into a buffer (leaving room for terminating NUL).
+ *
+ * \returns 0 - success, -1 - cannot read
+ */
+static int file_read(const char* path, struct ingest_buffer* b)
+{
+	FILE* f;
+	size_t n;
+
+	b->size = 0;
+	if ((f = fopen(path, "rb")) == NULL) return -1;
+	do {
+		if (buffer_reserve(b, b->size + 4096)) { fclose(f); return -1; }
+		n = fread(b->data + b->size, 1, b->capacity - b->size - 1, f);
+		b->size += n;
+	} while (n > 0);
+	n = ferror(f);
+	fclose(f);
+	return n ? -1 : 0;
+}
+
+static void ingest_blocking(struct ingest_job* job, struct ingest_stats* stats, int begin, int end)
+{
+	struct ingest_buffer b = {NULL, 0, 0};
+	struct decompress_buffer out = {NULL, 0, 0, job->max_size};
+	int i;
+
+	for (i = begin; i < end; i++)
+		file_complete(job, stats, i, &b, &out, file_read(job->paths[i], &b));
+	free(b.data);
+	free(out.data);
+}
+
+/****************************
+ *
+ * io_uring reads:
+ *
+ ***/
+
+#ifdef PMOS_IO_URING
+
+/*! Read in flight: */
+struct ingest_slot {
+	int index;			/* file index */
+	int fd;				/* file descriptor (-1 - slot is free) */
+	struct ingest_buffer b;		/* file contents (b.size - bytes read so far) */
+	size_t size;			/* file size */
+};
+
+/*!
+ * \brief Queues read of the remaining part of a file.
+ */
+static void slot_read(struct io_uring* ring, struct ingest_slot* s)
+{
+	struct io_uring_sqe* sqe = io_uring_get_sqe(ring);
+	io_uring_prep_read(sqe, s->fd, s->b.data + s->b.size, (unsigned)(s->size - s->b.size), s->b.size);
+	io_uring_sqe_set_data(sqe, s);
+}
+
+static void slot_complete(struct ingest_job* job, struct ingest_stats* stats, struct ingest_slot* s, struct decompress_buffer* out, int err)
+{
+	if (s->fd >= 0) close(s->fd);
+	s->fd = -1;
+	file_complete(job, stats, s->index, &s->b, out, err);
+}
+
+/*!
+ * \brief Reads files [begin, end) with up to queue_depth reads in flight.
+ *
+ * \returns 0 - success, -1 - io_uring is not available (no files were read)
+ */
+static int ingest_uring(struct ingest_job* job, struct ingest_stats* stats, int begin, int end)
+{
+	struct ingest_slot slots[INGEST_MAX_DEPTH];
+	struct decompress_buffer out = {NULL, 0, 0, job->max_size};
+	struct io_uring ring;
+	struct io_uring_cqe* cqe;
+	struct ingest_slot* s;
+	struct stat st;
+	int i, res, next = begin, active = 0;
+
+	if (io_uring_queue_init((unsigned)job->queue_depth, &ring, 0) < 0) return -1;
+	for (i = 0; i < job->queue_depth; i++) {
+		slots[i].fd = -1;
+		slots[i].b.data = NULL;
+		slots[i].b.capacity = 0;
+	}
+
+	while (next < end || active > 0) {
+		/* open next files in free slots, and queue their reads: */
+		for (i = 0; i < job->queue_depth && next < end; i++) {
+			s = &slots[i];
+			if (s->fd >= 0) continue;
+			s->index = next++;
+			s->b.size = 0;
+			if ((s->fd = open(job->paths[s->index], O_RDONLY)) < 0 || fstat(s->fd, &st) || buffer_reserve(&s->b, (size_t)st.st_size + 1))
+				slot_complete(job, stats, s, &out, -1);
+			else if ((s->size = (size_t)st.st_size) == 0)
+				slot_complete(job, stats, s, &out, 0);
+			else {
+				slot_read(&ring, s);
+				active++;
+			}
+		}
+		if (active == 0) continue;
+
+		/* submit, and process completions: */
+		io_uring_submit_and_wait(&ring, 1);
+		while (io_uring_peek_cqe(&ring, &cqe) == 0) {
+			s = (struct ingest_slot*)io_uring_cqe_get_data(cqe);
+			res = cqe->res;
+			io_uring_cqe_seen(&ring, cqe);
+			active--;
+			if (res < 0)
+				slot_complete(job, stats, s, &out, -1);
+			else if (res == 0 || (s->b.size += (size_t)res) == s->size)
+				slot_complete(job, stats, s, &out, 0);	/* end of file (may be truncated while reading) */
+			else {
+				slot_read(&ring, s);			/* short read */
+				active++;
+			}
+		}
+	}
+
+	io_uring_queue_exit(&ring);
+	for (i = 0; i < job->queue_depth; i++)
+		free(slots[i].b.data);
+	free(out.data);
+	stats->io_uring = 1;
+	return 0;
+}
+
+#endif
+
+/****************************
+ *
+ * Parallel ingestion:
+ *
+ ***/
+
+static void ingest_body(void* arg, int begin, int end)
+{
+	struct ingest_job* job = (struct ingest_job*)arg;
+	int k, first, last;
+
+	for (k = begin; k < end; k++) {
+		first = (int)((long long)job->n * k / job->n_blocks);
+		last = (int)((long long)job->n * (k + 1) / job->n_blocks);
+#ifdef PMOS_IO_URING
+		if (ingest_uring(job, &job->stats[k], first, last) == 0) continue;
+#endif
+		ingest_blocking(job, &job->stats[k], first, last);
+	}
+}
+
+/*!
+ * \brief Reads files in parallel, and passes their contents to a callback.
+ *
+ * \param[in]  paths			file names
+ * \param[in]  n				number of files
+ * \param[in]  n_threads		number of worker threads (0 - use all cores)
+ * \param[in]  queue_depth		number of reads in flight per thread with io_uring (0 - default)
+ * \param[in]  flags			INGEST_DECOMPRESS - decompress gzip/zstd files
+ * \param[in]  max_size		limit on size of decompressed files [bytes] (0 - DECOMPRESS_MAX_SIZE)
+ * \param[in]  callback			consumer of file contents (called from worker threads)
+ * \param[in]  arg				argument passed to the callback
+ * \param[out] stats			ingestion statistics (may be NULL)
+ *
+ * \returns    0				success (including files that could not be read, see callback)
+ *			  -1				invalid parameters
+ *			  -2				out of memory
+ *
+ *  Contents passed to the callback are NUL-terminated, and valid only during the call.
+ */
+int ingest_files(const char* const* paths, int n, int n_threads, int queue_depth, int flags, size_t max_size, ingest_callback callback, void* arg, struct ingest_stats* stats)
+{
+	struct ingest_job* job;
+	double t;
+	int k;
+
+	if ((paths == NULL && n > 0) || n < 0 || n_threads < 0 || queue_depth < 0 || queue_depth > INGEST_MAX_DEPTH || callback == NULL) return -1;
+	if ((job = (struct ingest_job*)calloc(1, sizeof(struct ingest_job))) == NULL) return -2;
+
+	job->paths = paths;
+	job->n = n;
+	job->n_blocks = n_threads ? n_threads : cpu_count();
+	if (job->n_blocks > PMOS_MAX_THREADS) job->n_blocks = PMOS_MAX_THREADS;
+	if (job->n_blocks > n) job->n_blocks = n;
+	job->queue_depth = queue_depth ? queue_depth : INGEST_DEFAULT_DEPTH;
+	job->flags = flags;
+	job->max_size = max_size;
+	job->callback = callback;
+	job->arg = arg;
+
+	t = wall_clock();
+	parallel_for(job->n_blocks, job->n_blocks, ingest_body, job);
+
+	if (stats != NULL) {
+		stats->files = stats->failed = 0;
+		stats->bytes = stats->output_bytes = 0;
+		stats->io_uring = job->n_blocks > 0;
+		for (k = 0; k < job->n_blocks; k++) {
+			stats->files += job->stats[k].files;
+			stats->failed += job->stats[k].failed;
+			stats->bytes += job->stats[k].bytes;
+			stats->output_bytes += job->stats[k].output_bytes;
+			stats->io_uring &= job->stats[k].io_uring;
+		}
+		stats->seconds = wall_clock() - t;
+	}
+	free(job);
+	return 0;
+}
+
+/* pmos_ingest.c -- end of file */
@@ -0,0 +1,41 @@
+/*!
+ *  \file  pmos_ingest.h
+ *  \brief Parallel reading of large sets of small files (io_uring or thread pool).
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _PMOS_INGEST_H_
+#define _PMOS_INGEST_H_ 1
+#include <stddef.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define INGEST_MAX_DEPTH  256	/* max number of reads in flight per thread */
+#define INGEST_DECOMPRESS 1	/* flag: decompress gzip/zstd files (see pmos_decompress.c) */
+
+/*! Consumer of a file - called from worker threads, once per file (err: 0 - success, -1 - cannot read, -2 - cannot decompress, or too large when decompressed): */
+typedef void (*ingest_callback)(void* arg, int index, const char* data, size_t size, int err);
+
+/*! Ingestion statistics: */
+struct ingest_stats {
+	int files;			/* number of files read */
+	int failed;			/* number of files that could not be read */
+	double bytes;			/* total size of files read [bytes] */
+	double output_bytes;		/* total size of contents passed to the callback, after decompression [bytes] */
+	double seconds;			/* wall-clock time [s] */
+	int io_uring;			/* 1 - files were read using io_uring */
+};
+
+/*! Function prototypes: */
+int ingest_files(const char* const* paths, int n, int n_threads, int queue_depth, int flags, size_t max_size, ingest_callback callback, void* arg, struct ingest_stats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
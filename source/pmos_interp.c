@@ -0,0 +1,201 @@
+/*!
+ *  \file  pmos_interp.c
+ *  \brief Monotone piecewise cubic Hermite (PCHIP) interpolation of rate-quality curves.
+ *
+ *  This code implements shape-preserving interpolation proposed in:
+ *
+ *    [1] F. N. Fritsch and R. E. Carlson, "Monotone Piecewise Cubic Interpolation," SIAM J. Numer. Anal., 17(2), 1980.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <math.h>
+#include "pmos_interp.h"
+
+/*!
+ *  \brief Computes slopes of monotone piecewise cubic Hermite interpolant [1].
+ *
+ *  \param[in]  x      abscissas (strictly increasing)
+ *  \param[in]  y      ordinates
+ *  \param[out] d      slopes at each point
+ *  \param[in]  n      number of points (>= 2)
+ *
+ *  \return 0 - success, -1 - invalid parameters
+ */
+int pchip_init(const double* x, const double* y, double* d, int n)
+{
+	double h0, h1, s0, s1, w0, w1;
+	int k;
+
+	/* check parameters */
+	if (x == NULL || y == NULL || d == NULL || n < 2) return -1;
+	for (k = 1; k < n; k++)
+		if (!(x[k] > x[k - 1])) return -1;
+
+	/* two points - linear interpolation: */
+	if (n == 2) {
+		d[0] = d[1] = (y[1] - y[0]) / (x[1] - x[0]);
+		return 0;
+	}
+
+	/* interior points - weighted harmonic mean of secants, zero at extrema [1]: */
+	for (k = 1; k < n - 1; k++) {
+		h0 = x[k] - x[k - 1];
+		h1 = x[k + 1] - x[k];
+		s0 = (y[k] - y[k - 1]) / h0;
+		s1 = (y[k + 1] - y[k]) / h1;
+		if (s0 * s1 <= 0) {
+			d[k] = 0;
+		} else {
+			w0 = 2 * h1 + h0;
+			w1 = h1 + 2 * h0;
+			d[k] = (w0 + w1) / (w0 / s0 + w1 / s1);
+		}
+	}
+
+	/* end points - shape-preserving three-point formulae: */
+	for (k = 0; k < 2; k++) {
+		int i = k ? n - 1 : 0, j = k ? n - 2 : 1, l = k ? n - 3 : 2;
+		double dd;
+		h0 = fabs(x[j] - x[i]);
+		h1 = fabs(x[l] - x[j]);
+		s0 = (y[j] - y[i]) / (x[j] - x[i]);
+		s1 = (y[l] - y[j]) / (x[l] - x[j]);
+		dd = ((2 * h0 + h1) * s0 - h0 * s1) / (h0 + h1);
+		if (dd * s0 <= 0)
+			dd = 0;
+		else if (s0 * s1 <= 0 && fabs(dd) > 3 * fabs(s0))
+			dd = 3 * s0;
+		d[i] = dd;
+	}
+
+	return 0;
+}
+
+/*!
+ *  \brief Evaluates cubic Hermite polynomial on segment k.
+ */
+static double hermite(const double* x, const double* y, const double* d, int k, double xi)
+{
+	double h = x[k + 1] - x[k], t = (xi - x[k]) / h, t1 = 1 - t;
+
+	return (1 + 2 * t) * t1 * t1 * y[k] + t * t1 * t1 * h * d[k] + t * t * (3 - 2 * t) * y[k + 1] - t * t * t1 * h * d[k + 1];
+}
+
+/*!
+ *  \brief Evaluates monotone piecewise cubic Hermite interpolant.
+ *
+ *  \param[in]  x      abscissas
+ *  \param[in]  y      ordinates
+ *  \param[in]  d      slopes (see pchip_init())
+ *  \param[in]  n      number of points
+ *  \param[in]  xi     point of evaluation (clamped to [x[0], x[n-1]])
+ *
+ *  \return interpolated value
+ */
+double pchip_eval(const double* x, const double* y, const double* d, int n, double xi)
+{
+	int lo = 0, hi = n - 1, k;
+
+	assert(n >= 2);
+
+	/* clamp to the range of the data: */
+	if (xi <= x[0]) return y[0];
+	if (xi >= x[n - 1]) return y[n - 1];
+
+	/* find segment: */
+	while (hi - lo > 1) {
+		k = (lo + hi) >> 1;
+		if (x[k] <= xi) lo = k; else hi = k;
+	}
+
+	return hermite(x, y, d, lo, xi);
+}
+
+/*!
+ *  \brief Finds smallest abscissa at which monotone piecewise cubic Hermite interpolant reaches given value.
+ *
+ *  \param[in]  x      abscissas
+ *  \param[in]  y      ordinates
+ *  \param[in]  d      slopes (see pchip_init())
+ *  \param[in]  n      number of points
+ *  \param[in]  yi     value to reach
+ *  \param[out] p_xi   abscissa
+ *
+ *  \return 0 - success, -1 - value is not reached within [x[0], x[n-1]]
+ */
+int pchip_solve(const double* x, const double* y, const double* d, int n, double yi, double* p_xi)
+{
+	double a, b, m, fa, fm;
+	int k, i;
+
+	assert(n >= 2 && p_xi != NULL);
+
+	/* find first segment containing yi (interpolant is monotone on each segment): */
+	for (k = 0; k < n - 1; k++) {
+		if (y[k] == yi) { *p_xi = x[k]; return 0; }
+		if ((y[k] < yi) == (yi <= y[k + 1])) break;
+	}
+	if (k == n - 1) return -1;
+
+	/* bisection on segment [x[k], x[k+1]]: */
+	a = x[k]; b = x[k + 1]; fa = y[k] - yi;
+	for (i = 0; i < 60 && b - a > 1e-12 * fabs(b); i++) {
+		m = 0.5 * (a + b);
+		fm = hermite(x, y, d, k, m) - yi;
+		if ((fm < 0) == (fa < 0)) { a = m; fa = fm; } else b = m;
+	}
+
+	*p_xi = b;
+	return 0;
+}
+
+/*!
+ *  \brief Integral of monotone piecewise cubic Hermite interpolant from x[0] to a given point.
+ */
+static double pchip_primitive(const double* x, const double* y, const double* d, int n, double xi)
+{
+	double h, t, t2, t3, t4, sum = 0;
+	int k;
+
+	/* full segments - closed-form integrals of Hermite polynomials: */
+	for (k = 0; k < n - 2 && x[k + 1] <= xi; k++) {
+		h = x[k + 1] - x[k];
+		sum += h * (0.5 * (y[k] + y[k + 1]) + h * (d[k] - d[k + 1]) / 12.0);
+	}
+
+	/* partial segment: */
+	h = x[k + 1] - x[k];
+	t = (xi - x[k]) / h; t2 = t * t; t3 = t2 * t; t4 = t3 * t;
+	sum += h * ((t4 / 2 - t3 + t) * y[k] + (t4 / 4 - 2 * t3 / 3 + t2 / 2) * h * d[k] + (t3 - t4 / 2) * y[k + 1] + (t4 / 4 - t3 / 3) * h * d[k + 1]);
+
+	return sum;
+}
+
+/*!
+ *  \brief Integrates monotone piecewise cubic Hermite interpolant over a given interval.
+ *
+ *  \param[in]  x      abscissas
+ *  \param[in]  y      ordinates
+ *  \param[in]  d      slopes (see pchip_init())
+ *  \param[in]  n      number of points
+ *  \param[in]  a      lower limit of integration (in [x[0], x[n-1]])
+ *  \param[in]  b      upper limit of integration (in [x[0], x[n-1]])
+ *
+ *  \return integral
+ */
+double pchip_integral(const double* x, const double* y, const double* d, int n, double a, double b)
+{
+	assert(n >= 2);
+	assert(a >= x[0] && b <= x[n - 1]);
+
+	return pchip_primitive(x, y, d, n, b) - pchip_primitive(x, y, d, n, a);
+}
+
+/* pmos_interp.c -- end of file */
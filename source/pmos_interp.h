@@ -0,0 +1,27 @@
+/*!
+ *  \file  pmos_interp.h
+ *  \brief Monotone piecewise cubic Hermite (PCHIP) interpolation of rate-quality curves.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _PMOS_INTERP_H_
+#define _PMOS_INTERP_H_ 1
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! Function prototypes: */
+int pchip_init(const double* x, const double* y, double* d, int n);
+double pchip_eval(const double* x, const double* y, const double* d, int n, double xi);
+int pchip_solve(const double* x, const double* y, const double* d, int n, double yi, double* p_xi);
+double pchip_integral(const double* x, const double* y, const double* d, int n, double a, double b);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
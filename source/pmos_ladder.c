@@ -0,0 +1,219 @@
+/*!
+ *  \file  pmos_ladder.c
+ *  \brief Per-title encoding ladder optimizer targeting device-specific MOS.
+ *
+ *  Given rate-quality curves of a title (bitrate vs. PSNR/SSIM/VIF/VMAF) at each encoding resolution,
+ *  finds the cheapest set of renditions such that each target device class is served by a rendition
+ *  reaching its target MOS:
+ *
+ *   - curves are interpolated in log-bitrate domain by monotone piecewise cubic Hermite interpolants;
+ *   - metric scores reaching target MOS for each device and resolution are found by inverse models
+ *     (see mos2metric()), and cached in the optimizer, as they do not depend on the title;
+ *   - minimal bitrates reaching target MOS are found for each device and resolution by inverting the
+ *     interpolated curves;
+ *   - the cheapest set of renditions covering all devices is found by dynamic programming over
+ *     subsets of devices.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <math.h>
+#include "pmos.h"
+#include "pmos_interp.h"
+#include "pmos_ladder.h"
+
+/*!
+ * \brief Initializes ladder optimizer for a given set of target devices and encoding resolutions.
+ *
+ * \param[out] lo				ladder optimizer
+ * \param[in]  metric			metric type (see enum metric_types)
+ * \param[in]  targets			target device classes
+ * \param[in]  n_targets		number of target device classes (<= LADDER_MAX_TARGETS)
+ * \param[in]  widths			widths of encoding resolutions [pixels]
+ * \param[in]  heights			heights of encoding resolutions [pixels]
+ * \param[in]  n_resolutions	number of encoding resolutions (<= LADDER_MAX_RESOLUTIONS)
+ *
+ * \returns    0				success
+ *			  -6				NULL pointer
+ *			  -10				invalid metric type
+ *			  -12				invalid number of targets or resolutions
+ */
+int ladder_init(struct ladder_optimizer* lo, int metric, const struct ladder_target* targets, int n_targets, const int* widths, const int* heights, int n_resolutions)
+{
+	const struct ladder_target* tg;
+	int t, r, err;
+
+	/* check parameters */
+	if (lo == NULL || targets == NULL || widths == NULL || heights == NULL) return -6;
+	if (metric < 0 || metric >= n_metric_types) return -10;
+	if (n_targets < 1 || n_targets > LADDER_MAX_TARGETS) return -12;
+	if (n_resolutions < 1 || n_resolutions > LADDER_MAX_RESOLUTIONS) return -12;
+
+	lo->metric = metric;
+	lo->n_targets = n_targets;
+	lo->n_resolutions = n_resolutions;
+	for (r = 0; r < n_resolutions; r++) {
+		lo->width[r] = widths[r];
+		lo->height[r] = heights[r];
+	}
+
+	/* compute viewing contexts and metric scores reaching target MOS: */
+	for (t = 0; t < n_targets; t++) {
+		lo->targets[t] = targets[t];
+		tg = &lo->targets[t];
+		for (r = 0; r < n_resolutions; r++) {
+			err = viewing_context_init(&lo->ctx[t][r], widths[r], heights[r], tg->player_width, tg->player_height, tg->hdr, tg->upsampling, tg->device, tg->params);
+			lo->status[t][r] = err;
+			lo->required[t][r] = err ? err : mos2metric(&lo->ctx[t][r], metric, tg->mos);
+		}
+	}
+
+	return 0;
+}
+
+/*!
+ * \brief Finds the cheapest ladder reaching target MOS on each target device class.
+ *
+ *  Targets that cannot reach their MOS at any resolution are served by renditions giving
+ *  them the highest MOS, and are flagged in ladder->reached[].
+ *
+ * \param[in]  lo				ladder optimizer (see ladder_init())
+ * \param[in]  curves			rate-quality curves of a title, one per encoding resolution
+ * \param[out] ladder			optimized ladder
+ *
+ * \returns    0				success
+ *			  -6				NULL pointer
+ *			  -13				invalid rate-quality curve
+ */
+int ladder_optimize(const struct ladder_optimizer* lo, const struct rq_curve* curves, struct ladder* ladder)
+{
+	double x[LADDER_MAX_RESOLUTIONS][LADDER_MAX_POINTS], d[LADDER_MAX_RESOLUTIONS][LADDER_MAX_POINTS];
+	double bmin[LADDER_MAX_TARGETS][LADDER_MAX_RESOLUTIONS];
+	int reachable[LADDER_MAX_TARGETS];
+	double cand_b[LADDER_MAX_TARGETS * LADDER_MAX_RESOLUTIONS];
+	int cand_r[LADDER_MAX_TARGETS * LADDER_MAX_RESOLUTIONS], cand_mask[LADDER_MAX_TARGETS * LADDER_MAX_RESOLUTIONS];
+	double cost[1 << LADDER_MAX_TARGETS];
+	int from[1 << LADDER_MAX_TARGETS], prev[1 << LADDER_MAX_TARGETS];
+	const struct rq_curve* c;
+	double xi, m, best;
+	int t, r, k, n, n_cand, mask, full, best_r;
+
+	/* check parameters */
+	if (lo == NULL || curves == NULL || ladder == NULL) return -6;
+
+	/* interpolate rate-quality curves in log-bitrate domain: */
+	for (r = 0; r < lo->n_resolutions; r++) {
+		c = &curves[r];
+		if (c->bitrate == NULL || c->metric == NULL) return -6;
+		if (c->n_points < 2 || c->n_points > LADDER_MAX_POINTS) return -13;
+		for (k = 0; k < c->n_points; k++) {
+			if (!(c->bitrate[k] > 0)) return -13;
+			x[r][k] = log(c->bitrate[k]);
+		}
+		if (pchip_init(x[r], c->metric, d[r], c->n_points)) return -13;
+	}
+
+	/* find minimal bitrates reaching target MOS for each target and resolution: */
+	for (t = 0; t < lo->n_targets; t++) {
+		reachable[t] = 0;
+		for (r = 0; r < lo->n_resolutions; r++) {
+			c = &curves[r];
+			bmin[t][r] = HUGE_VAL;
+			if (lo->status[t][r] || lo->required[t][r] < 0)
+				continue;
+			if (lo->required[t][r] <= c->metric[0])
+				bmin[t][r] = c->bitrate[0];
+			else if (!pchip_solve(x[r], c->metric, d[r], c->n_points, lo->required[t][r], &xi))
+				bmin[t][r] = exp(xi);
+			if (bmin[t][r] < HUGE_VAL)
+				reachable[t] = 1;
+		}
+
+		/* target is not reachable -> use top rendition giving highest MOS: */
+		if (!reachable[t]) {
+			best = 0; best_r = -1;
+			for (r = 0; r < lo->n_resolutions; r++) {
+				c = &curves[r];
+				if (lo->status[t][r]) continue;
+				m = metric2mos(&lo->ctx[t][r], lo->metric, c->metric[c->n_points - 1]);
+				if (m > best) { best = m; best_r = r; }
+			}
+			if (best_r >= 0)
+				bmin[t][best_r] = curves[best_r].bitrate[curves[best_r].n_points - 1];
+		}
+	}
+
+	/* candidate renditions, and subsets of targets they serve: */
+	n_cand = 0; full = 0;
+	for (t = 0; t < lo->n_targets; t++) {
+		for (r = 0; r < lo->n_resolutions; r++) {
+			if (bmin[t][r] == HUGE_VAL) continue;
+			cand_r[n_cand] = r;
+			cand_b[n_cand] = bmin[t][r];
+			cand_mask[n_cand] = 0;
+			for (k = 0; k < lo->n_targets; k++)
+				if (bmin[k][r] <= bmin[t][r]) cand_mask[n_cand] |= 1 << k;
+			full |= 1 << t;
+			n_cand++;
+		}
+	}
+
+	/* cheapest cover of all targets (dynamic programming over subsets): */
+	for (mask = 0; mask <= full; mask++) cost[mask] = HUGE_VAL;
+	cost[0] = 0;
+	for (mask = 0; mask < full; mask++) {
+		if (cost[mask] == HUGE_VAL || (mask & ~full)) continue;
+		for (k = 0; k < n_cand; k++) {
+			n = mask | cand_mask[k];
+			if (n != mask && cost[mask] + cand_b[k] < cost[n]) {
+				cost[n] = cost[mask] + cand_b[k];
+				from[n] = k;
+				prev[n] = mask;
+			}
+		}
+	}
+
+	/* collect selected renditions, in the order of increasing bitrates: */
+	ladder->n_rungs = 0;
+	ladder->total_bitrate = 0;
+	for (mask = full; mask; mask = prev[mask]) {
+		struct ladder_rung rung;
+		k = from[mask];
+		rung.resolution = cand_r[k];
+		rung.width = lo->width[cand_r[k]];
+		rung.height = lo->height[cand_r[k]];
+		rung.bitrate = cand_b[k];
+		for (n = ladder->n_rungs; n > 0 && ladder->rungs[n - 1].bitrate > rung.bitrate; n--)
+			ladder->rungs[n] = ladder->rungs[n - 1];
+		ladder->rungs[n] = rung;
+		ladder->n_rungs++;
+		ladder->total_bitrate += rung.bitrate;
+	}
+
+	/* serve each target by the cheapest rung reaching its target MOS: */
+	for (t = 0; t < lo->n_targets; t++) {
+		ladder->rung[t] = -1;
+		ladder->mos[t] = 0;
+		ladder->reached[t] = reachable[t];
+		for (k = 0; k < ladder->n_rungs; k++) {
+			r = ladder->rungs[k].resolution;
+			if (bmin[t][r] <= ladder->rungs[k].bitrate) {
+				c = &curves[r];
+				m = pchip_eval(x[r], c->metric, d[r], c->n_points, log(ladder->rungs[k].bitrate));
+				ladder->rung[t] = k;
+				ladder->mos[t] = metric2mos(&lo->ctx[t][r], lo->metric, m);
+				break;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/* pmos_ladder.c -- end of file */
@@ -0,0 +1,79 @@
+/*!
+ *  \file  pmos_ladder.h
+ *  \brief Per-title encoding ladder optimizer targeting device-specific MOS.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _PMOS_LADDER_H_
+#define _PMOS_LADDER_H_ 1
+#include "pmos.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LADDER_MAX_TARGETS      8	/* max number of target device classes */
+#define LADDER_MAX_RESOLUTIONS  16	/* max number of encoding resolutions */
+#define LADDER_MAX_POINTS       64	/* max number of points in a rate-quality curve */
+
+/*! Target device class: */
+struct ladder_target {
+	int device;			/* device type (see enum device_types) */
+	struct device_params* params;	/* custom device parameters (for device_custom) */
+	int player_width;		/* player width [pixels] */
+	int player_height;		/* player height [pixels] */
+	int hdr;			/* indicator if video is hdr (1) or sdr (0) */
+	int upsampling;			/* assumed upsampling method (see enum upsampling_methods) */
+	double mos;			/* target MOS score */
+};
+
+/*! Rate-quality curve of a title encoded at one resolution: */
+struct rq_curve {
+	int n_points;			/* number of points */
+	const double* bitrate;		/* bitrates [kbps], strictly increasing */
+	const double* metric;		/* metric scores */
+};
+
+/*! Ladder optimizer - per-device viewing contexts and inverse model solutions cached across titles: */
+struct ladder_optimizer {
+	int metric;						/* metric type (see enum metric_types) */
+	int n_targets;						/* number of target device classes */
+	int n_resolutions;					/* number of encoding resolutions */
+	struct ladder_target targets[LADDER_MAX_TARGETS];	/* target device classes */
+	int width[LADDER_MAX_RESOLUTIONS];			/* encoding resolutions [pixels] */
+	int height[LADDER_MAX_RESOLUTIONS];
+	struct viewing_context ctx[LADDER_MAX_TARGETS][LADDER_MAX_RESOLUTIONS];	/* viewing contexts */
+	int status[LADDER_MAX_TARGETS][LADDER_MAX_RESOLUTIONS];			/* 0 - valid viewing setup, <0 - error */
+	double required[LADDER_MAX_TARGETS][LADDER_MAX_RESOLUTIONS];		/* metric scores reaching target MOS, <0 - error */
+};
+
+/*! Ladder rung: */
+struct ladder_rung {
+	int resolution;			/* index of encoding resolution */
+	int width;			/* video width [pixels] */
+	int height;			/* video height [pixels] */
+	double bitrate;			/* bitrate [kbps] */
+};
+
+/*! Optimized ladder: */
+struct ladder {
+	int n_rungs;					/* number of rungs */
+	struct ladder_rung rungs[LADDER_MAX_TARGETS];	/* rungs, in the order of increasing bitrates */
+	double total_bitrate;				/* sum of bitrates of all rungs [kbps] */
+	int rung[LADDER_MAX_TARGETS];			/* index of rung serving each target, -1 - none */
+	double mos[LADDER_MAX_TARGETS];			/* predicted MOS for each target */
+	int reached[LADDER_MAX_TARGETS];		/* indicators if target MOS is reached (1) or not (0) */
+};
+
+/*! Function prototypes: */
+int ladder_init(struct ladder_optimizer* lo, int metric, const struct ladder_target* targets, int n_targets, const int* widths, const int* heights, int n_resolutions);
+int ladder_optimize(const struct ladder_optimizer* lo, const struct rq_curve* curves, struct ladder* ladder);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
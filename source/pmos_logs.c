@@ -0,0 +1,223 @@
+/*!
+ *  \file  pmos_logs.c
+ *  \brief Parsers of per-frame metric logs (libvmaf, FFmpeg psnr/ssim filters).
+ *
+ *  Supported formats (detected automatically):
+ *
+ *    libvmaf JSON  - {"frames": [{"frameNum": 0, "metrics": {"psnr_y": 38.1, "vmaf": 91.2, ...}}, ...], ...}
+ *    libvmaf XML   - <frames><frame frameNum="0" psnr_y="38.1" vmaf="91.2" ... /> ... </frames>
+ *    FFmpeg psnr   - n:1 mse_avg:10.2 mse_y:8.5 ... psnr_avg:38.0 psnr_y:38.8 ... (one line per frame)
+ *    FFmpeg ssim   - n:1 Y:0.987 U:0.991 V:0.990 All:0.988 (19.2) (one line per frame)
+ *
+ *  libvmaf scores are looked up by feature names: psnr_y (PSNR), float_ssim or ssim (SSIM), vif
+ *  (VIF), and vmaf (VMAF). libvmaf reports VIF per scale (vif_scale0 .. vif_scale3, or
+ *  integer_vif_scale0 .. integer_vif_scale3 in libvmaf 2.x), so without a vif feature, VIF of each
+ *  frame is the mean of its scale scores. FFmpeg logs carry luma PSNR (psnr_y) or luma SSIM (Y)
+ *  only. Pooled metrics in libvmaf logs are ignored; per-frame scores are clamped to the valid range
+ *  of the metric (e.g. infinite PSNR of identical frames becomes 100 dB) and pooled by mean and min.
+ *
+ *  Parsers work on NUL-terminated text, as delivered by ingest_files().
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pmos.h"
+#include "pmos_logs.h"
+
+/*! libvmaf feature names of metrics (in the order of preference): */
+static const char* vmaf_features[n_metric_types][3] = {
+	{"psnr_y", "psnr", NULL},	/* PSNR */
+	{"float_ssim", "ssim", NULL},	/* SSIM */
+	{"vif", NULL, NULL},		/* VIF  */
+	{"vmaf", NULL, NULL}		/* VMAF */
+};
+
+/*! libvmaf prefixes of per-scale VIF feature names (vif_scale0 .. vif_scale3): */
+static const char* vif_scale_prefixes[2] = {"", "integer_"};
+
+static const char* skip_spaces(const char* p)
+{
+	while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+	return p;
+}
+
+/*!
+ * \brief Detects format of a log.
+ *
+ * \param[in]  text			NUL-terminated log
+ *
+ * \returns    log format (see enum log_formats)
+ */
+int log_format(const char* text)
+{
+	const char* p;
+
+	if (text == NULL) return log_unknown;
+	p = skip_spaces(text);
+	if (*p == '{' && strstr(p, "\"frames\"") != NULL) return log_vmaf_json;
+	if (*p == '<' && strstr(p, "<frames") != NULL) return log_vmaf_xml;
+	if (p[0] == 'n' && p[1] == ':') {
+		if (strstr(p, "psnr_avg:") != NULL) return log_ffmpeg_psnr;
+		if (strstr(p, " All:") != NULL) return log_ffmpeg_ssim;
+	}
+	return log_unknown;
+}
+
+/*!
+ * \brief Adds a per-frame score (clamped to the valid range of the metric) to pooled scores.
+ */
+static void pool_score(double v, int metric, struct log_summary* s)
+{
+	double v_min, v_max;
+
+	metric_range(metric, &v_min, &v_max);
+	if (v < v_min) v = v_min;
+	if (v > v_max) v = v_max;
+	s->mean += v;
+	if (s->n_frames == 0 || v < s->min) s->min = v;
+	s->n_frames++;
+}
+
+/*!
+ * \brief Pools all scores that follow occurrences of a pattern in [begin, end).
+ *
+ *  In JSON mode, the pattern must be followed by a colon (with optional spaces around it).
+ */
+static void pool_scores(const char* begin, const char* end, const char* pattern, int json, int metric, struct log_summary* s)
+{
+	size_t len = strlen(pattern);
+	const char *p, *q;
+	char* e;
+	double v;
+
+	for (p = strstr(begin, pattern); p != NULL && p < end; p = strstr(p, pattern)) {
+		q = p + len;
+		if (json) {
+			q = skip_spaces(q);
+			if (*q != ':') { p = q; continue; }
+			q = skip_spaces(q + 1);
+		}
+		v = strtod(q, &e);
+		p = e > q ? e : q;
+		if (e == q || v != v) continue;
+		pool_score(v, metric, s);
+	}
+}
+
+/*!
+ * \brief Finds score that follows the first occurrence of a pattern in [begin, end).
+ *
+ * \returns 1 - found, 0 - not found
+ */
+static int find_score(const char* begin, const char* end, const char* pattern, int json, double* v)
+{
+	size_t len = strlen(pattern);
+	const char *p, *q;
+	char* e;
+
+	for (p = begin; p + len <= end; p++) {
+		if (*p != *pattern || memcmp(p, pattern, len)) continue;
+		q = p + len;
+		if (json) {
+			q = skip_spaces(q);
+			if (*q != ':') continue;
+			q = skip_spaces(q + 1);
+		}
+		*v = strtod(q, &e);
+		if (e > q && *v == *v) return 1;
+	}
+	return 0;
+}
+
+/*!
+ * \brief Pools VIF of frames in [begin, end), as means of per-scale VIF scores of each frame.
+ */
+static void pool_vif_scales(const char* begin, const char* end, int json, struct log_summary* s)
+{
+	const char *marker = json ? "\"frameNum\"" : "<frame ", *frame, *next;
+	char patterns[4][2][32];
+	double v, sum;
+	int k, i, n;
+
+	for (k = 0; k < 4; k++)
+		for (i = 0; i < 2; i++)
+			sprintf(patterns[k][i], json ? "\"%svif_scale%d\"" : " %svif_scale%d=\"", vif_scale_prefixes[i], k);
+
+	for (frame = strstr(begin, marker); frame != NULL && frame < end; frame = next) {
+		next = strstr(frame + 1, marker);
+		if (next == NULL || next > end) next = end;
+		for (sum = 0, n = 0, k = 0; k < 4; k++)
+			for (i = 0; i < 2; i++)
+				if (find_score(frame, next, patterns[k][i], json, &v)) { sum += v; n++; break; }
+		if (n) pool_score(sum / n, metric_vif, s);
+	}
+}
+
+/*!
+ * \brief Parses a metric log, and pools per-frame scores of a given metric.
+ *
+ * \param[in]  text			NUL-terminated log
+ * \param[in]  metric			metric type (see enum metric_types)
+ * \param[out] s			pooled scores
+ *
+ * \returns    0				success
+ *			  -1				invalid parameters
+ *			  -2				unknown log format
+ *			  -3				no scores of this metric in the log
+ */
+int parse_metric_log(const char* text, int metric, struct log_summary* s)
+{
+	const char *begin, *end;
+	char pattern[32];
+	int i;
+
+	if (text == NULL || s == NULL || metric < 0 || metric >= n_metric_types) return -1;
+	s->format = log_format(text);
+	s->n_frames = 0;
+	s->mean = s->min = 0;
+
+	switch (s->format) {
+	case log_vmaf_json:
+	case log_vmaf_xml:
+		/* per-frame section: */
+		if (s->format == log_vmaf_json) {
+			begin = strstr(text, "\"frames\"");
+			end = strstr(begin, "\"pooled_metrics\"");
+		} else {
+			begin = strstr(text, "<frames");
+			end = strstr(begin, "</frames>");
+		}
+		if (end == NULL) end = begin + strlen(begin);
+
+		/* first feature name of the metric present in the log: */
+		for (i = 0; i < 3 && vmaf_features[metric][i] != NULL && s->n_frames == 0; i++) {
+			strcpy(pattern, s->format == log_vmaf_json ? "\"" : " ");
+			strcat(pattern, vmaf_features[metric][i]);
+			strcat(pattern, s->format == log_vmaf_json ? "\"" : "=\"");
+			pool_scores(begin, end, pattern, s->format == log_vmaf_json, metric, s);
+		}
+		if (metric == metric_vif && s->n_frames == 0) pool_vif_scales(begin, end, s->format == log_vmaf_json, s);
+		break;
+	case log_ffmpeg_psnr:
+		if (metric == metric_psnr) pool_scores(text, text + strlen(text), "psnr_y:", 0, metric, s);
+		break;
+	case log_ffmpeg_ssim:
+		if (metric == metric_ssim) pool_scores(text, text + strlen(text), " Y:", 0, metric, s);
+		break;
+	default:
+		return -2;
+	}
+
+	if (s->n_frames == 0) return -3;
+	s->mean /= s->n_frames;
+	return 0;
+}
+
+/* pmos_logs.c -- end of file */
@@ -0,0 +1,44 @@
+/*!
+ *  \file  pmos_logs.h
+ *  \brief Parsers of per-frame metric logs (libvmaf, FFmpeg psnr/ssim filters).
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _PMOS_LOGS_H_
+#define _PMOS_LOGS_H_ 1
+#include "pmos.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! Log formats: */
+enum log_formats {
+	log_unknown = 0,		/* not recognized */
+	log_vmaf_json,			/* libvmaf --json output */
+	log_vmaf_xml,			/* libvmaf --xml output */
+	log_ffmpeg_psnr,		/* FFmpeg psnr filter stats_file */
+	log_ffmpeg_ssim,		/* FFmpeg ssim filter stats_file */
+	n_log_formats			/* the number of log formats defined by this enum */
+};
+
+/*! Per-frame metric scores pooled over a log: */
+struct log_summary {
+	int format;			/* log format (see enum log_formats) */
+	int n_frames;			/* number of frames */
+	double mean;			/* mean score */
+	double min;			/* min score */
+};
+
+/*! Function prototypes: */
+int log_format(const char* text);
+int parse_metric_log(const char* text, int metric, struct log_summary* s);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,501 @@
+/*!
+ *  \file  pmos_oracle.c
+ *  \brief Reference (long double) implementation of models, and differential tester of fast paths.
+ *
+ *  Reference functions evaluate the generalized WR model [2], viewing geometry and fused models [3]
+ *  directly by their formulae, in long double arithmetic and with model parameters taken from the
+ *  tables of pmos.c. They are slow, but serve as an oracle: errors of double-precision code are
+ *  then measured against a result that is more accurate than any of them. (Where long double is the
+ *  same as double, e.g. with MSVC, the oracle is only as accurate as the paths it checks.)
+ *
+ *  The differential tester sweeps two domains in parallel (see parallel_for()):
+ *   - viewing angles and angular resolutions (log-spaced), for all HDR indicators, upsampling methods,
+ *     metrics and metric scores, checking wr_score(), metric2mos(), metric2mos_batch(), surrogates,
+ *     and (in a second pass) reproducible mode;
+ *   - video and player widths (log-spaced) on all devices, checking device_to_viewing_params(), and
+ *     the end-to-end psnr2mos()..vmaf2mos(), score_batch() and mos_grid().
+ *  Domains are split into chunks of DIFF_CHUNK points, and errors of chunks are merged in the same
+ *  order, so reports do not depend on the number of threads.
+ *
+ *  Reproducible mode is switched on for the second pass, so diff_test() must not run concurrently
+ *  with other scoring in the same process.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include "pmos.h"
+#include "pmos_batch.h"
+#include "pmos_grid.h"
+#include "pmos_surrogate.h"
+#include "pmos_thread.h"
+#include "pmos_oracle.h"
+
+#define PI_L  3.141592653589793238462643383279502884L
+#define DIFF_CHUNK  16		/* number of domain points per chunk */
+
+/****************************
+ *
+ * Reference implementation:
+ *
+ *   ref_wr_model()        - generalized WR model [2]
+ *   ref_metric_to_q()     - mapping of metric scores to MOS scale [3]
+ *   ref_fused_mos()       - fused MOS score [3]
+ *   ref_viewing_params()  - viewing angle and angular resolution of a given player and device
+ *   ref_metric2mos()      - fused models [3] for given viewing setup
+ *
+ ***/
+
+static long double clamp_mos(long double mos)
+{
+	return mos < 1 ? 1 : mos > 5 ? 5 : mos;
+}
+
+/*!
+ * \brief Generalized WR model [2, formulae 8] in long double.
+ *
+ * \returns   >0				WR score (in [1..5])
+ *			  <0				error (see wr_score())
+ */
+long double ref_wr_model(long double phi, long double u, int hdr, int upsampling)
+{
+	const struct wr_params* wr;
+	long double f_phi, f_u;
+
+	if (hdr < 0 || hdr > 1) return -3;
+	if ((wr = wr_model_params(hdr, upsampling)) == NULL) return -4;
+	if (phi < 1 || phi > 180) return -8;
+	if (u < 1 || u > 200) return -8;
+
+	f_phi = powl(1 + powl(phi / wr->phi_s, -(long double)wr->k), -(long double)wr->gamma / wr->k);
+	f_u = powl(1 + powl(u / wr->u_s, -(long double)wr->l), -(long double)wr->delta / wr->l);
+	return clamp_mos(logl(wr->alpha + wr->beta * f_phi * f_u));
+}
+
+/*!
+ * \brief Maps metric score to MOS scale [3, formulae 4, 5] in long double.
+ *
+ * \returns  >=0				mapped score
+ *			  -9				invalid metric score
+ *			  -10				invalid metric type
+ */
+long double ref_metric_to_q(int metric, long double value)
+{
+	const struct fusion_params* f;
+	double lo, hi;
+
+	if ((f = fusion_model_params(metric)) == NULL) return -10;
+	metric_range(metric, &lo, &hi);
+	if (value < lo || value > hi) return -9;
+	if (metric == metric_vmaf) return value;
+	return 1 / (1 + expl(-(long double)f->epsilon * (value - f->zeta)));
+}
+
+/*!
+ * \brief Fused MOS score [3, formula 2] in long double.
+ *
+ * \param[in]  metric			metric type (see enum metric_types)
+ * \param[in]  qwr			WR score (see ref_wr_model())
+ * \param[in]  q				mapped metric score (see ref_metric_to_q())
+ *
+ * \returns   >0				MOS score (in [1..5])
+ *			  <0				error (passed from qwr or q)
+ */
+long double ref_fused_mos(int metric, long double qwr, long double q)
+{
+	const struct fusion_params* f;
+
+	if ((f = fusion_model_params(metric)) == NULL) return -10;
+	if (qwr < 0) return qwr;
+	if (q < 0) return q;
+	return clamp_mos(f->alpha + f->beta * (1 + f->gamma * qwr) * q + f->delta * qwr);
+}
+
+/*!
+ * \brief Computes viewing angle and angular resolution of a given player and device in long double.
+ *
+ * \param[out] p_phi			viewing angle [degrees]
+ * \param[out] p_u				angular resolution [cycles per degree]
+ *
+ * \returns    0				success
+ *			  <0				error (see device_to_viewing_params())
+ */
+int ref_viewing_params(int width, int height, int player_width, int player_height, int hdr, int upsampling, int device, struct device_params* params, long double* p_phi, long double* p_u)
+{
+	struct device_params display;
+	long double distance, phi, u;
+	double d;
+	int err;
+
+	if (width < 1 || width > 8192) return -1;
+	if (height < 1 || height > 8192) return -1;
+	if (player_width < 1 || player_width > 8192) return -2;
+	if (player_height < 1 || player_height > 8192) return -2;
+	if (hdr < 0 || hdr > 1) return -3;
+	if (upsampling < 0 || upsampling >= n_upsampling_methods) return -4;
+	if (device < 0 || device >= n_device_types) return -5;
+	if (p_phi == NULL || p_u == NULL) return -6;
+	if ((err = device_geometry(device, params, &display, &d))) return err;
+
+	/* absolute viewing distance [inches]: */
+	distance = display.distance;
+	if (display.distance_type)
+		distance = (long double)display.display_height / display.ppi_y * display.distance;
+
+	/* viewing angle, and angular resolution (cycles of 2 rendered pixels per degree): */
+	phi = 360 / PI_L * atanl(player_width / (2 * distance * display.ppi_x));
+	u = PI_L / 360 / atanl(player_width / ((long double)(width < player_width ? width : player_width) * distance * display.ppi_x));
+	if (phi < 1 || phi > 180) return -8;
+	if (u < 1 || u > 200) return -8;
+
+	*p_phi = phi;
+	*p_u = u;
+	return 0;
+}
+
+/*!
+ * \brief Fused models [3] for given metric score and viewing setup in long double.
+ *
+ * \returns   >0				MOS score (in [1..5])
+ *			  <0				error (see psnr2mos())
+ */
+long double ref_metric2mos(int metric, double value, int width, int height, int player_width, int player_height, int hdr, int upsampling, int device, struct device_params* params)
+{
+	long double phi, u;
+	int err;
+
+	if (metric < 0 || metric >= n_metric_types) return -10;
+	if ((err = ref_viewing_params(width, height, player_width, player_height, hdr, upsampling, device, params, &phi, &u))) return err;
+	return ref_fused_mos(metric, ref_wr_model(phi, u, hdr, upsampling), ref_metric_to_q(metric, value));
+}
+
+/****************************
+ *
+ * Differential tester:
+ *
+ *   diff_path_name()  - returns name of a fast path
+ *   diff_test()       - sweeps the domain, and measures errors of all fast paths against the reference
+ *
+ ***/
+
+/*! Tester job: */
+struct diff_job {
+	const struct diff_domain* domain;
+	double* values;			/* metric scores [metric][n_values] */
+	int n_devices;			/* number of swept devices */
+	int n_model;			/* number of points of (phi, u) domain */
+	int n;				/* number of points to check */
+	int repro;			/* 1 - second pass (reproducible mode) */
+	struct diff_stats* stats;	/* errors per chunk and path [chunk][n_diff_paths] */
+};
+
+/*! Scalar models (the order of records in this table follows values of enum metric_types): */
+static double (*const scalar_models[n_metric_types])(double, int, int, int, int, int, int, int, struct device_params*) =
+{
+	psnr2mos, ssim2mos, vif2mos, vmaf2mos
+};
+
+static const char* path_names[n_diff_paths] =
+{
+	"wr_score", "geometry", "scalar", "context", "batch", "score_batch", "grid", "surrogate", "reproducible"
+};
+
+/*!
+ * \brief Returns name of a fast path (see enum diff_paths), NULL - invalid path.
+ */
+const char* diff_path_name(int path)
+{
+	if (path < 0 || path >= n_diff_paths) return NULL;
+	return path_names[path];
+}
+
+/*!
+ * \brief Returns i-th of n log-spaced points in [lo, hi].
+ */
+static double log_spaced(double lo, double hi, int i, int n)
+{
+	return n > 1 ? lo * pow(hi / lo, (double)i / (n - 1)) : lo;
+}
+
+/*!
+ * \brief Records result of a fast path at a point (errors are compared as codes).
+ */
+static void record(struct diff_stats* s, int err, int ref_err, double e, const struct diff_point* pt)
+{
+	if (err || ref_err) {
+		if (err != ref_err) s->mismatches++;
+		return;
+	}
+	if (s->n == 0 || e > s->max_error) {
+		s->max_error = e;
+		s->worst = *pt;
+	}
+	s->n++;
+	s->mean_error += e;		/* sum, until merged */
+}
+
+static void record_mos(struct diff_stats* s, double mos, long double ref, const struct diff_point* pt)
+{
+	record(s, mos < 0 ? (int)mos : 0, ref < 0 ? (int)ref : 0, (double)fabsl(mos - ref), pt);
+}
+
+/*!
+ * \brief Checks paths evaluated over (phi, u) domain at a given point.
+ */
+static void model_point(struct diff_job* job, int k, double* mos, struct diff_stats* s)
+{
+	const struct diff_domain* d = job->domain;
+	struct viewing_context ctx;
+	struct surrogate sur;
+	struct diff_point pt;
+	const double* values;
+	long double ref_qwr, ref;
+	double qwr;
+	int metric, fit, i;
+
+	/* point: */
+	memset(&pt, 0, sizeof(pt));
+	pt.metric = pt.device = -1;
+	pt.u = log_spaced(1, 200, k % d->n_u, d->n_u);
+	k /= d->n_u;
+	pt.phi = log_spaced(1, 179, k % d->n_phi, d->n_phi);
+	k /= d->n_phi;
+	pt.upsampling = k % n_upsampling_methods;
+	pt.hdr = k / n_upsampling_methods;
+
+	/* WR score: */
+	ref_qwr = ref_wr_model(pt.phi, pt.u, pt.hdr, pt.upsampling);
+	qwr = wr_score(pt.phi, pt.u, pt.hdr, pt.upsampling);
+	record_mos(&s[job->repro ? diff_repro : diff_wr], qwr, ref_qwr, &pt);
+	if (qwr < 0 || ref_qwr < 0) return;
+
+	/* fused models: */
+	ctx.phi = pt.phi;
+	ctx.u = pt.u;
+	ctx.hdr = pt.hdr;
+	ctx.upsampling = pt.upsampling;
+	ctx.qwr = qwr;
+	for (metric = 0; metric < n_metric_types; metric++) {
+		values = job->values + metric * d->n_values;
+		pt.metric = metric;
+		fit = -1;
+		if (!job->repro) {
+			metric2mos_batch(&ctx, metric, values, mos, d->n_values);
+			if (d->surrogate_tolerance > 0 && (fit = surrogate_fit(&ctx, metric, d->surrogate_tolerance, &sur)))
+				s[diff_surrogate].mismatches++;
+		}
+		for (i = 0; i < d->n_values; i++) {
+			pt.value = values[i];
+			ref = ref_fused_mos(metric, ref_qwr, ref_metric_to_q(metric, values[i]));
+			if (job->repro) {
+				record_mos(&s[diff_repro], metric2mos(&ctx, metric, values[i]), ref, &pt);
+				continue;
+			}
+			record_mos(&s[diff_context], metric2mos(&ctx, metric, values[i]), ref, &pt);
+			record_mos(&s[diff_batch], mos[i], ref, &pt);
+			if (fit == 0) record_mos(&s[diff_surrogate], surrogate_eval(&sur, values[i]), ref, &pt);
+		}
+	}
+}
+
+/*!
+ * \brief Checks paths evaluated over viewing geometries at a given point.
+ */
+static void geometry_point(struct diff_job* job, int k, double* mos, struct diff_stats* s)
+{
+	const struct diff_domain* d = job->domain;
+	struct score_batch batch;
+	struct grid_axes axes;
+	struct diff_point pt;
+	const double* values;
+	long double ref_phi = 0, ref_u = 0, ref_qwr = 0, ref;
+	double phi = 0, u = 0, *grid = mos + d->n_values;
+	int height, player_height, hdr, upsampling, metric, i, err, ref_err;
+
+	/* point: */
+	memset(&pt, 0, sizeof(pt));
+	pt.metric = -1;
+	pt.width = (int)floor(log_spaced(16, 8192, k % d->n_widths, d->n_widths) + 0.5);
+	k /= d->n_widths;
+	pt.player_width = (int)floor(log_spaced(16, 8192, k % d->n_widths, d->n_widths) + 0.5);
+	k /= d->n_widths;
+	pt.device = k < device_custom ? k : device_custom;
+	height = pt.width * 9 / 16;
+	player_height = pt.player_width * 9 / 16;
+
+	/* viewing geometry: */
+	err = device_to_viewing_params(pt.width, height, pt.player_width, player_height, 0, 0, pt.device, d->params, &phi, &u);
+	ref_err = ref_viewing_params(pt.width, height, pt.player_width, player_height, 0, 0, pt.device, d->params, &ref_phi, &ref_u);
+	pt.phi = (double)ref_phi;
+	pt.u = (double)ref_u;
+	record(&s[diff_geometry], err, ref_err, (double)fmaxl(fabsl(phi - ref_phi) / ref_phi, fabsl(u - ref_u) / ref_u), &pt);
+
+	/* end-to-end models: */
+	batch.n = d->n_values;
+	batch.values_stride = 1;
+	batch.width.data = &pt.width;
+	batch.height.data = &height;
+	batch.player_width.data = &pt.player_width;
+	batch.player_height.data = &player_height;
+	batch.hdr.data = &pt.hdr;
+	batch.upsampling.data = &pt.upsampling;
+	batch.device.data = &pt.device;
+	batch.width.stride = batch.height.stride = batch.player_width.stride = batch.player_height.stride = 0;
+	batch.hdr.stride = batch.upsampling.stride = batch.device.stride = 0;
+	batch.params = d->params;
+	batch.store = NULL;
+	memset(&axes, 0, sizeof(axes));
+	axes.n_values = d->n_values;
+	axes.n_widths = axes.n_player_widths = 1;
+	axes.widths = &pt.width;
+	axes.player_widths = &pt.player_width;
+	for (hdr = 0; hdr <= 1; hdr++) {
+		for (upsampling = 0; upsampling < n_upsampling_methods; upsampling++) {
+			pt.hdr = hdr;
+			pt.upsampling = upsampling;
+			if (!ref_err) ref_qwr = ref_wr_model(ref_phi, ref_u, hdr, upsampling);
+			for (metric = 0; metric < n_metric_types; metric++) {
+				values = job->values + metric * d->n_values;
+				pt.metric = metric;
+				batch.values = values;
+				axes.values = values;
+				score_batch(metric, &batch, mos, 1);
+				if ((err = mos_grid(metric, hdr, upsampling, pt.device, d->params, &axes, grid)))
+					for (i = 0; i < d->n_values; i++) grid[i] = err;
+				for (i = 0; i < d->n_values; i++) {
+					pt.value = values[i];
+					ref = ref_err ? ref_err : ref_fused_mos(metric, ref_qwr, ref_metric_to_q(metric, values[i]));
+					record_mos(&s[diff_scalar], scalar_models[metric](values[i], pt.width, height, pt.player_width, player_height, hdr, upsampling, pt.device, d->params), ref, &pt);
+					record_mos(&s[diff_score_batch], mos[i], ref, &pt);
+					record_mos(&s[diff_grid], grid[i], ref, &pt);
+				}
+			}
+		}
+	}
+}
+
+/*!
+ * \brief Checks chunks [begin, end) of the domain.
+ */
+static void diff_chunks(void* arg, int begin, int end)
+{
+	struct diff_job* job = (struct diff_job*)arg;
+	struct diff_stats* s;
+	double* mos;
+	int c, k;
+
+	mos = (double*)malloc(2 * job->domain->n_values * sizeof(double));
+	for (c = begin; c < end; c++) {
+		s = job->stats + (size_t)c * n_diff_paths;
+		memset(s, 0, n_diff_paths * sizeof(struct diff_stats));
+		if (mos == NULL) { s->n = -1; continue; }
+		for (k = c * DIFF_CHUNK; k < (c + 1) * DIFF_CHUNK && k < job->n; k++) {
+			if (k < job->n_model) model_point(job, k, mos, s);
+			else geometry_point(job, k - job->n_model, mos, s);
+		}
+	}
+	free(mos);
+}
+
+/*!
+ * \brief Merges errors of chunks into the report (in the order of chunks).
+ *
+ * \returns 0 - success, -15 - some chunks failed to allocate memory
+ */
+static int diff_merge(const struct diff_job* job, int n_chunks, struct diff_report* report)
+{
+	const struct diff_stats* from;
+	struct diff_stats* to;
+	int c, p;
+
+	for (c = 0; c < n_chunks; c++) {
+		if (job->stats[(size_t)c * n_diff_paths].n < 0) return -15;
+		for (p = 0; p < n_diff_paths; p++) {
+			from = &job->stats[(size_t)c * n_diff_paths + p];
+			to = &report->paths[p];
+			if (from->n && (to->n == 0 || from->max_error > to->max_error)) {
+				to->max_error = from->max_error;
+				to->worst = from->worst;
+			}
+			to->n += from->n;
+			to->mismatches += from->mismatches;
+			to->mean_error += from->mean_error;
+		}
+	}
+	return 0;
+}
+
+/*!
+ * \brief Sweeps the domain, and measures errors of all fast paths against the reference.
+ *
+ * \param[in]  domain			swept domain
+ * \param[in]  n_threads		number of threads (0 - use all cores, 1 - run in the calling thread)
+ * \param[out] report			errors per path
+ *
+ * \returns    0				success
+ *			  -6				NULL pointer
+ *			  -12				invalid domain
+ *			  -15				memory allocation failure
+ */
+int diff_test(const struct diff_domain* domain, int n_threads, struct diff_report* report)
+{
+	struct diff_job job;
+	double lo, hi, start;
+	int metric, n_chunks, repro, p, i, err;
+
+	/* check parameters: */
+	if (domain == NULL || report == NULL) return -6;
+	if (domain->n_phi < 1 || domain->n_u < 1 || domain->n_values < 1 || domain->n_widths < 1) return -12;
+	if (!(domain->surrogate_tolerance >= 0)) return -12;
+	job.domain = domain;
+	job.n_devices = domain->params ? n_device_types : device_custom;
+	if ((double)domain->n_phi * domain->n_u * 2 * n_upsampling_methods + (double)job.n_devices * domain->n_widths * domain->n_widths > INT_MAX / 2) return -12;
+	job.n_model = domain->n_phi * domain->n_u * 2 * n_upsampling_methods;
+	job.n = job.n_model + job.n_devices * domain->n_widths * domain->n_widths;
+	n_chunks = (job.n + DIFF_CHUNK - 1) / DIFF_CHUNK;
+
+	job.values = (double*)malloc(n_metric_types * domain->n_values * sizeof(double));
+	job.stats = (struct diff_stats*)malloc((size_t)n_chunks * n_diff_paths * sizeof(struct diff_stats));
+	if (job.values == NULL || job.stats == NULL) { free(job.values); free(job.stats); return -15; }
+	for (metric = 0; metric < n_metric_types; metric++) {
+		metric_range(metric, &lo, &hi);
+		for (i = 0; i < domain->n_values; i++)
+			job.values[metric * domain->n_values + i] = lo + (hi - lo) * (i + 0.5) / domain->n_values;
+	}
+	memset(report, 0, sizeof(*report));
+	start = wall_clock();
+
+	/* all paths, in current mode: */
+	job.repro = 0;
+	parallel_for(n_chunks, n_threads, diff_chunks, &job);
+	err = diff_merge(&job, n_chunks, report);
+
+	/* paths over (phi, u) domain in reproducible mode: */
+	if (!err) {
+		repro = reproducible_mode();
+		set_reproducible_mode(1);
+		job.repro = 1;
+		job.n = job.n_model;
+		n_chunks = (job.n + DIFF_CHUNK - 1) / DIFF_CHUNK;
+		parallel_for(n_chunks, n_threads, diff_chunks, &job);
+		set_reproducible_mode(repro);
+		err = diff_merge(&job, n_chunks, report);
+	}
+
+	for (p = 0; p < n_diff_paths; p++)
+		if (report->paths[p].n) report->paths[p].mean_error /= report->paths[p].n;
+	report->seconds = wall_clock() - start;
+
+	free(job.values);
+	free(job.stats);
+	return err;
+}
+
+/* pmos_oracle.c -- end of file */
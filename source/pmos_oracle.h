@@ -0,0 +1,81 @@
+/*!
+ *  \file  pmos_oracle.h
+ *  \brief Reference (long double) implementation of models, and differential tester of fast paths.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _PMOS_ORACLE_H_
+#define _PMOS_ORACLE_H_ 1
+#include "pmos.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! Fast paths checked by differential tester: */
+enum diff_paths {
+	diff_wr = 0,			/* wr_score() */
+	diff_geometry,			/* device_to_viewing_params() (relative errors of viewing angle and angular resolution) */
+	diff_scalar,			/* psnr2mos(), ssim2mos(), vif2mos(), vmaf2mos() */
+	diff_context,			/* metric2mos() with viewing contexts */
+	diff_batch,			/* metric2mos_batch() */
+	diff_score_batch,		/* score_batch() (with geometry cache) */
+	diff_grid,			/* mos_grid() */
+	diff_surrogate,			/* surrogate_eval() of fitted surrogates */
+	diff_repro,			/* wr_score() and metric2mos() in reproducible mode */
+	n_diff_paths			/* the number of paths defined by this enum */
+};
+
+/*! Domain swept by differential tester: */
+struct diff_domain {
+	int n_phi;			/* number of viewing angles in [1, 179] (log-spaced) */
+	int n_u;			/* number of angular resolutions in [1, 200] (log-spaced) */
+	int n_values;			/* number of scores per metric (midpoints of equal parts of metric range) */
+	int n_widths;			/* number of video and player widths in [16, 8192] (log-spaced) */
+	struct device_params* params;	/* custom device (swept as device_custom), NULL - standard devices only */
+	double surrogate_tolerance;	/* tolerance of surrogates [MOS], 0 - skip surrogate path */
+};
+
+/*! Point of the domain: */
+struct diff_point {
+	int metric;			/* metric type, -1 - not applicable (WR score, geometry) */
+	double value;			/* metric score */
+	double phi, u;			/* viewing angle [degrees] and angular resolution [cpd] */
+	int hdr, upsampling;		/* content type and upsampling method */
+	int device;			/* device type, -1 - not applicable (paths evaluated over phi, u) */
+	int width, player_width;	/* video and player widths [pixels] */
+};
+
+/*! Errors of a fast path: */
+struct diff_stats {
+	long long n;			/* number of compared scores (valid in both path and reference) */
+	long long mismatches;		/* number of points where path and reference disagree on validity (error codes) */
+	double max_error;		/* max absolute error [MOS] (relative error for geometry) */
+	double mean_error;		/* mean absolute error */
+	struct diff_point worst;	/* point with max error */
+};
+
+/*! Report of differential tester: */
+struct diff_report {
+	struct diff_stats paths[n_diff_paths];	/* errors per path (n == 0 - path not checked) */
+	double seconds;			/* run time [s] */
+};
+
+/*! Function prototypes: */
+long double ref_wr_model(long double phi, long double u, int hdr, int upsampling);
+long double ref_metric_to_q(int metric, long double value);
+long double ref_fused_mos(int metric, long double qwr, long double q);
+int ref_viewing_params(int width, int height, int player_width, int player_height, int hdr, int upsampling, int device, struct device_params* params, long double* p_phi, long double* p_u);
+long double ref_metric2mos(int metric, double value, int width, int height, int player_width, int player_height, int hdr, int upsampling, int device, struct device_params* params);
+
+const char* diff_path_name(int path);
+int diff_test(const struct diff_domain* domain, int n_threads, struct diff_report* report);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
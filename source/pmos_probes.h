@@ -0,0 +1,49 @@
+/*!
+ *  \file  pmos_probes.h
+ *  \brief USDT static tracepoints for the pmos library.
+ *
+ *  Probes are compiled in only when PMOS_USDT is defined (requires <sys/sdt.h>, e.g. from
+ *  systemtap-sdt-dev on Linux). Otherwise all probe macros expand to nothing, and their
+ *  arguments are not evaluated.
+ *
+ *  All probes belong to the "pmos" provider. Floating-point values (metric scores, MOS, phi, u)
+ *  are passed as integers scaled by 1000, as most tracers (e.g. bpftrace) cannot read
+ *  floating-point probe arguments.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _PMOS_PROBES_H_
+#define _PMOS_PROBES_H_ 1
+
+#ifdef PMOS_USDT
+#include <sys/sdt.h>
+#define PMOS_PROBE(name)                                      DTRACE_PROBE(pmos, name)
+#define PMOS_PROBE1(name, a)                                  DTRACE_PROBE1(pmos, name, a)
+#define PMOS_PROBE2(name, a, b)                               DTRACE_PROBE2(pmos, name, a, b)
+#define PMOS_PROBE3(name, a, b, c)                            DTRACE_PROBE3(pmos, name, a, b, c)
+#define PMOS_PROBE4(name, a, b, c, d)                         DTRACE_PROBE4(pmos, name, a, b, c, d)
+#define PMOS_PROBE5(name, a, b, c, d, e)                      DTRACE_PROBE5(pmos, name, a, b, c, d, e)
+#define PMOS_PROBE6(name, a, b, c, d, e, f)                   DTRACE_PROBE6(pmos, name, a, b, c, d, e, f)
+#define PMOS_PROBE7(name, a, b, c, d, e, f, g)                DTRACE_PROBE7(pmos, name, a, b, c, d, e, f, g)
+#define PMOS_PROBE8(name, a, b, c, d, e, f, g, h)             DTRACE_PROBE8(pmos, name, a, b, c, d, e, f, g, h)
+#else
+#define PMOS_PROBE(name)                                      do {} while (0)
+#define PMOS_PROBE1(name, a)                                  do {} while (0)
+#define PMOS_PROBE2(name, a, b)                               do {} while (0)
+#define PMOS_PROBE3(name, a, b, c)                            do {} while (0)
+#define PMOS_PROBE4(name, a, b, c, d)                         do {} while (0)
+#define PMOS_PROBE5(name, a, b, c, d, e)                      do {} while (0)
+#define PMOS_PROBE6(name, a, b, c, d, e, f)                   do {} while (0)
+#define PMOS_PROBE7(name, a, b, c, d, e, f, g)                do {} while (0)
+#define PMOS_PROBE8(name, a, b, c, d, e, f, g, h)             do {} while (0)
+#endif
+
+/*! Scale floating-point probe argument to integer (x1000): */
+#define PMOS_PROBE_MILLI(x)   ((long long)((x) * 1000.0))
+
+#endif
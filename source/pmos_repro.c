@@ -0,0 +1,116 @@
+/*!
+ *  \file  pmos_repro.c
+ *  \brief Platform-independent elementary functions for bit-reproducible scoring.
+ *
+ *  Results of exp(), log(), pow() and atan() of different C libraries (and their vectorized
+ *  versions) may differ in the last bits. The functions below use fixed argument reductions and
+ *  fixed-order polynomial evaluations, built only of IEEE-754 basic operations (which are correctly
+ *  rounded), floor(), frexp() and ldexp() (which are exact). Their results are therefore identical
+ *  on all platforms with IEEE-754 double arithmetic, provided that the compiler does not contract
+ *  multiply-adds into FMA instructions (-ffp-contract=off for gcc and clang, default for MSVC) and
+ *  does not use x87 extended precision (-mfpmath=sse on 32-bit x86). Accuracy is within a few ulps.
+ *
+ *  These functions are used by pmos.c in reproducible mode (see set_reproducible_mode()).
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#include <math.h>
+#include "pmos_repro.h"
+
+#define LN2_HI   6.93147180369123816490e-01	/* high bits of ln(2) (k * LN2_HI is exact for |k| < 2^11) */
+#define LN2_LO   1.90821492927058770002e-10	/* ln(2) - LN2_HI */
+#define INV_LN2  1.44269504088896338700e+00	/* 1 / ln(2) */
+#define SQRT1_2  7.07106781186547524401e-01	/* 1 / sqrt(2) */
+#define PI_2     1.57079632679489661923e+00	/* pi / 2 */
+#define PI_6     5.23598775598298873077e-01	/* pi / 6 */
+#define SQRT3    1.73205080756887729353e+00	/* sqrt(3) */
+#define TAN_PI_12 2.67949192431122706473e-01	/* tan(pi / 12) */
+
+/*!
+ * \brief Computes e^x.
+ */
+double repro_exp(double x)
+{
+	double k, r, p;
+	int i;
+
+	if (x != x) return x;
+	if (x > 709.78) return HUGE_VAL;
+	if (x < -745.2) return 0;
+
+	/* x = k * ln(2) + r, |r| <= ln(2) / 2: */
+	k = floor(x * INV_LN2 + 0.5);
+	r = (x - k * LN2_HI) - k * LN2_LO;
+
+	/* e^r by Taylor series (Horner scheme): */
+	for (p = 1, i = 17; i > 0; i--)
+		p = 1 + p * r / i;
+	return ldexp(p, (int)k);
+}
+
+/*!
+ * \brief Computes natural logarithm of x.
+ */
+double repro_log(double x)
+{
+	double m, s, s2, p;
+	int e, i;
+
+	if (x != x || x < 0) return (x - x) / (x - x);	/* NaN */
+	if (x == 0) return -HUGE_VAL;
+	if (x == HUGE_VAL) return x;
+
+	/* x = m * 2^e, m in [1/sqrt(2), sqrt(2)): */
+	m = frexp(x, &e);
+	if (m < SQRT1_2) { m *= 2; e--; }
+
+	/* ln(m) = 2 atanh(s), s = (m - 1) / (m + 1), |s| < 0.172: */
+	s = (m - 1) / (m + 1);
+	s2 = s * s;
+	for (p = 0, i = 23; i >= 3; i -= 2)
+		p = (p + 1.0 / i) * s2;
+	return e * LN2_HI + (e * LN2_LO + 2 * (s + s * p));
+}
+
+/*!
+ * \brief Computes x^y for x >= 0.
+ */
+double repro_pow(double x, double y)
+{
+	if (y == 0) return 1;
+	if (x == 0) return y > 0 ? 0 : HUGE_VAL;
+	if (x == 1) return 1;
+	return repro_exp(y * repro_log(x));
+}
+
+/*!
+ * \brief Computes arc tangent of x.
+ */
+double repro_atan(double x)
+{
+	double t, t2, p, offset = 0, sign = 1;
+	int i, invert = 0;
+
+	if (x != x) return x;
+	if (x < 0) { x = -x; sign = -1; }
+
+	/* reduce to [0, tan(pi/12)]: atan(x) = pi/2 - atan(1/x), atan(x) = pi/6 + atan((x sqrt(3) - 1) / (x + sqrt(3))): */
+	if (x > 1) { x = 1 / x; invert = 1; }
+	if (x > TAN_PI_12) { x = (x * SQRT3 - 1) / (x + SQRT3); offset = PI_6; }
+
+	/* Taylor series: */
+	t = x;
+	t2 = t * t;
+	for (p = 0, i = 29; i >= 3; i -= 2)
+		p = (1.0 / i - p) * t2;
+	t = offset + (t - t * p);
+	if (invert) t = PI_2 - t;
+	return sign * t;
+}
+
+/* pmos_repro.c -- end of file */
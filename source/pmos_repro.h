@@ -0,0 +1,27 @@
+/*!
+ *  \file  pmos_repro.h
+ *  \brief Platform-independent elementary functions for bit-reproducible scoring.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _PMOS_REPRO_H_
+#define _PMOS_REPRO_H_ 1
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! Function prototypes: */
+double repro_exp(double x);
+double repro_log(double x);
+double repro_pow(double x, double y);
+double repro_atan(double x);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
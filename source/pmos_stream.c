@@ -0,0 +1,559 @@
+/*!
+ *  \file  pmos_stream.c
+ *  \brief Per-stream MOS aggregation with checkpoint and restore.
+ *
+ *  Live scorers keep per-stream (viewing session) accumulators: number and total duration of
+ *  scored segments, duration-weighted and min MOS, rolling MOS with a given half-life, and the
+ *  number of switches of viewing geometry. Streams are kept in an open-addressing hash table of
+ *  fixed capacity, along with a cache of viewing contexts (see pmos_cache.c).
+ *
+ *  Checkpoints:
+ *
+ *    full         - the whole table (and cached contexts) is written to a snapshot file, which
+ *                   atomically replaces the previous one; the delta file is then removed
+ *    incremental  - only slots changed since the last checkpoint are appended to the delta file
+ *                   (<path>.delta), as a block tagged with the generation of the snapshot and
+ *                   protected by a checksum
+ *
+ *  Restore maps the snapshot into memory (copy-on-write, so pages are only read when streams are
+ *  accessed, and only copied when they are changed), and replays valid delta blocks of the same
+ *  generation; a torn block at the end (e.g. after a crash during checkpoint) ends the replay, and
+ *  the snapshot is then rewritten, so that further deltas are not appended after it.
+ *  Cached contexts are restored only if the snapshot was written with the same model parameters
+ *  (see model_hash()) and in the same reproducible mode (see set_reproducible_mode()); otherwise
+ *  they are recomputed on demand.
+ *
+ *  Snapshots are written in native byte order and layout (checked on restore), and are meant for
+ *  restarts on the same platform.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "pmos.h"
+#include "pmos_cache.h"
+#include "pmos_repro.h"
+#include "pmos_stream.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*! Header of snapshot file: */
+struct snapshot_header {
+	char magic[8];			/* "PMOSSNAP" */
+	unsigned int version;		/* STREAM_SNAPSHOT_VERSION */
+	unsigned int state_size;	/* sizeof(struct stream_state) */
+	unsigned long long model_hash;	/* model_hash() of the writer */
+	unsigned long long generation;	/* checkpoint generation */
+	int capacity, n;		/* number of slots and active streams */
+	double half_life;		/* half-life of rolling MOS [s] */
+	int n_cache;			/* number of cache entries following the slots */
+	int entry_size;			/* sizeof(struct geometry_entry) */
+	int reproducible;		/* reproducible_mode() of the writer */
+};
+
+/*! Header of delta block (followed by count delta records and a checksum): */
+struct delta_header {
+	char magic[8];			/* "PMOSDLTA" */
+	unsigned long long generation;	/* generation of the snapshot this block applies to */
+	int count;			/* number of changed slots */
+	int n;				/* number of active streams after this block */
+};
+
+/*! Changed slot: */
+struct delta_record {
+	long long slot;			/* slot index */
+	struct stream_state state;	/* new state of the slot */
+};
+
+static const char snapshot_magic[8] = {'P', 'M', 'O', 'S', 'S', 'N', 'A', 'P'};
+static const char delta_magic[8] = {'P', 'M', 'O', 'S', 'D', 'L', 'T', 'A'};
+
+/****************************
+ *
+ * Stream table:
+ *
+ ***/
+
+static int stream_slot(const struct stream_table* t, unsigned long long id)
+{
+	return (int)((id * 11400714819323198485ull) >> 32) & (t->capacity - 1);
+}
+
+/*!
+ * \brief Returns slot of a stream, or the free slot where it would be inserted.
+ */
+static int stream_lookup(const struct stream_table* t, unsigned long long id)
+{
+	int i = stream_slot(t, id);
+
+	while (t->streams[i].id != 0 && t->streams[i].id != id)
+		i = (i + 1) & (t->capacity - 1);
+	return i;
+}
+
+/*!
+ * \brief Initializes an empty table of streams.
+ *
+ * \param[out] t				table of streams
+ * \param[in]  capacity			number of slots (power of 2; at most 3/4 of them can be used)
+ * \param[in]  half_life		half-life of rolling MOS [s]
+ * \param[in]  params			custom device parameters (used for device_custom, may be NULL)
+ *
+ * \returns    0				success
+ *			  -6				invalid parameters
+ *			  -15				out of memory
+ */
+int stream_table_init(struct stream_table* t, int capacity, double half_life, struct device_params* params)
+{
+	if (t == NULL || capacity < 4 || (capacity & (capacity - 1)) || !(half_life > 0)) return -6;
+
+	memset(t, 0, sizeof(*t));
+	t->capacity = capacity;
+	t->half_life = half_life;
+	t->streams = (struct stream_state*)calloc((size_t)capacity, sizeof(struct stream_state));
+	t->dirty = (unsigned char*)calloc((size_t)capacity, 1);
+	if (t->streams == NULL || t->dirty == NULL) { stream_table_free(t); return -15; }
+	geometry_cache_init(&t->cache, params);
+	return 0;
+}
+
+/*!
+ * \brief Releases memory of a table of streams.
+ */
+void stream_table_free(struct stream_table* t)
+{
+	if (t == NULL) return;
+	if (t->mapping == NULL) free(t->streams);
+#ifndef _WIN32
+	else munmap(t->mapping, t->mapping_size);
+#else
+	else free(t->mapping);
+#endif
+	free(t->dirty);
+	t->streams = NULL;
+	t->dirty = NULL;
+	t->mapping = NULL;
+}
+
+/*!
+ * \brief Returns state of a stream, NULL - no such stream.
+ */
+const struct stream_state* stream_find(const struct stream_table* t, unsigned long long id)
+{
+	int i;
+
+	if (t == NULL || id == 0) return NULL;
+	i = stream_lookup(t, id);
+	return t->streams[i].id == id ? &t->streams[i] : NULL;
+}
+
+/*!
+ * \brief Adds MOS of a segment to a stream, starting the stream if needed.
+ *
+ * \param[in]  t				table of streams
+ * \param[in]  id				stream id (non-zero)
+ * \param[in]  key				viewing geometry of the segment (may be NULL)
+ * \param[in]  duration			segment duration [s]
+ * \param[in]  mos				segment MOS
+ * \param[out] p_state			updated state of the stream (valid until the next change of the table, may be NULL)
+ *
+ * \returns    0				success
+ *			  -6				invalid parameters
+ *			  -11				table is full
+ */
+int stream_add(struct stream_table* t, unsigned long long id, const struct geometry_key* key, double duration, double mos, const struct stream_state** p_state)
+{
+	struct stream_state* s;
+	double w;
+	int i;
+
+	if (t == NULL || id == 0 || !(duration >= 0) || !(mos >= 1 && mos <= 5)) return -6;
+
+	i = stream_lookup(t, id);
+	s = &t->streams[i];
+	if (s->id == 0) {
+		/* new stream: */
+		if (t->n + 1 > t->capacity / 4 * 3) return -11;
+		memset(s, 0, sizeof(*s));
+		s->id = id;
+		s->mos_min = s->rolling = mos;
+		if (key != NULL) s->key = *key;
+		t->n++;
+	} else if (key != NULL && memcmp(&s->key, key, sizeof(*key))) {
+		s->switches++;
+		s->key = *key;
+	}
+
+	/* accumulators (rolling MOS is bit-reproducible in reproducible mode, as scores are): */
+	w = reproducible_mode() ? repro_exp(-repro_log(2.0) * duration / t->half_life) : exp(-log(2.0) * duration / t->half_life);
+	s->rolling = w * s->rolling + (1 - w) * mos;
+	s->n++;
+	s->duration += duration;
+	s->mos_sum += mos * duration;
+	if (mos < s->mos_min) s->mos_min = mos;
+	t->dirty[i] = 1;
+
+	if (p_state != NULL) *p_state = s;
+	return 0;
+}
+
+/*!
+ * \brief Scores a segment, and adds its MOS to a stream.
+ *
+ * \param[in]  t				table of streams
+ * \param[in]  id				stream id (non-zero)
+ * \param[in]  key				viewing geometry of the segment
+ * \param[in]  duration			segment duration [s]
+ * \param[in]  metric			metric type (see enum metric_types)
+ * \param[in]  value			metric score of the segment
+ * \param[out] p_state			updated state of the stream (may be NULL)
+ *
+ * \returns    0				success
+ *			  -1..-10			invalid geometry or metric score (see viewing_context_init(), metric2mos())
+ *			  -6, -11			see stream_add()
+ */
+int stream_score(struct stream_table* t, unsigned long long id, const struct geometry_key* key, double duration, int metric, double value, const struct stream_state** p_state)
+{
+	const struct viewing_context* ctx;
+	double mos;
+	int err;
+
+	if (t == NULL || key == NULL) return -6;
+	if ((err = geometry_cache_lookup(&t->cache, key, &ctx)) != 0) return err;
+	if ((mos = metric2mos(ctx, metric, value)) < 0) return (int)mos;
+	return stream_add(t, id, key, duration, mos, p_state);
+}
+
+/*!
+ * \brief Ends a stream, and releases its slot.
+ *
+ * \returns    0				success
+ *			  -6				invalid parameters
+ *			  -12				no such stream
+ */
+int stream_remove(struct stream_table* t, unsigned long long id)
+{
+	int i, j, k, mask;
+
+	if (t == NULL || id == 0) return -6;
+	i = stream_lookup(t, id);
+	if (t->streams[i].id != id) return -12;
+
+	/* shift following streams of the probe sequence back into the hole: */
+	mask = t->capacity - 1;
+	for (j = (i + 1) & mask; t->streams[j].id != 0; j = (j + 1) & mask) {
+		k = stream_slot(t, t->streams[j].id);
+		if (i <= j ? (i < k && k <= j) : (i < k || k <= j)) continue;	/* home slot is between the hole and j */
+		t->streams[i] = t->streams[j];
+		t->dirty[i] = 1;
+		i = j;
+	}
+	memset(&t->streams[i], 0, sizeof(t->streams[i]));
+	t->dirty[i] = 1;
+	t->n--;
+	return 0;
+}
+
+/****************************
+ *
+ * Checkpoint and restore:
+ *
+ ***/
+
+/*!
+ * \brief Flushes file to storage, and closes it.
+ *
+ * \returns 0 - success, -14 - I/O error
+ */
+static int file_commit(FILE* f)
+{
+	int err = fflush(f) != 0 || ferror(f);
+#ifndef _WIN32
+	if (!err) err = fsync(fileno(f)) != 0;
+#endif
+	if (fclose(f)) err = 1;
+	return err ? -14 : 0;
+}
+
+/*!
+ * \brief Flushes directory containing a file to storage (so that a rename of the file is durable).
+ *
+ * \returns 0 - success, -14 - I/O error
+ */
+static int dir_commit(const char* path)
+{
+#ifndef _WIN32
+	char dir[4096];
+	char* slash;
+	int fd, err;
+
+	snprintf(dir, sizeof(dir), "%s", path);
+	if ((slash = strrchr(dir, '/')) == NULL) strcpy(dir, ".");
+	else if (slash == dir) slash[1] = 0;
+	else *slash = 0;
+	if ((fd = open(dir, O_RDONLY)) < 0) return -14;
+	err = fsync(fd) != 0;
+	if (close(fd)) err = 1;
+	return err ? -14 : 0;
+#else
+	(void)path;
+	return 0;
+#endif
+}
+
+static void delta_path(char* buffer, size_t size, const char* path)
+{
+	snprintf(buffer, size, "%s.delta", path);
+}
+
+/*!
+ * \brief Writes full snapshot, replacing the previous one.
+ */
+static int checkpoint_full(struct stream_table* t, const char* path)
+{
+	struct snapshot_header h;
+	char tmp[4096];
+	FILE* f;
+	int err;
+
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, snapshot_magic, sizeof(h.magic));
+	h.version = STREAM_SNAPSHOT_VERSION;
+	h.state_size = sizeof(struct stream_state);
+	h.model_hash = model_hash();
+	h.generation = t->generation + 1;
+	h.capacity = t->capacity;
+	h.n = t->n;
+	h.half_life = t->half_life;
+	h.n_cache = GEOMETRY_CACHE_SIZE;
+	h.entry_size = sizeof(struct geometry_entry);
+	h.reproducible = reproducible_mode();
+
+	/* write to a temporary file: */
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	if ((f = fopen(tmp, "wb")) == NULL) return -14;
+	fwrite(&h, sizeof(h), 1, f);
+	fwrite(t->streams, sizeof(struct stream_state), (size_t)t->capacity, f);
+	fwrite(t->cache.entries, sizeof(struct geometry_entry), GEOMETRY_CACHE_SIZE, f);
+	if ((err = file_commit(f)) != 0) { remove(tmp); return err; }
+
+	/* replace snapshot, and drop deltas of the previous one: */
+#ifdef _WIN32
+	remove(path);
+#endif
+	if (rename(tmp, path)) { remove(tmp); return -14; }
+	delta_path(tmp, sizeof(tmp), path);
+	remove(tmp);
+
+	t->generation = h.generation;
+	memset(t->dirty, 0, (size_t)t->capacity);
+	return dir_commit(path);
+}
+
+/*!
+ * \brief Appends changed slots to the delta file.
+ */
+static int checkpoint_delta(struct stream_table* t, const char* path)
+{
+	struct delta_header h;
+	struct delta_record r;
+	unsigned long long sum;
+	char name[4096];
+	FILE* f;
+	int i;
+
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, delta_magic, sizeof(h.magic));
+	h.generation = t->generation;
+	h.n = t->n;
+	for (i = 0; i < t->capacity; i++)
+		h.count += t->dirty[i];
+	if (h.count == 0) return 0;
+
+	delta_path(name, sizeof(name), path);
+	if ((f = fopen(name, "ab")) == NULL) return -14;
+	sum = hash_bytes(14695981039346656037ull, &h, sizeof(h));
+	fwrite(&h, sizeof(h), 1, f);
+	memset(&r, 0, sizeof(r));
+	for (i = 0; i < t->capacity; i++) {
+		if (!t->dirty[i]) continue;
+		r.slot = i;
+		r.state = t->streams[i];
+		sum = hash_bytes(sum, &r, sizeof(r));
+		fwrite(&r, sizeof(r), 1, f);
+	}
+	fwrite(&sum, sizeof(sum), 1, f);
+	if (file_commit(f)) return -14;
+
+	memset(t->dirty, 0, (size_t)t->capacity);
+	return 0;
+}
+
+/*!
+ * \brief Writes a checkpoint of the table.
+ *
+ * \param[in]  t				table of streams
+ * \param[in]  path			snapshot file (deltas are appended to <path>.delta)
+ * \param[in]  incremental		1 - write only streams changed since the last checkpoint, 0 - write full snapshot
+ *
+ * \returns    0				success
+ *			  -6				invalid parameters
+ *			  -14				I/O error
+ *
+ *  Incremental checkpoint falls back to a full one if there is no snapshot of this table yet.
+ */
+int stream_checkpoint(struct stream_table* t, const char* path, int incremental)
+{
+	if (t == NULL || path == NULL) return -6;
+	return incremental && t->generation != 0 ? checkpoint_delta(t, path) : checkpoint_full(t, path);
+}
+
+/*!
+ * \brief Loads snapshot file (mapped copy-on-write, if possible).
+ */
+static int snapshot_load(const char* path, void** p_data, size_t* p_size)
+{
+#ifndef _WIN32
+	struct stat st;
+	void* p;
+	int fd;
+
+	if ((fd = open(path, O_RDONLY)) < 0) return -14;
+	if (fstat(fd, &st) || st.st_size < (off_t)sizeof(struct snapshot_header)) { close(fd); return -18; }
+	p = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (p == MAP_FAILED) return -14;
+	*p_data = p;
+	*p_size = (size_t)st.st_size;
+	return 0;
+#else
+	FILE* f;
+	long size;
+	char* p;
+
+	if ((f = fopen(path, "rb")) == NULL) return -14;
+	if (fseek(f, 0, SEEK_END) || (size = ftell(f)) < (long)sizeof(struct snapshot_header) || fseek(f, 0, SEEK_SET)) { fclose(f); return -18; }
+	if ((p = (char*)malloc((size_t)size)) == NULL) { fclose(f); return -15; }
+	if (fread(p, 1, (size_t)size, f) != (size_t)size) { fclose(f); free(p); return -14; }
+	fclose(f);
+	*p_data = p;
+	*p_size = (size_t)size;
+	return 0;
+#endif
+}
+
+/*!
+ * \brief Replays valid delta blocks of the current generation.
+ *
+ * \returns 0 - all blocks were replayed, 1 - delta file has an invalid tail
+ */
+static int delta_replay(struct stream_table* t, const char* path)
+{
+	struct delta_header h;
+	struct delta_record r;
+	unsigned long long sum, stored;
+	struct delta_record* records = NULL;
+	char name[4096];
+	long valid = 0, end;
+	FILE* f;
+	int i;
+
+	delta_path(name, sizeof(name), path);
+	if ((f = fopen(name, "rb")) == NULL) return 0;
+
+	while (fread(&h, sizeof(h), 1, f) == 1) {
+		if (memcmp(h.magic, delta_magic, sizeof(h.magic)) || h.generation != t->generation || h.count <= 0 || h.count > t->capacity) break;
+		if ((records = (struct delta_record*)realloc(records, (size_t)h.count * sizeof(r))) == NULL) break;
+		if (fread(records, sizeof(r), (size_t)h.count, f) != (size_t)h.count || fread(&stored, sizeof(stored), 1, f) != 1) break;
+		sum = hash_bytes(hash_bytes(14695981039346656037ull, &h, sizeof(h)), records, (size_t)h.count * sizeof(r));
+		if (sum != stored) break;
+		for (i = 0; i < h.count; i++)
+			if (records[i].slot >= 0 && records[i].slot < t->capacity)
+				t->streams[records[i].slot] = records[i].state;
+		t->n = h.n;
+		valid = ftell(f);
+	}
+	free(records);
+	end = fseek(f, 0, SEEK_END) ? -1 : ftell(f);
+	fclose(f);
+	return end != valid;
+}
+
+/*!
+ * \brief Restores a table of streams from its last checkpoint.
+ *
+ * \param[out] t				table of streams (not initialized)
+ * \param[in]  path			snapshot file
+ * \param[in]  params			custom device parameters (used for device_custom, may be NULL)
+ *
+ * \returns    0				success
+ *			  -6				invalid parameters
+ *			  -14				cannot read snapshot, or rewrite it after a torn delta
+ *			  -15				out of memory
+ *			  -18				invalid or incompatible snapshot
+ */
+int stream_restore(struct stream_table* t, const char* path, struct device_params* params)
+{
+	const struct snapshot_header* h;
+	void* data;
+	size_t size;
+	int i, err;
+
+	if (t == NULL || path == NULL) return -6;
+	if ((err = snapshot_load(path, &data, &size)) != 0) return err;
+
+	/* validate header: */
+	h = (const struct snapshot_header*)data;
+	if (memcmp(h->magic, snapshot_magic, sizeof(h->magic)) || h->version != STREAM_SNAPSHOT_VERSION
+		|| h->state_size != sizeof(struct stream_state) || h->entry_size != sizeof(struct geometry_entry)
+		|| h->capacity < 4 || (h->capacity & (h->capacity - 1)) || !(h->half_life > 0) || h->n_cache != GEOMETRY_CACHE_SIZE
+		|| size < sizeof(*h) + (size_t)h->capacity * sizeof(struct stream_state) + GEOMETRY_CACHE_SIZE * sizeof(struct geometry_entry)) {
+#ifndef _WIN32
+		munmap(data, size);
+#else
+		free(data);
+#endif
+		return -18;
+	}
+
+	/* streams stay in the mapping: */
+	memset(t, 0, sizeof(*t));
+	t->capacity = h->capacity;
+	t->n = h->n;
+	t->half_life = h->half_life;
+	t->generation = h->generation;
+	t->streams = (struct stream_state*)((char*)data + sizeof(*h));
+	t->mapping = data;
+	t->mapping_size = size;
+	if ((t->dirty = (unsigned char*)calloc((size_t)t->capacity, 1)) == NULL) { stream_table_free(t); return -15; }
+
+	/* cached contexts are valid only for the same models, computed in the same mode (and standard devices): */
+	geometry_cache_init(&t->cache, params);
+	if (h->model_hash == model_hash() && h->reproducible == reproducible_mode()) {
+		memcpy(t->cache.entries, t->streams + t->capacity, sizeof(t->cache.entries));
+		for (i = 0; i < GEOMETRY_CACHE_SIZE; i++)
+			if (t->cache.entries[i].key.device == device_custom) t->cache.entries[i].valid = 0;
+	}
+
+	/* replay deltas, and rewrite the snapshot if further deltas could not be appended: */
+	if (delta_replay(t, path) && (err = checkpoint_full(t, path)) != 0) { stream_table_free(t); return err; }
+	return 0;
+}
+
+/* pmos_stream.c -- end of file */
@@ -0,0 +1,62 @@
+/*!
+ *  \file  pmos_stream.h
+ *  \brief Per-stream MOS aggregation with checkpoint and restore.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _PMOS_STREAM_H_
+#define _PMOS_STREAM_H_ 1
+#include <stddef.h>
+#include "pmos.h"
+#include "pmos_cache.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STREAM_SNAPSHOT_VERSION  2	/* version of snapshot format */
+
+/*! State of a stream (viewing session): */
+struct stream_state {
+	unsigned long long id;		/* stream id (0 - free slot) */
+	long long n;			/* number of scored segments */
+	double duration;		/* total duration of scored segments [s] */
+	double mos_sum;			/* sum of MOS of segments weighted by their durations */
+	double mos_min;			/* min MOS of segments */
+	double rolling;			/* rolling MOS (exponentially weighted over time) */
+	int switches;			/* number of changes of viewing geometry (renditions, player sizes) */
+	int reserved;
+	struct geometry_key key;	/* viewing geometry of the last segment */
+};
+
+/*! Table of streams: */
+struct stream_table {
+	int capacity;			/* number of slots (power of 2) */
+	int n;				/* number of active streams */
+	double half_life;		/* half-life of rolling MOS [s] */
+	struct stream_state* streams;	/* slots (open addressing, linear probing) */
+	unsigned char* dirty;		/* indicators of slots changed since the last checkpoint */
+	unsigned long long generation;	/* generation of the last full checkpoint */
+	struct geometry_cache cache;	/* cached viewing contexts */
+	void* mapping;			/* mapped snapshot, if streams were restored from one */
+	size_t mapping_size;		/* size of mapped snapshot [bytes] */
+};
+
+/*! Function prototypes: */
+int stream_table_init(struct stream_table* t, int capacity, double half_life, struct device_params* params);
+void stream_table_free(struct stream_table* t);
+const struct stream_state* stream_find(const struct stream_table* t, unsigned long long id);
+int stream_add(struct stream_table* t, unsigned long long id, const struct geometry_key* key, double duration, double mos, const struct stream_state** p_state);
+int stream_score(struct stream_table* t, unsigned long long id, const struct geometry_key* key, double duration, int metric, double value, const struct stream_state** p_state);
+int stream_remove(struct stream_table* t, unsigned long long id);
+int stream_checkpoint(struct stream_table* t, const char* path, int incremental);
+int stream_restore(struct stream_table* t, const char* path, struct device_params* params);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,136 @@
+/*!
+ *  \file  pmos_surrogate.c
+ *  \brief Piecewise-linear surrogates of metric-to-MOS mappings for fixed viewing setups.
+ *
+ *  For a given viewing context, MOS is a function of metric score only, which is smooth, monotonic,
+ *  and saturates at both ends. It is approximated by linear interpolation between knots placed
+ *  greedily: starting from the lower end of metric range, each segment is extended as far as its
+ *  max error (checked at SURROGATE_CHECKS points) stays within tolerance. Max error of the result
+ *  is then measured on a dense grid of SURROGATE_SAMPLES points (and fitting is repeated with
+ *  tighter target, if needed).
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#include <stddef.h>
+#include <math.h>
+#include "pmos.h"
+#include "pmos_surrogate.h"
+
+#define SURROGATE_CHECKS   64		/* number of points checked within a segment during fitting */
+#define SURROGATE_SAMPLES  100000	/* number of points used to measure max error */
+
+/*!
+ * \brief Max error of a segment from (x0, y0) to (x1, mos(x1)).
+ */
+static double segment_error(const struct viewing_context* ctx, int metric, double x0, double y0, double x1)
+{
+	double y1 = metric2mos(ctx, metric, x1), x, e, max_e = 0;
+	int i;
+
+	for (i = 1; i < SURROGATE_CHECKS; i++) {
+		x = x0 + (x1 - x0) * i / SURROGATE_CHECKS;
+		e = fabs(metric2mos(ctx, metric, x) - (y0 + (y1 - y0) * (x - x0) / (x1 - x0)));
+		if (e > max_e) max_e = e;
+	}
+	return max_e;
+}
+
+/*!
+ * \brief Places knots with segments within given error at check points.
+ *
+ * \returns 0 - success, -11 - too many knots
+ */
+static int place_knots(const struct viewing_context* ctx, int metric, double lo, double hi, double target, struct surrogate* s)
+{
+	double a, b, m, x;
+	int i;
+
+	s->n = 1;
+	s->x[0] = lo;
+	s->y[0] = metric2mos(ctx, metric, lo);
+	while (s->x[s->n - 1] < hi) {
+		if (s->n == SURROGATE_MAX_KNOTS) return -11;
+		a = s->x[s->n - 1];
+		if (segment_error(ctx, metric, a, s->y[s->n - 1], hi) <= target)
+			b = hi;
+		else {
+			/* bisection for the longest segment within target error: */
+			for (b = a, m = hi, i = 0; i < 50; i++) {
+				x = 0.5 * (b + m);
+				if (segment_error(ctx, metric, a, s->y[s->n - 1], x) <= target) b = x; else m = x;
+			}
+			if (b == a) return -11;
+		}
+		s->x[s->n] = b;
+		s->y[s->n] = metric2mos(ctx, metric, b);
+		s->n++;
+	}
+	return 0;
+}
+
+/*!
+ * \brief Fits piecewise-linear surrogate of metric2mos() in a given viewing context.
+ *
+ *  Errors between check points (e.g. near the corners where MOS is clamped) may exceed the target
+ *  error of fitting, so fitting is repeated with reduced target until the measured error is within tolerance.
+ *
+ * \param[in]  ctx			viewing context (see viewing_context_init())
+ * \param[in]  metric			metric type (see enum metric_types)
+ * \param[in]  tolerance		max absolute error [MOS]
+ * \param[out] s				surrogate
+ *
+ * \returns    0				success (measured max error, <= tolerance, is stored in s->max_error)
+ *			  -6				NULL pointer
+ *			  -10				invalid metric type
+ *			  -11				tolerance cannot be reached with SURROGATE_MAX_KNOTS knots
+ *			  -12				invalid tolerance
+ */
+int surrogate_fit(const struct viewing_context* ctx, int metric, double tolerance, struct surrogate* s)
+{
+	double lo, hi, target, x, e;
+	int i, k, err;
+
+	/* check parameters: */
+	if (ctx == NULL || s == NULL) return -6;
+	if ((err = metric_range(metric, &lo, &hi))) return err;
+	if (!(tolerance > 0)) return -12;
+
+	for (target = tolerance, k = 0; k < 8; k++) {
+		if ((err = place_knots(ctx, metric, lo, hi, target, s))) return err;
+
+		/* measure max error: */
+		for (s->max_error = 0, i = 0; i <= SURROGATE_SAMPLES; i++) {
+			x = lo + (hi - lo) * i / SURROGATE_SAMPLES;
+			e = fabs(surrogate_eval(s, x) - metric2mos(ctx, metric, x));
+			if (e > s->max_error) s->max_error = e;
+		}
+		if (s->max_error <= tolerance) return 0;
+		target *= 0.95 * tolerance / s->max_error;
+	}
+	return -11;
+}
+
+/*!
+ * \brief Evaluates surrogate (scores outside of knot range are clamped to it).
+ */
+double surrogate_eval(const struct surrogate* s, double x)
+{
+	int lo = 0, hi = s->n - 1, mid;
+
+	if (x <= s->x[0]) return s->y[0];
+	if (x >= s->x[hi]) return s->y[hi];
+
+	/* binary search for segment: */
+	while (hi - lo > 1) {
+		mid = (lo + hi) / 2;
+		if (s->x[mid] <= x) lo = mid; else hi = mid;
+	}
+	return s->y[lo] + (s->y[hi] - s->y[lo]) * (x - s->x[lo]) / (s->x[hi] - s->x[lo]);
+}
+
+/* pmos_surrogate.c -- end of file */
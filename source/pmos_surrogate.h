@@ -0,0 +1,36 @@
+/*!
+ *  \file  pmos_surrogate.h
+ *  \brief Piecewise-linear surrogates of metric-to-MOS mappings for fixed viewing setups.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _PMOS_SURROGATE_H_
+#define _PMOS_SURROGATE_H_ 1
+#include "pmos.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SURROGATE_MAX_KNOTS  257	/* max number of knots (segments + 1) */
+
+/*! Piecewise-linear surrogate: MOS(x) interpolated linearly between knots (x[i], y[i]): */
+struct surrogate {
+	int n;				/* number of knots */
+	double x[SURROGATE_MAX_KNOTS];	/* metric scores (increasing; first and last are ends of metric range) */
+	double y[SURROGATE_MAX_KNOTS];	/* MOS at knots */
+	double max_error;		/* measured max absolute error [MOS] */
+};
+
+/*! Function prototypes: */
+int surrogate_fit(const struct viewing_context* ctx, int metric, double tolerance, struct surrogate* s);
+double surrogate_eval(const struct surrogate* s, double x);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
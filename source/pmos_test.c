@@ -12,9 +12,37 @@
  *	\copyright(c) 2025 Streaming Labs, Ltd.
  */
 
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include "pmos.h"
+#include "pmos_ladder.h"
+#include "pmos_bd.h"
+#include "pmos_dynopt.h"
+#include "pmos_abr.h"
+#include "pmos_abrsim.h"
+#include "pmos_grid.h"
+#include "pmos_ci.h"
+#include "pmos_ensemble.h"
+#include "pmos_batch.h"
+#include "pmos_surrogate.h"
+#include "pmos_logs.h"
+#include "pmos_async.h"
+#include "pmos_decompress.h"
+#include "pmos_stream.h"
+#include "pmos_repro.h"
+#include "pmos_oracle.h"
+#include "pmos_cache.h"
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 /* Netflix data set (device: HDTV, SDR, player size = full screen): */
 static struct { char* name; int width, height; double psnr, ssim, mos; } dataset[] =
@@ -91,6 +119,33 @@ static struct { char* name; int width, height; double psnr, ssim, mos; } dataset
     {"s70", 1920, 1080, 42.476554, 0.96548,  4.5385}
 };
 
+/* Sample manifest ladder (bitrate, resolution, VMAF): */
+static struct abr_rendition abr_ladder[] = {
+    {400e3,  640,  360,  metric_vmaf, 70},
+    {1200e3, 960,  540,  metric_vmaf, 80},
+    {2000e3, 1280, 720,  metric_vmaf, 83},
+    {4500e3, 1920, 1080, metric_vmaf, 94},
+    {6000e3, 1280, 720,  metric_vmaf, 94},
+    {12e6,   3840, 2160, metric_vmaf, 95}
+};
+
+/* Sample per-title rate-VMAF curves (5 resolutions x 6 encodings): */
+static int ladder_widths[] = {640, 960, 1280, 1920, 3840}, ladder_heights[] = {360, 540, 720, 1080, 2160};
+static double ladder_bitrates[5][6] = {
+    {200,  400,  700,   1000,  1500,  2000},
+    {400,  800,  1200,  1800,  2500,  3500},
+    {800,  1400, 2000,  3000,  4500,  6000},
+    {1500, 2500, 4000,  6000,  8000,  12000},
+    {4000, 7000, 10000, 14000, 18000, 25000}
+};
+static double ladder_vmafs[5][6] = {
+    {60, 70, 76, 79, 81, 82},
+    {62, 74, 80, 85, 88, 90},
+    {60, 75, 83, 88, 92, 94},
+    {58, 74, 84, 90, 94, 96.5},
+    {60, 78, 88, 93, 96, 98}
+};
+
  /*!
   *  \brief Main function: test program & demo
   */
@@ -99,6 +154,88 @@ int main(int argc, char* argv[])
     int n, n_tests = sizeof(dataset) / sizeof(dataset[0]);
     int player_height = 2160, player_width = 3840;  /* assume 4K TV, and player running full screen */
     double mos, delta, rms, scale = 8;
+    struct viewing_context ctx;
+    struct ladder_target targets[n_device_types - 1];
+    struct ladder_optimizer lo;
+    struct rq_curve curves[5];
+    struct ladder ladder;
+    struct viewing_setup setups[n_device_types - 1];
+    struct rd_point anchor_points[30], test_points[30];
+    struct rd_curve anchor, test;
+    struct bd_result bd[n_device_types - 1];
+    struct shot_point shot_points[4][30];
+    struct shot shots[4];
+    struct dynopt dyn;
+    struct dynopt_result dres;
+    int choices[4], k;
+    struct abr_engine abr;
+    static double bandwidths[] = {300e3, 1e6, 2.5e6, 5e6, 8e6, 20e6};
+    static double trace_times[] = {0, 10, 20, 30}, trace_bandwidths[3][4] = {{3e6, 3e6, 3e6, 3e6}, {8e6, 1e6, 8e6, 1e6}, {20e6, 5e6, 0.5e6, 20e6}};
+    struct sim_trace traces[3];
+    struct sim_content content = {sizeof(abr_ladder) / sizeof(abr_ladder[0]), abr_ladder, 150, 4.0, NULL, NULL};
+    struct sim_params sim_params = {8.0, 30.0, 0.9, 0};
+    struct sim_session sessions[3];
+    static double zero_bandwidths[4];
+    struct abr_sim sim;
+    struct saturation_entry saturation[(n_device_types - 1) * (n_upsampling_methods + 1)];
+    static double grid_psnrs[] = {25, 30, 35, 40, 45};
+    static int grid_widths[] = {640, 1280, 1920, 3840}, grid_player_widths[] = {1280, 3840};
+    struct grid_axes axes = {5, grid_psnrs, 4, grid_widths, 2, grid_player_widths, 0, NULL};
+    double grid[2 * 4 * 5];
+    int p, e;
+    static struct model_covariance cov;
+    static struct model_covariance fd_cov;
+    double fd_grad[n_model_params], *fd_param, fd_saved, fd_h, fd_hi, fd_lo, fd_se;
+    int fd_i, fd_j;
+    const struct wr_params* wr;
+    const struct fusion_params* fp;
+    double se;
+    static double ens_mos[sizeof(dataset) / sizeof(dataset[0])][n_metric_types], ens_true[sizeof(dataset) / sizeof(dataset[0])];
+    double ens_values[n_metric_types], combined, ens_rms;
+    struct ensemble_weights weights;
+    static double batch_mos[sizeof(dataset) / sizeof(dataset[0])];
+    static int batch_zero = 0, batch_device = device_tv;
+    struct score_batch batch;
+    static struct surrogate sur;
+    static const char* logs[] = {
+        "{\"version\": \"3.0\", \"frames\": [{\"frameNum\": 0, \"metrics\": {\"psnr_y\": 38.5, \"integer_vif_scale0\": 0.5, \"integer_vif_scale1\": 0.75,\n"
+        "    \"integer_vif_scale2\": 0.75, \"integer_vif_scale3\": 1.0, \"vmaf\": 90.0}},\n"
+        "  {\"frameNum\": 1, \"metrics\": {\"psnr_y\": 36.5, \"integer_vif_scale0\": 0.25, \"integer_vif_scale1\": 0.5, \"integer_vif_scale2\": 0.5,\n"
+        "    \"integer_vif_scale3\": 0.75, \"vmaf\": 80.0}}], \"pooled_metrics\": {\"vmaf\": {\"mean\": 1.0}}}\n",
+        "<VMAF version=\"3.0\">\n  <frames>\n    <frame frameNum=\"0\" psnr_y=\"38.5\" vif_scale0=\"0.5\" vif_scale1=\"0.75\" vif_scale2=\"0.75\" vif_scale3=\"1.0\" vmaf=\"90.0\" />\n"
+        "    <frame frameNum=\"1\" psnr_y=\"36.5\" vif_scale0=\"0.25\" vif_scale1=\"0.5\" vif_scale2=\"0.5\" vif_scale3=\"0.75\" vmaf=\"80.0\" />\n  </frames>\n</VMAF>\n",
+        "n:1 mse_avg:5.0 mse_y:4.0 mse_u:1.0 mse_v:1.0 psnr_avg:39.0 psnr_y:38.5 psnr_u:50.0 psnr_v:50.0\n"
+        "n:2 mse_avg:7.0 mse_y:6.0 mse_u:1.0 mse_v:1.0 psnr_avg:37.0 psnr_y:36.5 psnr_u:50.0 psnr_v:50.0\n"
+    };
+    struct log_summary summary;
+    static struct stream_table streams, restored;
+    const struct stream_state *st, *st2;
+    struct geometry_key key = {0, 0, 3840, 2160, 0, upsampling_bicubic, device_tv};
+    FILE* f;
+    static double repro_mos[5][sizeof(dataset) / sizeof(dataset[0])];
+    static int repro_threads[] = {1, 2, 3, 8};
+    unsigned long long hash;
+    const unsigned char* bytes;
+    static struct diff_domain domain = {6, 6, 21, 12, NULL, 0.01};
+    struct diff_report report;
+    static struct geometry_cache gcache;
+    static struct geometry_store store, store2;
+    struct geometry_entry gentry;
+    static double store_mos[sizeof(dataset) / sizeof(dataset[0])];
+    const struct viewing_context* pctx;
+    static struct async_queue queue;
+    struct async_submission job;
+    struct async_completion done[4];
+    static double async_values[3 * ASYNC_CHUNK_ROWS], async_mos[2][3 * ASYNC_CHUNK_ROWS];
+    int n_done;
+#ifdef PMOS_ZLIB
+    static const unsigned char gzip_log[] = {   /* FFmpeg psnr stats of 2 frames, gzip-compressed */
+        0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xcb, 0xb3, 0x32, 0x54, 0xc8, 0x2d, 0x4e, 0x8d, 0x4f, 0x2c, 0x4b, 0xb7,
+        0x32, 0xd5, 0x33, 0x50, 0x28, 0x28, 0xce, 0x2b, 0x02, 0x73, 0x8c, 0x2d, 0x61, 0xbc, 0x4a, 0x2b, 0x63, 0x0b, 0x3d, 0x53, 0xae, 0x3c,
+        0x2b, 0x23, 0xb8, 0x4a, 0x73, 0x14, 0x95, 0xe6, 0x48, 0x2a, 0xcd, 0x80, 0x2a, 0x01, 0x19, 0x2e, 0x6a, 0x0a, 0x54, 0x00, 0x00, 0x00
+    };
+    struct decompress_buffer unzipped = {NULL, 0, 0, 0};
+#endif
 
     /*
      * Test PSNR2MOS conversions:
@@ -109,6 +246,9 @@ int main(int argc, char* argv[])
         /* predict MOS using model: */
         mos = psnr2mos(dataset[n].psnr, dataset[n].width, dataset[n].height, player_width, player_height, 0, upsampling_bicubic, device_tv, NULL);
         if (mos < 0) { printf("test %d has failed\n", n); return 1; }
+        /* same prediction using cached viewing context: */
+        if (viewing_context_init(&ctx, dataset[n].width, dataset[n].height, player_width, player_height, 0, upsampling_bicubic, device_tv, NULL)
+            || metric2mos(&ctx, metric_psnr, dataset[n].psnr) != mos) { printf("test %d has failed\n", n); return 1; }
         /* compute delta & rms: */
         delta = mos - dataset[n].mos;
         rms += delta * delta;
@@ -138,6 +278,439 @@ int main(int argc, char* argv[])
     rms = sqrt(rms / (double)n_tests);
     printf("  => rms = %g\n\n", rms);
 
+    /*
+     * Test ladder optimizer (target MOS = 4 on all standard devices, players running full screen):
+     */
+    printf("Testing ladder optimizer:\n");
+    for (n = 0; n < n_device_types - 1; n++) {
+        static int display_sizes[][2] = {{2400, 1080}, {2800, 1752}, {2560, 1600}, {3840, 2160}};
+        struct ladder_target t = {n, NULL, display_sizes[n][0], display_sizes[n][1], 0, upsampling_bicubic, 4.0};
+        targets[n] = t;
+    }
+    for (n = 0; n < 5; n++) {
+        curves[n].n_points = 6;
+        curves[n].bitrate = ladder_bitrates[n];
+        curves[n].metric = ladder_vmafs[n];
+    }
+    if (ladder_init(&lo, metric_vmaf, targets, n_device_types - 1, ladder_widths, ladder_heights, 5)
+        || ladder_optimize(&lo, curves, &ladder)) { printf("ladder test has failed\n"); return 1; }
+    for (n = 0; n < ladder.n_rungs; n++)
+        printf("rung %d -> %dx%d, bitrate=%g\n", n, ladder.rungs[n].width, ladder.rungs[n].height, ladder.rungs[n].bitrate);
+    for (n = 0; n < n_device_types - 1; n++) {
+        if (!ladder.reached[n] || ladder.mos[n] < 4.0 - 1e-6) { printf("ladder test has failed\n"); return 1; }
+        printf("device %d -> rung %d, predicted MOS=%g\n", n, ladder.rung[n], ladder.mos[n]);
+    }
+    printf("  => total bitrate = %g\n\n", ladder.total_bitrate);
+
+    /*
+     * Test BD-MOS (tested codec reaches the same metric scores at 20% lower bitrates -> BD-rate = -20% on all devices):
+     */
+    printf("Testing BD-MOS:\n");
+    for (n = 0; n < 30; n++) {
+        struct rd_point p = {ladder_bitrates[n / 6][n % 6], ladder_widths[n / 6], ladder_heights[n / 6], ladder_vmafs[n / 6][n % 6]};
+        anchor_points[n] = p;
+        p.bitrate *= 0.8;
+        test_points[n] = p;
+    }
+    anchor.n_points = test.n_points = 30;
+    anchor.points = anchor_points;
+    test.points = test_points;
+    for (n = 0; n < n_device_types - 1; n++) {
+        struct viewing_setup vs = {n, NULL, targets[n].player_width, targets[n].player_height, 0, upsampling_bicubic};
+        setups[n] = vs;
+    }
+    if (bd_compare(setups, n_device_types - 1, metric_vmaf, &anchor, &test, 1, NULL, bd)) { printf("BD-MOS test has failed\n"); return 1; }
+    for (n = 0; n < n_device_types - 1; n++) {
+        if (bd[n].status || fabs(bd[n].bd_rate + 0.2) > 1e-9) { printf("BD-MOS test has failed\n"); return 1; }
+        printf("device %d -> BD-rate=%g%%, BD-MOS=%g\n", n, bd[n].bd_rate * 100, bd[n].bd_mos);
+    }
+    printf("\n");
+
+    /*
+     * Test dynamic optimizer (4 shots of different durations and complexity, TV, target average bitrate = 4 Mbps):
+     */
+    printf("Testing dynamic optimizer:\n");
+    for (n = 0; n < 4; n++) {
+        for (k = 0; k < 30; k++) {
+            struct shot_point p = {k / 6, k % 6, ladder_bitrates[k / 6][k % 6] * 1000 * (n + 1) * (0.5 + n % 2), ladder_vmafs[k / 6][k % 6]};
+            shot_points[n][k] = p;
+        }
+        shots[n].duration = 1 + n;
+        shots[n].n_points = 30;
+        shots[n].points = shot_points[n];
+    }
+    if (dynopt_init(&dyn, metric_vmaf, &setups[device_tv], ladder_widths, ladder_heights, 5, 0)
+        || dynopt_optimize(&dyn, shots, 4, dynopt_target_bitrate, 4e6, choices, &dres)
+        || !dres.reached || dres.bitrate > 4e6) { printf("dynamic optimizer test has failed\n"); return 1; }
+    for (n = 0; n < 4; n++)
+        printf("shot %d -> %dx%d, bits=%g\n", n, ladder_widths[shot_points[n][choices[n]].resolution], ladder_heights[shot_points[n][choices[n]].resolution], shot_points[n][choices[n]].bits);
+    printf("  => average bitrate = %g, MOS = %g\n\n", dres.bitrate, dres.mos);
+
+    /*
+     * Test ABR decisions (mobile device, full-screen and small-window players):
+     */
+    printf("Testing ABR engine:\n");
+    if (abr_init(&abr, &setups[device_mobile], abr_ladder, sizeof(abr_ladder) / sizeof(abr_ladder[0]))) { printf("ABR test has failed\n"); return 1; }
+    for (k = 0; k < 2; k++) {
+        if (k && (abr_resize(&abr, 0, 360) != -2 || abr.setup.player_width == 0 || abr_resize(&abr, 640, 360))) { printf("ABR test has failed\n"); return 1; }
+        for (n = 0; n < 6; n++) {
+            int i = abr_select(&abr, bandwidths[n]);
+            if (i < 0 || (n && abr.renditions[i].bitrate > bandwidths[n])) { printf("ABR test has failed\n"); return 1; }
+            printf("player %dx%d, bandwidth=%g -> %dx%d, bitrate=%g, predicted MOS=%g\n", abr.setup.player_width, abr.setup.player_height, bandwidths[n], abr.renditions[i].width, abr.renditions[i].height, abr.renditions[i].bitrate, abr.mos[i]);
+        }
+    }
+    printf("\n");
+
+    /*
+     * Test ABR simulator (10 minutes of content, TV, 3 traces):
+     */
+    printf("Testing ABR simulator:\n");
+    for (n = 0; n < 3; n++) {
+        traces[n].n = 4;
+        traces[n].time = trace_times;
+        traces[n].bandwidth = trace_bandwidths[n];
+    }
+    if (sim_init(&sim, &setups[device_tv], &content, &sim_params) || sim_run(&sim, traces, 3, sessions)) { printf("ABR simulator test has failed\n"); return 1; }
+    for (n = 0; n < 3; n++) {
+        if (sessions[n].status) { printf("ABR simulator test has failed\n"); return 1; }
+        printf("trace %d -> MOS=%g, startup delay=%g, stall time=%g, switches=%d, bitrate=%g\n", n, sessions[n].mos, sessions[n].startup_delay, sessions[n].stall_time, sessions[n].switches, sessions[n].bitrate);
+    }
+    traces[0].bandwidth = zero_bandwidths;    /* no throughput: rejected, rather than downloading forever */
+    if (sim_run(&sim, traces, 1, sessions) || sessions[0].status != -13) { printf("ABR simulator test has failed\n"); return 1; }
+    sim_free(&sim);
+    printf("\n");
+
+    /*
+     * Test resolution saturation finder (full-screen players, WR gain < 0.05):
+     */
+    printf("Testing saturation widths:\n");
+    k = saturation_table(NULL, 0, NULL, 0, 0.05, saturation, sizeof(saturation) / sizeof(saturation[0]));
+    if (k != sizeof(saturation) / sizeof(saturation[0])) { printf("saturation test has failed\n"); return 1; }
+    for (n = 0; n < k; n++) {
+        if (saturation[n].status || saturation[n].width > saturation[n].player_width) { printf("saturation test has failed\n"); return 1; }
+        printf("device %d, player %dx%d, hdr=%d, upsampling=%d -> %dx%d\n", saturation[n].device, saturation[n].player_width, saturation[n].player_height, saturation[n].hdr, saturation[n].upsampling, saturation[n].width, saturation[n].height);
+    }
+    printf("\n");
+
+    /*
+     * Test MOS grid:
+     */
+    printf("Testing MOS grid (TV, PSNR x encoding width):\n");
+    if (grid_size(&axes) != sizeof(grid) / sizeof(grid[0]) || mos_grid(metric_psnr, 0, upsampling_bicubic, device_tv, NULL, &axes, grid)) { printf("grid test has failed\n"); return 1; }
+    for (p = 0, k = 0; p < 2; p++) {
+        for (e = 0; e < 4; e++) {
+            /* grid must match point-by-point predictions: */
+            if (viewing_context_init(&ctx, grid_widths[e], grid_widths[e] * 9 / 16, grid_player_widths[p], grid_player_widths[p] * 9 / 16, 0, upsampling_bicubic, device_tv, NULL)) { printf("grid test has failed\n"); return 1; }
+            for (n = 0; n < 5; n++, k++)
+                if (metric2mos(&ctx, metric_psnr, grid_psnrs[n]) != grid[k]) { printf("grid test has failed\n"); return 1; }
+        }
+    }
+    for (n = 0; n < 5; n++) {
+        printf("PSNR=%g:", grid_psnrs[n]);
+        for (e = 0; e < 4; e++)
+            printf(" w%d=%.3f", grid_widths[e], grid[(4 + e) * 5 + n]);
+        printf("\n");
+    }
+    printf("\n");
+
+    /*
+     * Test standard errors of MOS (assuming independent parameters with 1% relative errors):
+     */
+    printf("Testing standard errors of PSNR2MOS:\n");
+    wr = wr_model_params(0, upsampling_bicubic);
+    fp = fusion_model_params(metric_psnr);
+    for (n = 0; n < n_wr_params; n++)
+        cov.c[n][n] = pow(0.01 * (&wr->alpha)[n], 2);
+    for (n = 0; n < n_model_params - n_wr_params; n++)
+        cov.c[n_wr_params + n][n_wr_params + n] = pow(0.01 * (&fp->alpha)[n], 2);
+    for (n = 0; n < n_tests; n += 4) {
+        if (viewing_context_init(&ctx, dataset[n].width, dataset[n].height, player_width, player_height, 0, upsampling_bicubic, device_tv, NULL)
+            || metric2mos_se(&ctx, metric_psnr, &cov, &dataset[n].psnr, &mos, &se, 1)
+            || mos != metric2mos(&ctx, metric_psnr, dataset[n].psnr) || se < 0) { printf("standard error test has failed\n"); return 1; }
+        printf("%s -> %dx%d, PSNR=%g, predicted MOS=%g +/- %g (95%% CI), true MOS=%g\n", dataset[n].name, dataset[n].width, dataset[n].height, dataset[n].psnr, mos, 1.96 * se, dataset[n].mos);
+
+        /* analytic gradient vs. central differences (model tables are perturbed in place), with correlated parameters, so that signs matter: */
+        for (fd_i = 0; fd_i < n_model_params; fd_i++) {
+            fd_param = fd_i < n_wr_params ? (double*)&wr->alpha + fd_i : (double*)&fp->alpha + (fd_i - n_wr_params);
+            fd_saved = *fd_param;
+            fd_h = 1e-6 * (fabs(fd_saved) > 1e-3 ? fabs(fd_saved) : 1e-3);
+            *fd_param = fd_saved + fd_h;
+            viewing_context_init(&ctx, dataset[n].width, dataset[n].height, player_width, player_height, 0, upsampling_bicubic, device_tv, NULL);
+            fd_hi = metric2mos(&ctx, metric_psnr, dataset[n].psnr);
+            *fd_param = fd_saved - fd_h;
+            viewing_context_init(&ctx, dataset[n].width, dataset[n].height, player_width, player_height, 0, upsampling_bicubic, device_tv, NULL);
+            fd_lo = metric2mos(&ctx, metric_psnr, dataset[n].psnr);
+            *fd_param = fd_saved;
+            fd_grad[fd_i] = (fd_hi - fd_lo) / (2 * fd_h);
+            for (fd_j = 0; fd_j < n_model_params; fd_j++)
+                fd_cov.c[fd_i][fd_j] = (fd_i == fd_j ? 1 : 0.5) * sqrt(cov.c[fd_i][fd_i] * cov.c[fd_j][fd_j]);
+        }
+        for (fd_se = 0, fd_i = 0; fd_i < n_model_params; fd_i++)
+            for (fd_j = 0; fd_j < n_model_params; fd_j++)
+                fd_se += fd_grad[fd_i] * fd_cov.c[fd_i][fd_j] * fd_grad[fd_j];
+        fd_se = sqrt(fd_se);
+        if (viewing_context_init(&ctx, dataset[n].width, dataset[n].height, player_width, player_height, 0, upsampling_bicubic, device_tv, NULL)
+            || metric2mos_se(&ctx, metric_psnr, &fd_cov, &dataset[n].psnr, &mos, &se, 1) || fabs(se - fd_se) > 1e-6 * fd_se + 1e-9) {
+            printf("standard error test has failed (se=%.9g, finite differences: %.9g)\n", se, fd_se);
+            return 1;
+        }
+    }
+    printf("\n");
+
+    /*
+     * Test ensemble of PSNR and SSIM models:
+     */
+    printf("Testing PSNR+SSIM ensemble:\n");
+    for (n = 0; n < n_tests; n++) {
+        ens_values[metric_psnr] = dataset[n].psnr;
+        ens_values[metric_ssim] = dataset[n].ssim;
+        ens_true[n] = dataset[n].mos;
+        if (viewing_context_init(&ctx, dataset[n].width, dataset[n].height, player_width, player_height, 0, upsampling_bicubic, device_tv, NULL)
+            || ensemble_mos(&ctx, METRIC_MASK(metric_psnr) | METRIC_MASK(metric_ssim), ens_values, NULL, ens_mos[n], &combined)) { printf("ensemble test has failed\n"); return 1; }
+    }
+    if (ensemble_fit(METRIC_MASK(metric_psnr) | METRIC_MASK(metric_ssim), &ens_mos[0][0], ens_true, n_tests, &weights, &ens_rms)) { printf("ensemble test has failed\n"); return 1; }
+    for (n = 0, rms = 0; n < n_tests; n++) {
+        /* combined prediction with fitted weights: */
+        ens_values[metric_psnr] = dataset[n].psnr;
+        ens_values[metric_ssim] = dataset[n].ssim;
+        if (viewing_context_init(&ctx, dataset[n].width, dataset[n].height, player_width, player_height, 0, upsampling_bicubic, device_tv, NULL)
+            || ensemble_mos(&ctx, METRIC_MASK(metric_psnr) | METRIC_MASK(metric_ssim), ens_values, &weights, NULL, &combined)) { printf("ensemble test has failed\n"); return 1; }
+        rms += (combined - dataset[n].mos) * (combined - dataset[n].mos);
+    }
+    rms = sqrt(rms / n_tests);
+    if (fabs(rms - ens_rms) > 1e-9) { printf("ensemble test has failed\n"); return 1; }
+    ens_true[0] = NAN;    /* no feasible weights: error, and fitted weights are kept */
+    if (ensemble_fit(METRIC_MASK(metric_psnr), &ens_mos[0][0], ens_true, n_tests, &weights, &ens_rms) != -9 || weights.w[metric_ssim] == 0) { printf("ensemble test has failed\n"); return 1; }
+    printf("weights: PSNR=%g, SSIM=%g -> RMS=%g\n\n", weights.w[metric_psnr], weights.w[metric_ssim], rms);
+
+    /*
+     * Test batch scoring (columns of dataset records are used in place):
+     */
+    printf("Testing batch scoring:\n");
+    batch.n = n_tests;
+    batch.values = &dataset[0].psnr;
+    batch.values_stride = sizeof(dataset[0]) / sizeof(double);
+    batch.width.data = &dataset[0].width;
+    batch.height.data = &dataset[0].height;
+    batch.width.stride = batch.height.stride = sizeof(dataset[0]) / sizeof(int);
+    batch.player_width.data = &player_width;
+    batch.player_height.data = &player_height;
+    batch.hdr.data = batch.upsampling.data = &batch_zero;
+    batch.device.data = &batch_device;
+    batch.player_width.stride = batch.player_height.stride = batch.hdr.stride = batch.upsampling.stride = batch.device.stride = 0;
+    batch.params = NULL;
+    batch.store = NULL;
+    if (score_batch(metric_psnr, &batch, batch_mos, 4)) { printf("batch test has failed\n"); return 1; }
+    for (n = 0; n < n_tests; n++)
+        if (batch_mos[n] != psnr2mos(dataset[n].psnr, dataset[n].width, dataset[n].height, player_width, player_height, 0, upsampling_bicubic, device_tv, NULL)) { printf("batch test has failed\n"); return 1; }
+    printf("%d rows scored, all match psnr2mos()\n\n", n_tests);
+
+    /*
+     * Test piecewise-linear surrogate of PSNR2MOS (TV, 1080p in full-screen 4K player):
+     */
+    printf("Testing PSNR2MOS surrogate:\n");
+    if (viewing_context_init(&ctx, 1920, 1080, player_width, player_height, 0, upsampling_bicubic, device_tv, NULL)
+        || surrogate_fit(&ctx, metric_psnr, 0.01, &sur) || sur.max_error > 0.01) { printf("surrogate test has failed\n"); return 1; }
+    for (n = 0; n < n_tests; n++)
+        if (dataset[n].width == 1920 && fabs(surrogate_eval(&sur, dataset[n].psnr) - metric2mos(&ctx, metric_psnr, dataset[n].psnr)) > 0.01) { printf("surrogate test has failed\n"); return 1; }
+    printf("%d segments, max error = %g\n\n", sur.n - 1, sur.max_error);
+
+    /*
+     * Test parsers of metric logs (libvmaf JSON and XML, FFmpeg psnr stats):
+     */
+    printf("Testing metric log parsers:\n");
+    for (n = 0; n < 3; n++) {
+        if (parse_metric_log(logs[n], metric_psnr, &summary) || summary.n_frames != 2 || summary.mean != 37.5 || summary.min != 36.5) { printf("log parser test has failed\n"); return 1; }
+        printf("format %d: %d frames, mean PSNR = %g, min PSNR = %g\n", summary.format, summary.n_frames, summary.mean, summary.min);
+        if (parse_metric_log(logs[n], metric_vmaf, &summary) != (n < 2 ? 0 : -3) || (n < 2 && summary.mean != 85.0)) { printf("log parser test has failed\n"); return 1; }
+        if (parse_metric_log(logs[n], metric_vif, &summary) != (n < 2 ? 0 : -3) || (n < 2 && (summary.mean != 0.625 || summary.min != 0.5))) { printf("log parser test has failed\n"); return 1; }  /* mean of VIF scales */
+    }
+#ifdef PMOS_ZLIB
+    if (compression_type(gzip_log, sizeof(gzip_log)) != compression_gzip || decompress(gzip_log, sizeof(gzip_log), &unzipped)
+        || parse_metric_log(unzipped.data, metric_psnr, &summary) || summary.n_frames != 2 || summary.mean != 37.5) { printf("gzip log test has failed\n"); return 1; }
+    printf("gzip: %d -> %d bytes, %d frames, mean PSNR = %g\n", (int)sizeof(gzip_log), (int)unzipped.size, summary.n_frames, summary.mean);
+    /* size limit (decompression bombs): exact fit is accepted, one byte less fails without growing the buffer past the limit: */
+    unzipped.max_size = unzipped.size;
+    if (decompress(gzip_log, sizeof(gzip_log), &unzipped)) { printf("gzip log test has failed\n"); return 1; }
+    free(unzipped.data);
+    unzipped.data = NULL;
+    unzipped.capacity = 0;
+    unzipped.max_size--;
+    if (decompress(gzip_log, sizeof(gzip_log), &unzipped) != -4 || unzipped.capacity > unzipped.max_size + 2) { printf("gzip log test has failed\n"); return 1; }
+    free(unzipped.data);
+#endif
+    printf("\n");
+
+    /*
+     * Test checkpoint and restore of stream states (full snapshot, then 2 incremental ones with a torn tail):
+     */
+    printf("Testing checkpoint and restore of streams:\n");
+    remove("pmos_test.snapshot");
+    remove("pmos_test.snapshot.delta");
+    if (stream_table_init(&streams, 64, 10, NULL)) { printf("stream test has failed\n"); return 1; }
+    for (n = 0; n < n_tests; n++) {
+        key.width = dataset[n].width;
+        key.height = dataset[n].height;
+        if (stream_score(&streams, 1 + n % 5, &key, 2, metric_psnr, dataset[n].psnr, NULL)
+            || (n == n_tests / 2 && stream_checkpoint(&streams, "pmos_test.snapshot", 0))) { printf("stream test has failed\n"); return 1; }
+    }
+    if (stream_checkpoint(&streams, "pmos_test.snapshot", 1) || stream_remove(&streams, 3) || stream_checkpoint(&streams, "pmos_test.snapshot", 1)
+        || (f = fopen("pmos_test.snapshot.delta", "ab")) == NULL || fwrite("torn", 1, 4, f) != 4 || fclose(f)
+        || stream_restore(&restored, "pmos_test.snapshot", NULL) || restored.n != streams.n || stream_find(&restored, 3) != NULL) { printf("stream test has failed\n"); return 1; }
+    for (n = 1; n <= 5; n++) {
+        if (n == 3) continue;
+        st = stream_find(&streams, n);
+        st2 = stream_find(&restored, n);
+        if (st == NULL || st2 == NULL || st->n != st2->n || st->mos_sum != st2->mos_sum || st->rolling != st2->rolling || st->switches != st2->switches) { printf("stream test has failed\n"); return 1; }
+        printf("stream %d: %d segments, session MOS=%g, rolling MOS=%g, min MOS=%g, %d switches\n", n, (int)st2->n, st2->mos_sum / st2->duration, st2->rolling, st2->mos_min, st2->switches);
+    }
+    for (n = 0, k = 0; n < GEOMETRY_CACHE_SIZE; n++) k += restored.cache.entries[n].valid;
+    stream_table_free(&restored);
+    set_reproducible_mode(1);    /* contexts cached in default mode are not reused in reproducible mode: */
+    if (k == 0 || stream_restore(&restored, "pmos_test.snapshot", NULL)) { printf("stream test has failed\n"); return 1; }
+    for (n = 0, k = 0; n < GEOMETRY_CACHE_SIZE; n++) k += restored.cache.entries[n].valid;
+    set_reproducible_mode(0);
+    if (k != 0) { printf("stream test has failed\n"); return 1; }
+    stream_table_free(&restored);
+#ifndef _WIN32
+    /* failed rewrite of the snapshot (its temporary file cannot be created) releases the table: */
+    if ((f = fopen("pmos_test.snapshot.delta", "ab")) == NULL || fwrite("torn", 1, 4, f) != 4 || fclose(f) || mkdir("pmos_test.snapshot.tmp", 0700)) { printf("stream test has failed\n"); return 1; }
+    k = stream_restore(&restored, "pmos_test.snapshot", NULL);
+    rmdir("pmos_test.snapshot.tmp");
+    if (k != -14 || restored.streams != NULL || restored.dirty != NULL || restored.mapping != NULL) { printf("stream test has failed\n"); return 1; }
+#endif
+    /* truncated snapshot is invalid (not an I/O error): */
+    if ((f = fopen("pmos_test.snapshot", "wb")) == NULL || fwrite("torn", 1, 4, f) != 4 || fclose(f)
+        || stream_restore(&restored, "pmos_test.snapshot", NULL) != -18) { printf("stream test has failed\n"); return 1; }
+    stream_table_free(&streams);
+    remove("pmos_test.snapshot");
+    remove("pmos_test.snapshot.delta");
+    printf("\n");
+
+    /*
+     * Test reproducible mode (elementary functions vs. C library, scalar vs. batch and threaded scoring):
+     */
+    printf("Testing reproducible mode:\n");
+    for (n = 0, delta = 0; n < 1000; n++) {
+        mos = (n - 500) / 25.;
+        delta = fmax(delta, fabs(repro_exp(mos) - exp(mos)) / exp(mos));
+        delta = fmax(delta, fabs(repro_log(n + 0.5) - log(n + 0.5)) / fmax(fabs(log(n + 0.5)), 1));
+        delta = fmax(delta, fabs(repro_pow(n / 100. + 0.01, mos / 10) - pow(n / 100. + 0.01, mos / 10)) / pow(n / 100. + 0.01, mos / 10));
+        delta = fmax(delta, fabs(repro_atan(mos) - atan(mos)) / fmax(fabs(atan(mos)), 1e-300));
+    }
+    if (delta > 1e-14) { printf("reproducible mode test has failed\n"); return 1; }
+    set_reproducible_mode(1);
+    for (n = 0; n < n_tests; n++)
+        repro_mos[4][n] = psnr2mos(dataset[n].psnr, dataset[n].width, dataset[n].height, player_width, player_height, 0, upsampling_bicubic, device_tv, NULL);
+    for (k = 0; k < 4; k++)
+        if (score_batch(metric_psnr, &batch, repro_mos[k], repro_threads[k]) || memcmp(repro_mos[k], repro_mos[4], sizeof(repro_mos[4]))) { printf("reproducible mode test has failed\n"); return 1; }
+    for (n = 0, hash = 0xcbf29ce484222325ULL, bytes = (const unsigned char*)repro_mos[4]; n < (int)sizeof(repro_mos[4]); n++)
+        hash = (hash ^ bytes[n]) * 0x100000001b3ULL;
+    if (stream_table_init(&streams, 64, 10, NULL)) { printf("reproducible mode test has failed\n"); return 1; }
+    for (n = 0, k = 0, combined = 0; n < n_tests && !k; n++) {
+        if (stream_add(&streams, 1, NULL, 2 + n % 3, repro_mos[4][n], &st)) { printf("reproducible mode test has failed\n"); return 1; }
+        se = repro_exp(-repro_log(2.0) * (2 + n % 3) / 10);
+        combined = se * (n ? combined : repro_mos[4][n]) + (1 - se) * repro_mos[4][n];
+        k = memcmp(&st->rolling, &combined, sizeof(combined));
+    }
+    stream_table_free(&streams);
+    set_reproducible_mode(0);
+    if (k) { printf("reproducible mode test has failed (rolling MOS)\n"); return 1; }
+    if (hash != 0xd87df73dd3e2e0cdULL) { printf("reproducible mode test has failed (scores differ from reference)\n"); return 1; }
+    printf("max relative error of elementary functions = %g, hash of %d scores = %016llx\n\n", delta, n_tests, hash);
+
+    /*
+     * Test all fast paths against long double reference (differential test):
+     */
+    printf("Testing fast paths against reference:\n");
+    if (diff_test(&domain, 0, &report)) { printf("differential test has failed\n"); return 1; }
+    for (k = 0; k < n_diff_paths; k++) {
+        printf("%-12s %8lld points, %lld mismatches, max error = %.3g, mean error = %.3g", diff_path_name(k), report.paths[k].n, report.paths[k].mismatches, report.paths[k].max_error, report.paths[k].mean_error);
+        if (report.paths[k].worst.metric >= 0) printf(" (metric %d = %g, phi = %g, u = %g)", report.paths[k].worst.metric, report.paths[k].worst.value, report.paths[k].worst.phi, report.paths[k].worst.u);
+        printf("\n");
+        if (report.paths[k].mismatches || report.paths[k].max_error > (k == diff_surrogate ? domain.surrogate_tolerance : 1e-12)) { printf("differential test has failed\n"); return 1; }
+    }
+    printf("%.2f s\n\n", report.seconds);
+
+    /*
+     * Test persistent cache of viewing contexts (cold start, warm start, and recovery from a torn record):
+     */
+    printf("Testing persistent geometry cache:\n");
+    remove("pmos_test.geometry");
+    for (k = 0; k < 3; k++) {
+        if (geometry_store_open(&store, "pmos_test.geometry")) { printf("geometry cache test has failed\n"); return 1; }
+        geometry_cache_init(&gcache, NULL);
+        geometry_cache_attach(&gcache, &store);
+        for (n = 0; n < n_tests; n++) {
+            key.width = dataset[n].width;
+            key.height = dataset[n].height;
+            if (geometry_cache_lookup(&gcache, &key, &pctx) || viewing_context_init(&ctx, key.width, key.height, key.player_width, key.player_height, key.hdr, key.upsampling, key.device, NULL)
+                || memcmp(pctx, &ctx, sizeof(ctx))) { printf("geometry cache test has failed\n"); return 1; }
+        }
+        batch.store = &store;
+        if (score_batch(metric_psnr, &batch, store_mos, 4) || memcmp(store_mos, batch_mos, sizeof(store_mos))) { printf("geometry cache test has failed\n"); return 1; }
+        batch.store = NULL;
+        printf("start %d: %d records loaded, %lld hits, %lld misses\n", k + 1, store.n_mapped, store.hits, store.misses);
+        if (k > 0 && (store.misses != 0 || store.n_mapped == 0)) { printf("geometry cache test has failed\n"); return 1; }
+        geometry_store_close(&store);
+        if (k == 1 && ((f = fopen("pmos_test.geometry", "ab")) == NULL || fwrite("torn", 1, 4, f) != 4 || fclose(f))) { printf("geometry cache test has failed\n"); return 1; }
+    }
+#ifndef _WIN32
+    /* a record added after another opener has replaced (compacted) the file goes to the new file: */
+    if (geometry_store_open(&store, "pmos_test.geometry") || (f = fopen("pmos_test.geometry", "ab")) == NULL || fwrite("torn", 1, 4, f) != 4 || fclose(f)
+        || geometry_store_open(&store2, "pmos_test.geometry")) { printf("geometry cache test has failed\n"); return 1; }
+    key.width = 704;
+    key.height = 396;
+    geometry_store_lookup(&store, &key, &gentry);
+    k = (int)store.misses;
+    geometry_store_close(&store);
+    geometry_store_close(&store2);
+    if (k != 1 || geometry_store_open(&store, "pmos_test.geometry")) { printf("geometry cache test has failed\n"); return 1; }
+    geometry_store_lookup(&store, &key, &gentry);
+    k = (int)store.misses;
+    geometry_store_close(&store);
+    if (k != 0) { printf("geometry cache test has failed (record appended to replaced file)\n"); return 1; }
+#endif
+    remove("pmos_test.geometry");
+    remove("pmos_test.geometry.lock");
+    printf("\n");
+
+    /*
+     * Test asynchronous scoring (per-row geometry, and a context job spanning several chunks):
+     */
+    printf("Testing asynchronous scoring:\n");
+    viewing_context_init(&ctx, 1920, 1080, player_width, player_height, 0, upsampling_bicubic, device_tv, NULL);
+    for (n = 0; n < 3 * ASYNC_CHUNK_ROWS; n++)
+        async_values[n] = 20 + 30. * n / (3 * ASYNC_CHUNK_ROWS);
+    if (async_queue_init(&queue, 2, 2)) { printf("async test has failed\n"); return 1; }
+#ifndef _WIN32
+    if (async_fd(&queue) < 0) { printf("async test has failed\n"); return 1; }
+#endif
+    memset(&job, 0, sizeof(job));
+    job.user_data = 1;
+    job.metric = metric_psnr;
+    job.batch = batch;
+    job.mos = store_mos;
+    if (async_submit(&queue, &job)) { printf("async test has failed\n"); return 1; }
+    job.user_data = 2;
+    job.batch.values = async_values;
+    job.batch.values_stride = 1;
+    job.batch.n = 3 * ASYNC_CHUNK_ROWS;
+    job.ctx = &ctx;
+    job.mos = async_mos[0];
+    if (async_submit(&queue, &job)) { printf("async test has failed\n"); return 1; }
+    if (async_submit(&queue, &job) != -11) { printf("async test has failed\n"); return 1; }  /* rings are full until reaped */
+    for (k = 0; k < 2; k += n_done) {
+        if ((n_done = async_wait(&queue, done, 4)) <= 0) { printf("async test has failed\n"); return 1; }
+        for (n = 0; n < n_done; n++)
+            if (done[n].status || done[n].user_data < 1 || done[n].user_data > 2) { printf("async test has failed\n"); return 1; }
+    }
+    if (async_wait(&queue, done, 4) != 0) { printf("async test has failed\n"); return 1; }
+    async_queue_free(&queue);
+    if (memcmp(store_mos, batch_mos, sizeof(store_mos)) || metric2mos_batch(&ctx, metric_psnr, async_values, async_mos[1], 3 * ASYNC_CHUNK_ROWS)
+        || memcmp(async_mos[0], async_mos[1], sizeof(async_mos[0]))) { printf("async test has failed\n"); return 1; }
+    printf("%d jobs, %d rows scored\n\n", 2, n_tests + 3 * ASYNC_CHUNK_ROWS);
+
     return 0;
 }
 
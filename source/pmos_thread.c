@@ -0,0 +1,331 @@
+/*!
+ *  \file  pmos_thread.c
+ *  \brief Minimal portable parallel-for, locks and background threads over POSIX threads or Win32 threads.
+ *
+ *  Items are split into contiguous blocks of (nearly) equal sizes, one per thread, so the
+ *  assignment of items to threads depends only on the number of items and threads.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stddef.h>
+#include <stdlib.h>
+#include "pmos_thread.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+/*! Work item of a thread: */
+struct parallel_block {
+	parallel_body body;
+	void* arg;
+	int begin, end;
+};
+
+#ifdef _WIN32
+static DWORD WINAPI parallel_thread(LPVOID p)
+#else
+static void* parallel_thread(void* p)
+#endif
+{
+	struct parallel_block* b = (struct parallel_block*)p;
+	b->body(b->arg, b->begin, b->end);
+	return 0;
+}
+
+/*!
+ *  \brief Returns the number of online CPU cores.
+ */
+int cpu_count(void)
+{
+#ifdef _WIN32
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	return (int)si.dwNumberOfProcessors;
+#else
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n < 1 ? 1 : (int)n;
+#endif
+}
+
+/*!
+ *  \brief Returns monotonic wall-clock time [seconds].
+ */
+double wall_clock(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER t, f;
+	QueryPerformanceCounter(&t);
+	QueryPerformanceFrequency(&f);
+	return (double)t.QuadPart / (double)f.QuadPart;
+#else
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+#endif
+}
+
+/*!
+ *  \brief Runs body over items [0, n) split into contiguous blocks processed by parallel threads.
+ *
+ *  \param[in] n          number of items
+ *  \param[in] n_threads  number of threads (0 - use all cores, 1 - run in the calling thread)
+ *  \param[in] body       loop body
+ *  \param[in] arg        argument passed to the body
+ *
+ *  \return 0 - success, -1 - invalid parameters
+ *
+ *  Blocks of threads that could not be started are processed by the calling thread.
+ */
+int parallel_for(int n, int n_threads, parallel_body body, void* arg)
+{
+	struct parallel_block blocks[PMOS_MAX_THREADS];
+#ifdef _WIN32
+	HANDLE threads[PMOS_MAX_THREADS];
+#else
+	pthread_t threads[PMOS_MAX_THREADS];
+#endif
+	int i, started;
+
+	/* check parameters */
+	if (body == NULL || n < 0 || n_threads < 0) return -1;
+	if (n_threads == 0) n_threads = cpu_count();
+	if (n_threads > PMOS_MAX_THREADS) n_threads = PMOS_MAX_THREADS;
+	if (n_threads > n) n_threads = n;
+
+	/* single thread - run in place: */
+	if (n_threads <= 1) {
+		if (n > 0) body(arg, 0, n);
+		return 0;
+	}
+
+	/* split items into contiguous blocks: */
+	for (i = 0; i < n_threads; i++) {
+		blocks[i].body = body;
+		blocks[i].arg = arg;
+		blocks[i].begin = (int)((long long)n * i / n_threads);
+		blocks[i].end = (int)((long long)n * (i + 1) / n_threads);
+	}
+
+	/* start threads for all blocks but the first one, which is processed by the calling thread: */
+	for (started = 1; started < n_threads; started++) {
+#ifdef _WIN32
+		threads[started] = CreateThread(NULL, 0, parallel_thread, &blocks[started], 0, NULL);
+		if (threads[started] == NULL) break;
+#else
+		if (pthread_create(&threads[started], NULL, parallel_thread, &blocks[started])) break;
+#endif
+	}
+	body(arg, blocks[0].begin, blocks[0].end);
+
+	/* process blocks of threads that failed to start, and wait for all others: */
+	for (i = started; i < n_threads; i++)
+		body(arg, blocks[i].begin, blocks[i].end);
+	for (i = 1; i < started; i++) {
+#ifdef _WIN32
+		WaitForSingleObject(threads[i], INFINITE);
+		CloseHandle(threads[i]);
+#else
+		pthread_join(threads[i], NULL);
+#endif
+	}
+
+	return 0;
+}
+
+/*!
+ *  \brief Initializes a lock.
+ *
+ *  \return 0 - success, -1 - out of memory or system resources
+ */
+int parallel_lock_init(struct parallel_lock* lock)
+{
+#ifdef _WIN32
+	CRITICAL_SECTION* cs = (CRITICAL_SECTION*)malloc(sizeof(CRITICAL_SECTION));
+	if (cs != NULL) InitializeCriticalSection(cs);
+	lock->handle = cs;
+#else
+	pthread_mutex_t* m = (pthread_mutex_t*)malloc(sizeof(pthread_mutex_t));
+	if (m != NULL && pthread_mutex_init(m, NULL)) { free(m); m = NULL; }
+	lock->handle = m;
+#endif
+	return lock->handle != NULL ? 0 : -1;
+}
+
+/*!
+ *  \brief Acquires a lock, waiting for other threads to release it.
+ */
+void parallel_lock_acquire(struct parallel_lock* lock)
+{
+#ifdef _WIN32
+	EnterCriticalSection((CRITICAL_SECTION*)lock->handle);
+#else
+	pthread_mutex_lock((pthread_mutex_t*)lock->handle);
+#endif
+}
+
+/*!
+ *  \brief Releases a lock.
+ */
+void parallel_lock_release(struct parallel_lock* lock)
+{
+#ifdef _WIN32
+	LeaveCriticalSection((CRITICAL_SECTION*)lock->handle);
+#else
+	pthread_mutex_unlock((pthread_mutex_t*)lock->handle);
+#endif
+}
+
+/*!
+ *  \brief Releases resources of a lock.
+ */
+void parallel_lock_free(struct parallel_lock* lock)
+{
+	if (lock->handle == NULL) return;
+#ifdef _WIN32
+	DeleteCriticalSection((CRITICAL_SECTION*)lock->handle);
+#else
+	pthread_mutex_destroy((pthread_mutex_t*)lock->handle);
+#endif
+	free(lock->handle);
+	lock->handle = NULL;
+}
+
+/*!
+ *  \brief Initializes a signal.
+ *
+ *  \return 0 - success, -1 - out of memory or system resources
+ */
+int parallel_signal_init(struct parallel_signal* signal)
+{
+#ifdef _WIN32
+	CONDITION_VARIABLE* cv = (CONDITION_VARIABLE*)malloc(sizeof(CONDITION_VARIABLE));
+	if (cv != NULL) InitializeConditionVariable(cv);
+	signal->handle = cv;
+#else
+	pthread_cond_t* c = (pthread_cond_t*)malloc(sizeof(pthread_cond_t));
+	if (c != NULL && pthread_cond_init(c, NULL)) { free(c); c = NULL; }
+	signal->handle = c;
+#endif
+	return signal->handle != NULL ? 0 : -1;
+}
+
+/*!
+ *  \brief Releases a (held) lock, waits for the signal, and acquires the lock again.
+ *
+ *  Waits may end spuriously, so the awaited condition should be checked in a loop.
+ */
+void parallel_signal_wait(struct parallel_signal* signal, struct parallel_lock* lock)
+{
+#ifdef _WIN32
+	SleepConditionVariableCS((CONDITION_VARIABLE*)signal->handle, (CRITICAL_SECTION*)lock->handle, INFINITE);
+#else
+	pthread_cond_wait((pthread_cond_t*)signal->handle, (pthread_mutex_t*)lock->handle);
+#endif
+}
+
+/*!
+ *  \brief Wakes all threads waiting for the signal.
+ */
+void parallel_signal_wake(struct parallel_signal* signal)
+{
+#ifdef _WIN32
+	WakeAllConditionVariable((CONDITION_VARIABLE*)signal->handle);
+#else
+	pthread_cond_broadcast((pthread_cond_t*)signal->handle);
+#endif
+}
+
+/*!
+ *  \brief Releases resources of a signal.
+ */
+void parallel_signal_free(struct parallel_signal* signal)
+{
+	if (signal->handle == NULL) return;
+#ifndef _WIN32
+	pthread_cond_destroy((pthread_cond_t*)signal->handle);
+#endif
+	free(signal->handle);
+	signal->handle = NULL;
+}
+
+/*! Start parameters of a background thread: */
+struct thread_start {
+	thread_main main;
+	void* arg;
+};
+
+#ifdef _WIN32
+static DWORD WINAPI background_thread(LPVOID p)
+#else
+static void* background_thread(void* p)
+#endif
+{
+	struct thread_start start = *(struct thread_start*)p;
+	free(p);
+	start.main(start.arg);
+	return 0;
+}
+
+/*!
+ *  \brief Starts a background thread.
+ *
+ *  \return 0 - success, -1 - thread could not be started
+ */
+int parallel_thread_start(struct parallel_thread* thread, thread_main main, void* arg)
+{
+	struct thread_start* start = (struct thread_start*)malloc(sizeof(struct thread_start));
+#ifndef _WIN32
+	pthread_t* t = (pthread_t*)malloc(sizeof(pthread_t));
+#endif
+
+	thread->handle = NULL;
+	if (start == NULL) goto failed;
+	start->main = main;
+	start->arg = arg;
+#ifdef _WIN32
+	if ((thread->handle = CreateThread(NULL, 0, background_thread, start, 0, NULL)) == NULL) goto failed;
+#else
+	if (t == NULL || pthread_create(t, NULL, background_thread, start)) goto failed;
+	thread->handle = t;
+#endif
+	return 0;
+
+failed:
+	free(start);
+#ifndef _WIN32
+	free(t);
+#endif
+	return -1;
+}
+
+/*!
+ *  \brief Waits for a background thread to finish.
+ */
+void parallel_thread_join(struct parallel_thread* thread)
+{
+	if (thread->handle == NULL) return;
+#ifdef _WIN32
+	WaitForSingleObject((HANDLE)thread->handle, INFINITE);
+	CloseHandle((HANDLE)thread->handle);
+#else
+	pthread_join(*(pthread_t*)thread->handle, NULL);
+	free(thread->handle);
+#endif
+	thread->handle = NULL;
+}
+
+/* pmos_thread.c -- end of file */
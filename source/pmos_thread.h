@@ -0,0 +1,59 @@
+/*!
+ *  \file  pmos_thread.h
+ *  \brief Minimal portable parallel-for, locks and background threads over POSIX threads or Win32 threads.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _PMOS_THREAD_H_
+#define _PMOS_THREAD_H_ 1
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PMOS_MAX_THREADS  256	/* max number of worker threads */
+
+/*! Body of a parallel loop - processes items [begin, end): */
+typedef void (*parallel_body)(void* arg, int begin, int end);
+
+/*! Main function of a background thread: */
+typedef void (*thread_main)(void* arg);
+
+/*! Background thread: */
+struct parallel_thread {
+	void* handle;			/* pthread_t or HANDLE */
+};
+
+/*! Lock (mutual exclusion of threads): */
+struct parallel_lock {
+	void* handle;			/* pthread_mutex_t or CRITICAL_SECTION */
+};
+
+/*! Signal (condition variable), used with a lock: */
+struct parallel_signal {
+	void* handle;			/* pthread_cond_t or CONDITION_VARIABLE */
+};
+
+/*! Function prototypes: */
+int cpu_count(void);
+double wall_clock(void);
+int parallel_for(int n, int n_threads, parallel_body body, void* arg);
+int parallel_lock_init(struct parallel_lock* lock);
+void parallel_lock_acquire(struct parallel_lock* lock);
+void parallel_lock_release(struct parallel_lock* lock);
+void parallel_lock_free(struct parallel_lock* lock);
+int parallel_signal_init(struct parallel_signal* signal);
+void parallel_signal_wait(struct parallel_signal* signal, struct parallel_lock* lock);
+void parallel_signal_wake(struct parallel_signal* signal);
+void parallel_signal_free(struct parallel_signal* signal);
+int parallel_thread_start(struct parallel_thread* thread, thread_main main, void* arg);
+void parallel_thread_join(struct parallel_thread* thread);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,313 @@
+/*!
+ *  \file  pmos_views.hpp
+ *  \brief C++20 range adaptors and coroutine generators for lazy scoring.
+ *
+ *  Scores of frames (or segments) are converted to MOS and pooled lazily, in chunks:
+ *
+ *      for (double mos : frames | pmos::views::psnr2mos(&ctx) | pmos::views::pool(48))
+ *          ...
+ *
+ *  Scoring views pull up to PMOS_VIEW_CHUNK values from their source at a time, and convert them
+ *  with metric2mos_batch() (scores of contiguous sources are read in place, others are gathered to a
+ *  chunk buffer), so no intermediate vectors are materialized. Sources may be any input ranges,
+ *  including generators (e.g. coroutines parsing metric logs or reading sockets as frames arrive).
+ *  Views are single-pass (input ranges); invalid scores yield error codes (<0), as metric2mos() does.
+ *
+ *  pmos::completions() bridges asynchronous scoring (see pmos_async.h) to ranges: it yields
+ *  completions of submitted jobs as they arrive, until no jobs are in flight.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#ifndef _PMOS_VIEWS_HPP_
+#define _PMOS_VIEWS_HPP_ 1
+#include <algorithm>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include "pmos.h"
+#include "pmos_async.h"
+
+#define PMOS_VIEW_CHUNK  256		/* max number of values scored at once */
+
+namespace pmos {
+
+/****************************
+ * Generators:
+ */
+
+/*! Coroutine generator (single-pass view of co_yield-ed values): */
+template <class T>
+class generator : public std::ranges::view_interface<generator<T>> {
+public:
+	struct promise_type {
+		const T* value = nullptr;	/* last yielded value */
+		std::exception_ptr error;	/* exception escaped from coroutine */
+
+		generator get_return_object() noexcept { return generator(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		std::suspend_always initial_suspend() const noexcept { return {}; }
+		std::suspend_always final_suspend() const noexcept { return {}; }
+		std::suspend_always yield_value(const T& v) noexcept { value = std::addressof(v); return {}; }
+		void return_void() const noexcept {}
+		void unhandled_exception() noexcept { error = std::current_exception(); }
+		template <class U> std::suspend_never await_transform(U&&) = delete;	/* generators are synchronous */
+	};
+
+	class iterator {
+	public:
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+
+		iterator() = default;
+		explicit iterator(std::coroutine_handle<promise_type> h) noexcept : h(h) {}
+		const T& operator*() const noexcept { return *h.promise().value; }
+		iterator& operator++() { resume(h); return *this; }
+		void operator++(int) { ++*this; }
+		friend bool operator==(const iterator& it, std::default_sentinel_t) noexcept { return !it.h || it.h.done(); }
+
+	private:
+		std::coroutine_handle<promise_type> h;
+	};
+
+	generator() = default;
+	generator(generator&& g) noexcept : h(std::exchange(g.h, nullptr)) {}
+	generator& operator=(generator&& g) noexcept { std::swap(h, g.h); return *this; }
+	~generator() { if (h) h.destroy(); }
+
+	iterator begin() { if (h && !h.done()) resume(h); return iterator(h); }
+	std::default_sentinel_t end() const noexcept { return {}; }
+
+private:
+	explicit generator(std::coroutine_handle<promise_type> h) noexcept : h(h) {}
+
+	static void resume(std::coroutine_handle<promise_type> h)
+	{
+		h.resume();
+		if (h.done() && h.promise().error) std::rethrow_exception(std::exchange(h.promise().error, nullptr));
+	}
+
+	std::coroutine_handle<promise_type> h;
+};
+
+namespace detail {
+
+/*! Sources whose scores can be read in place: */
+template <class R>
+concept contiguous_scores = std::ranges::contiguous_range<R> && std::ranges::sized_range<R>
+	&& std::same_as<std::ranges::range_value_t<R>, double>;
+
+/*!
+ * \brief Takes next chunk of up to PMOS_VIEW_CHUNK scores from a source.
+ *
+ * \returns number of scores, pointer to them (either in source, or in buffer)
+ */
+template <class R>
+int take_chunk(R& source, std::ranges::iterator_t<R>& current, double* buffer, const double** p_values)
+{
+	int n = 0;
+
+	if constexpr (contiguous_scores<R>) {
+		n = (int)std::min<std::ptrdiff_t>(PMOS_VIEW_CHUNK, std::ranges::end(source) - current);
+		*p_values = std::to_address(current);
+		current += n;
+	} else {
+		for (; n < PMOS_VIEW_CHUNK && current != std::ranges::end(source); ++current)
+			buffer[n++] = (double)*current;
+		*p_values = buffer;
+	}
+	return n;
+}
+
+/* coroutine of pmos::score() (owns its source view): */
+template <std::ranges::view V>
+generator<double> score(V source, const struct viewing_context* ctx, int metric)
+{
+	double buffer[PMOS_VIEW_CHUNK], mos[PMOS_VIEW_CHUNK];
+	const double* values;
+	auto current = std::ranges::begin(source);
+	int n, i;
+
+	while ((n = detail::take_chunk(source, current, buffer, &values)) > 0) {
+		metric2mos_batch(ctx, metric, values, mos, n);
+		for (i = 0; i < n; i++)
+			co_yield mos[i];
+	}
+}
+
+} /* namespace detail */
+
+/*!
+ * \brief Converts metric scores to MOS (lazily, in chunks) in a given viewing context.
+ *
+ * \param[in]  source			metric scores (any input range of numbers; lvalues must outlive generator)
+ * \param[in]  ctx			viewing context (see viewing_context_init()), must outlive generator
+ * \param[in]  metric			metric type (see enum metric_types)
+ *
+ * \returns    generator of MOS scores (or error codes of invalid scores)
+ */
+template <std::ranges::viewable_range R>
+generator<double> score(R&& source, const struct viewing_context* ctx, int metric)
+{
+	return detail::score(std::views::all(std::forward<R>(source)), ctx, metric);
+}
+
+/*!
+ * \brief Yields completions of asynchronous jobs (see async_submit()) as they arrive, until no jobs are in flight.
+ */
+inline generator<struct async_completion> completions(struct async_queue& q)
+{
+	struct async_completion done[16];
+	int n, i;
+
+	while ((n = async_wait(&q, done, 16)) > 0)
+		for (i = 0; i < n; i++)
+			co_yield done[i];
+}
+
+/****************************
+ * Views:
+ */
+
+/*! MOS scores of metric scores (see views::metric2mos()): */
+template <std::ranges::view V>
+class score_view : public std::ranges::view_interface<score_view<V>> {
+public:
+	class iterator {
+	public:
+		using value_type = double;
+		using difference_type = std::ptrdiff_t;
+
+		iterator() = default;
+		explicit iterator(score_view* v) noexcept : v(v) {}
+		double operator*() const noexcept { return v->mos[v->pos]; }
+		iterator& operator++() { if (++v->pos == v->n) v->next_chunk(); return *this; }
+		void operator++(int) { ++*this; }
+		friend bool operator==(const iterator& it, std::default_sentinel_t) noexcept { return it.at_end(); }
+
+	private:
+		bool at_end() const noexcept { return v->pos == v->n; }
+		score_view* v = nullptr;
+	};
+
+	score_view(V base, const struct viewing_context* ctx, int metric) : base(std::move(base)), ctx(ctx), metric(metric) {}
+
+	iterator begin() { current = std::ranges::begin(base); next_chunk(); return iterator(this); }
+	std::default_sentinel_t end() const noexcept { return {}; }
+
+private:
+	void next_chunk()
+	{
+		const double* values;
+		n = detail::take_chunk(base, current, buffer, &values);
+		pos = 0;
+		if (n > 0) metric2mos_batch(ctx, metric, values, mos, n);
+	}
+
+	V base;
+	const struct viewing_context* ctx = nullptr;
+	int metric = 0;
+	std::ranges::iterator_t<V> current{};
+	int pos = 0, n = 0;			/* position in, and size of the current chunk */
+	double buffer[PMOS_VIEW_CHUNK];		/* gathered scores (non-contiguous sources) */
+	double mos[PMOS_VIEW_CHUNK];		/* MOS scores of the current chunk */
+};
+
+/*! Means of consecutive windows of MOS scores (see views::pool()): */
+template <std::ranges::view V>
+class pool_view : public std::ranges::view_interface<pool_view<V>> {
+public:
+	class iterator {
+	public:
+		using value_type = double;
+		using difference_type = std::ptrdiff_t;
+
+		iterator() = default;
+		explicit iterator(pool_view* v) noexcept : v(v) {}
+		double operator*() const noexcept { return v->mos; }
+		iterator& operator++() { v->next_window(); return *this; }
+		void operator++(int) { ++*this; }
+		friend bool operator==(const iterator& it, std::default_sentinel_t) noexcept { return it.at_end(); }
+
+	private:
+		bool at_end() const noexcept { return v->done; }
+		pool_view* v = nullptr;
+	};
+
+	pool_view(V base, int window) : base(std::move(base)), window(window > 0 ? window : 1) {}
+
+	iterator begin() { current = std::ranges::begin(base); next_window(); return iterator(this); }
+	std::default_sentinel_t end() const noexcept { return {}; }
+
+private:
+	/* mean of valid scores of the next window (error code of its first score if none is valid): */
+	void next_window()
+	{
+		double sum = 0, first = 0, m;
+		int i, valid = 0;
+
+		for (i = 0; i < window && current != std::ranges::end(base); ++current, i++) {
+			m = (double)*current;
+			if (i == 0) first = m;
+			if (m >= 0) { sum += m; valid++; }
+		}
+		done = i == 0;
+		mos = valid ? sum / valid : first;
+	}
+
+	V base;
+	int window = 1;
+	std::ranges::iterator_t<V> current{};
+	double mos = 0;				/* pooled MOS of the current window */
+	bool done = true;
+};
+
+namespace views {
+
+/*! Range adaptor closure (applied with operator |): */
+template <class F>
+struct adaptor {
+	F make;
+};
+
+template <std::ranges::viewable_range R, class F>
+auto operator|(R&& r, const adaptor<F>& a)
+{
+	return a.make(std::views::all(std::forward<R>(r)));
+}
+
+/*!
+ * \brief Converts metric scores to MOS in a given viewing context (ctx must outlive the view).
+ */
+inline auto metric2mos(const struct viewing_context* ctx, int metric)
+{
+	auto make = [ctx, metric]<std::ranges::view V>(V base) { return score_view<V>(std::move(base), ctx, metric); };
+	return adaptor<decltype(make)>{make};
+}
+
+inline auto psnr2mos(const struct viewing_context* ctx) { return metric2mos(ctx, metric_psnr); }
+inline auto ssim2mos(const struct viewing_context* ctx) { return metric2mos(ctx, metric_ssim); }
+inline auto vif2mos(const struct viewing_context* ctx) { return metric2mos(ctx, metric_vif); }
+inline auto vmaf2mos(const struct viewing_context* ctx) { return metric2mos(ctx, metric_vmaf); }
+
+/*!
+ * \brief Pools MOS scores over consecutive windows of a given number of scores (the last one may be shorter).
+ */
+inline auto pool(int window)
+{
+	auto make = [window]<std::ranges::view V>(V base) { return pool_view<V>(std::move(base), window); };
+	return adaptor<decltype(make)>{make};
+}
+
+} /* namespace views */
+} /* namespace pmos */
+
+#endif
@@ -0,0 +1,117 @@
+/*!
+ *  \file  pmos_views_bench.cpp
+ *  \brief Benchmark of C++20 range adaptors and generators (see pmos_views.hpp) against hand-written loops.
+ *
+ *  Usage: pmos_views_bench [n_frames [window]]
+ *
+ *  PSNR scores of frames are converted to MOS on a 4K TV (1080p video), and pooled over windows of
+ *  frames, by:
+ *
+ *    loop       - hand-written loop calling metric2mos() for each frame, and pooling
+ *    batch      - metric2mos_batch() of all frames to a vector of MOS scores, and pooling loop
+ *    views      - frames | pmos::views::psnr2mos(&ctx) | pmos::views::pool(window)
+ *    views/gen  - same pipeline over a generator of frames (non-contiguous source)
+ *    generator  - pmos::score(frames, &ctx, metric_psnr) | pmos::views::pool(window)
+ *
+ *  Pooled scores of all pipelines are checked to be identical to the batch pipeline.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "pmos.h"
+#include "pmos_views.hpp"
+
+/*! PSNR of frame i: */
+static double frame_psnr(long i)
+{
+	return 20 + 30 * (double)(i % 1000) / 1000;
+}
+
+/*! Source of frames (lazily produced): */
+static pmos::generator<double> frames(long n)
+{
+	for (long i = 0; i < n; i++)
+		co_yield frame_psnr(i);
+}
+
+/*! Pipeline being benchmarked: */
+template <class F>
+static int run(const char* name, long n_frames, const std::vector<double>& reference, F pipeline)
+{
+	std::vector<double> pooled;
+	auto start = std::chrono::steady_clock::now();
+	double seconds;
+
+	pooled.reserve(reference.size());
+	pipeline(pooled);
+	seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("%-10s  %8.2f ns/frame  %8.2f Mframes/s\n", name, seconds * 1e9 / n_frames, n_frames / seconds * 1e-6);
+	if (pooled != reference) { printf("%s: pooled scores differ from batch\n", name); return 1; }
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	long n_frames = argc > 1 ? atol(argv[1]) : 1 << 22, i;
+	int window = argc > 2 ? atoi(argv[2]) : 48, err = 0;
+	struct viewing_context ctx;
+	std::vector<double> psnr(n_frames), mos(n_frames), reference;
+
+	if (n_frames < 1 || window < 1) { fprintf(stderr, "Usage: pmos_views_bench [n_frames [window]]\n"); return 1; }
+	if (viewing_context_init(&ctx, 1920, 1080, 3840, 2160, 0, upsampling_bicubic, device_tv, NULL)) return 1;
+	for (i = 0; i < n_frames; i++)
+		psnr[i] = frame_psnr(i);
+
+	/* pooling loop: */
+	auto pool = [window](const double* m, long n, std::vector<double>& pooled) {
+		for (long i = 0; i < n; i += window) {
+			double sum = 0;
+			long end = i + window < n ? i + window : n, j;
+			for (j = i; j < end; j++)
+				sum += m[j];
+			pooled.push_back(sum / (end - i));
+		}
+	};
+
+	/* reference (batch): */
+	auto start = std::chrono::steady_clock::now();
+	metric2mos_batch(&ctx, metric_psnr, psnr.data(), mos.data(), (int)n_frames);
+	pool(mos.data(), n_frames, reference);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("%ld frames, windows of %d frames\n", n_frames, window);
+	err |= run("loop", n_frames, reference, [&](std::vector<double>& pooled) {
+		for (long i = 0; i < n_frames; i += window) {
+			double sum = 0;
+			long end = i + window < n_frames ? i + window : n_frames, j;
+			for (j = i; j < end; j++)
+				sum += metric2mos(&ctx, metric_psnr, psnr[j]);
+			pooled.push_back(sum / (end - i));
+		}
+	});
+	printf("%-10s  %8.2f ns/frame  %8.2f Mframes/s\n", "batch", seconds * 1e9 / n_frames, n_frames / seconds * 1e-6);
+	err |= run("views", n_frames, reference, [&](std::vector<double>& pooled) {
+		for (double m : psnr | pmos::views::psnr2mos(&ctx) | pmos::views::pool(window))
+			pooled.push_back(m);
+	});
+	err |= run("views/gen", n_frames, reference, [&](std::vector<double>& pooled) {
+		for (double m : frames(n_frames) | pmos::views::psnr2mos(&ctx) | pmos::views::pool(window))
+			pooled.push_back(m);
+	});
+	err |= run("generator", n_frames, reference, [&](std::vector<double>& pooled) {
+		for (double m : pmos::score(psnr, &ctx, metric_psnr) | pmos::views::pool(window))
+			pooled.push_back(m);
+	});
+	return err;
+}
+
+/* pmos_views_bench.cpp -- end of file */
@@ -0,0 +1,432 @@
+/*!
+ *  \file  pmos_sqlite.c
+ *  \brief SQLite loadable extension exposing pmos models.
+ *
+ *  Scalar functions (deterministic, so SQLite may factor them out of loops):
+ *
+ *    psnr2mos(psnr, width, height, player_width, player_height [, hdr, upsampling, device])
+ *    ssim2mos(ssim, ...), vif2mos(vif, ...), vmaf2mos(vmaf, ...)
+ *
+ *  Defaults: hdr = 0, upsampling = 0 (bicubic), device = 3 (TV). Invalid arguments produce NULL:
+ *  scores must be numbers (or text of numbers), and geometry arguments integers (or integral reals)
+ *  in range of int; other text (e.g. 'n/a', '1920px') and blobs are not converted.
+ *  Viewing contexts are cached per connection and function (see pmos_cache.h).
+ *
+ *  Table-valued function pmos_score(query [, metric]) runs a query returning rows
+ *  (id, value, width, height, player_width, player_height [, hdr, upsampling, device]), and scores
+ *  them in batches (see score_batch()), producing columns id, value, width, height, player_width,
+ *  player_height, hdr, upsampling, device, mos. Metric is 'psnr' (default), 'ssim', 'vif' or 'vmaf'.
+ *  Values of the query must be stored as integers or reals (valid as above); invalid ones are
+ *  returned as NULL, and so is mos of their rows:
+ *
+ *    SELECT r.name, s.mos FROM pmos_score('SELECT id, vmaf, width, height, 1920, 1080 FROM renditions', 'vmaf') s
+ *      JOIN renditions r ON r.id = s.id;
+ *
+ *  Errors of the query (when preparing it, or while reading its rows) fail the statement using
+ *  pmos_score(), with the message of the query error.
+ *
+ *  Performance: pmos_score() is not faster than scalar functions; on plain scans it is 2-2.5x slower
+ *  (see pmos_sqlite_bench.c). Scoring is a small part of the cost either way: rows of the nested
+ *  query are produced by a separate statement, and copied out of it column by column (each
+ *  sqlite3_column_*() call locks the connection in the default, serialized threading mode), before
+ *  passing through the virtual table again, while scalar functions read their arguments in place.
+ *  Use scalar functions to score columns of queries, and pmos_score() where scores are needed as a
+ *  table (e.g. to join them with other tables).
+ *
+ *  Build: see Makefile in this directory; load with ".load ./pmos_sqlite" in sqlite3 shell.
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <sqlite3ext.h>
+#include "pmos.h"
+#include "pmos_cache.h"
+#include "pmos_batch.h"
+
+SQLITE_EXTENSION_INIT1
+
+#define SCORE_BATCH_SIZE  4096	/* number of rows scored at once by pmos_score() */
+
+/*! Metric names (in the order of enum metric_types): */
+static const char* metric_names[n_metric_types] = {"psnr", "ssim", "vif", "vmaf"};
+
+/****************************
+ *
+ * Arguments:
+ *
+ ***/
+
+/*!
+ * \brief Converts a number of given type to a geometry value (integer in range of int).
+ *
+ * \returns 0 - success, -1 - invalid value
+ */
+static int to_geometry(int type, sqlite3_int64 i, double d, int* p)
+{
+	if (type == SQLITE_FLOAT) {
+		if (!(d >= INT_MIN && d <= INT_MAX) || d != floor(d)) return -1;
+		i = (sqlite3_int64)d;
+	} else if (type != SQLITE_INTEGER || i < INT_MIN || i > INT_MAX)
+		return -1;
+	*p = (int)i;
+	return 0;
+}
+
+/*! Geometry argument of a scalar function (text of numbers is converted, other text is invalid): */
+static int value_geometry(sqlite3_value* v, int* p)
+{
+	int type = sqlite3_value_numeric_type(v);
+	return to_geometry(type, type == SQLITE_INTEGER ? sqlite3_value_int64(v) : 0, type == SQLITE_FLOAT ? sqlite3_value_double(v) : 0, p);
+}
+
+/*! Geometry column of a query row (must be stored as a number): */
+static int column_geometry(sqlite3_stmt* stmt, int column, int* p)
+{
+	int type = sqlite3_column_type(stmt, column);
+	return to_geometry(type, type == SQLITE_INTEGER ? sqlite3_column_int64(stmt, column) : 0, type == SQLITE_FLOAT ? sqlite3_column_double(stmt, column) : 0, p);
+}
+
+/****************************
+ *
+ * Scalar functions:
+ *
+ ***/
+
+/*! User data of scalar functions: */
+struct metric_func {
+	int metric;			/* metric type (see enum metric_types) */
+	struct geometry_cache cache;	/* viewing contexts */
+};
+
+/*!
+ * \brief Implementation of psnr2mos(), ssim2mos(), vif2mos() and vmaf2mos().
+ */
+static void metric2mos_func(sqlite3_context* context, int argc, sqlite3_value** argv)
+{
+	struct metric_func* f = (struct metric_func*)sqlite3_user_data(context);
+	const struct viewing_context* ctx;
+	struct geometry_key key;
+	double mos;
+	int i, type;
+
+	if (argc < 5 || argc > 8) {
+		sqlite3_result_error(context, "wrong number of arguments (expected 5 to 8)", -1);
+		return;
+	}
+
+	/* NULL arguments -> NULL result: */
+	for (i = 0; i < argc; i++)
+		if (sqlite3_value_type(argv[i]) == SQLITE_NULL) return;
+
+	/* non-numeric or out-of-range arguments -> NULL result: */
+	type = sqlite3_value_numeric_type(argv[0]);
+	if (type != SQLITE_INTEGER && type != SQLITE_FLOAT) return;
+	key.hdr = 0;
+	key.upsampling = upsampling_bicubic;
+	key.device = device_tv;
+	if (value_geometry(argv[1], &key.width) || value_geometry(argv[2], &key.height)
+		|| value_geometry(argv[3], &key.player_width) || value_geometry(argv[4], &key.player_height)
+		|| (argc > 5 && value_geometry(argv[5], &key.hdr)) || (argc > 6 && value_geometry(argv[6], &key.upsampling))
+		|| (argc > 7 && value_geometry(argv[7], &key.device))) return;
+	if (geometry_cache_lookup(&f->cache, &key, &ctx)) return;
+
+	mos = metric2mos(ctx, f->metric, sqlite3_value_double(argv[0]));
+	if (mos >= 0) sqlite3_result_double(context, mos);
+}
+
+/****************************
+ *
+ * Table-valued function pmos_score():
+ *
+ ***/
+
+/*! Columns of pmos_score(): */
+enum score_columns {
+	col_id = 0, col_value, col_width, col_height, col_player_width, col_player_height,
+	col_hdr, col_upsampling, col_device, col_mos,
+	col_query, col_metric		/* hidden (arguments) */
+};
+
+/*! Number of geometry columns (width .. device): */
+#define n_geometry_columns  (col_mos - col_width)
+
+/*! Virtual table: */
+struct score_vtab {
+	sqlite3_vtab base;
+	sqlite3* db;			/* connection running queries */
+};
+
+/*! Cursor - current batch of scored rows: */
+struct score_cursor {
+	sqlite3_vtab_cursor base;
+	sqlite3_stmt* stmt;		/* query producing rows to score */
+	int metric;			/* metric type */
+	int done;			/* 1 - query has no more rows */
+	int n, pos;			/* number of rows in the batch, current row */
+	sqlite3_int64 rowid;		/* running row number */
+	sqlite3_int64 ids[SCORE_BATCH_SIZE];
+	double values[SCORE_BATCH_SIZE];
+	char null_values[SCORE_BATCH_SIZE];	/* 1 - value is NULL or invalid */
+	unsigned char null_geometry[SCORE_BATCH_SIZE];	/* bit j - geometry column j is NULL or invalid */
+	int geometry[n_geometry_columns][SCORE_BATCH_SIZE];
+	double mos[SCORE_BATCH_SIZE];
+};
+
+static int score_connect(sqlite3* db, void* aux, int argc, const char* const* argv, sqlite3_vtab** pp_vtab, char** err)
+{
+	struct score_vtab* vtab;
+	int rc;
+
+	rc = sqlite3_declare_vtab(db, "CREATE TABLE x(id, value, width, height, player_width, player_height, hdr, upsampling, device, mos, query HIDDEN, metric HIDDEN)");
+	if (rc != SQLITE_OK) return rc;
+	vtab = (struct score_vtab*)sqlite3_malloc(sizeof(struct score_vtab));
+	if (vtab == NULL) return SQLITE_NOMEM;
+	memset(vtab, 0, sizeof(*vtab));
+	vtab->db = db;
+	*pp_vtab = &vtab->base;
+	return SQLITE_OK;
+}
+
+static int score_disconnect(sqlite3_vtab* vtab)
+{
+	sqlite3_free(vtab);
+	return SQLITE_OK;
+}
+
+/*!
+ * \brief Query plan: query argument is required, metric is optional (idxNum bit 1).
+ */
+static int score_best_index(sqlite3_vtab* vtab, sqlite3_index_info* info)
+{
+	int i, query = -1, metric = -1;
+
+	for (i = 0; i < info->nConstraint; i++) {
+		if (info->aConstraint[i].op != SQLITE_INDEX_CONSTRAINT_EQ) continue;
+		if (info->aConstraint[i].iColumn == col_query) {
+			if (!info->aConstraint[i].usable) return SQLITE_CONSTRAINT;
+			query = i;
+		} else if (info->aConstraint[i].iColumn == col_metric) {
+			if (!info->aConstraint[i].usable) return SQLITE_CONSTRAINT;
+			metric = i;
+		}
+	}
+	if (query < 0) {
+		sqlite3_free(vtab->zErrMsg);
+		vtab->zErrMsg = sqlite3_mprintf("pmos_score: query argument is required");
+		return SQLITE_ERROR;
+	}
+
+	info->aConstraintUsage[query].argvIndex = 1;
+	info->aConstraintUsage[query].omit = 1;
+	if (metric >= 0) {
+		info->aConstraintUsage[metric].argvIndex = 2;
+		info->aConstraintUsage[metric].omit = 1;
+	}
+	info->idxNum = metric >= 0;
+	info->estimatedCost = 1e6;
+	return SQLITE_OK;
+}
+
+static int score_open(sqlite3_vtab* vtab, sqlite3_vtab_cursor** pp_cursor)
+{
+	struct score_cursor* c = (struct score_cursor*)sqlite3_malloc(sizeof(struct score_cursor));
+	if (c == NULL) return SQLITE_NOMEM;
+	memset(c, 0, sizeof(*c));
+	*pp_cursor = &c->base;
+	return SQLITE_OK;
+}
+
+static int score_close(sqlite3_vtab_cursor* cursor)
+{
+	struct score_cursor* c = (struct score_cursor*)cursor;
+	sqlite3_finalize(c->stmt);
+	sqlite3_free(c);
+	return SQLITE_OK;
+}
+
+/*!
+ * \brief Sets error message of the virtual table to the last error of the query.
+ */
+static int score_error(struct score_cursor* c, int rc)
+{
+	sqlite3_vtab* vtab = c->base.pVtab;
+
+	sqlite3_free(vtab->zErrMsg);
+	vtab->zErrMsg = sqlite3_mprintf("pmos_score: %s", sqlite3_errmsg(((struct score_vtab*)vtab)->db));
+	return rc;
+}
+
+/*!
+ * \brief Reads next batch of rows from the query, and scores them.
+ */
+static int score_fill(struct score_cursor* c)
+{
+	static const int defaults[n_geometry_columns] = {0, 0, 0, 0, 0, upsampling_bicubic, device_tv};
+	struct score_batch batch;
+	int n_columns, rc, type, i, j;
+
+	c->n = c->pos = 0;
+	n_columns = sqlite3_column_count(c->stmt);
+	while (!c->done && c->n < SCORE_BATCH_SIZE) {
+		rc = sqlite3_step(c->stmt);
+		if (rc == SQLITE_DONE) { c->done = 1; break; }
+		if (rc != SQLITE_ROW) return score_error(c, rc);
+
+		i = c->n++;
+		c->ids[i] = sqlite3_column_int64(c->stmt, 0);
+		type = sqlite3_column_type(c->stmt, 1);
+		c->null_values[i] = type != SQLITE_INTEGER && type != SQLITE_FLOAT;
+		c->values[i] = c->null_values[i] ? -1 : sqlite3_column_double(c->stmt, 1);	/* NULL or not a number -> invalid score */
+		c->null_geometry[i] = 0;
+		for (j = 0; j < n_geometry_columns; j++) {
+			if (2 + j >= n_columns)
+				c->geometry[j][i] = defaults[j];
+			else if (column_geometry(c->stmt, 2 + j, &c->geometry[j][i])) {
+				c->geometry[j][i] = -1;		/* invalid geometry */
+				c->null_geometry[i] |= 1 << j;
+			}
+		}
+	}
+
+	/* score the batch: */
+	batch.n = c->n;
+	batch.values = c->values;
+	batch.values_stride = 1;
+	batch.width.data = c->geometry[col_width - col_width];
+	batch.height.data = c->geometry[col_height - col_width];
+	batch.player_width.data = c->geometry[col_player_width - col_width];
+	batch.player_height.data = c->geometry[col_player_height - col_width];
+	batch.hdr.data = c->geometry[col_hdr - col_width];
+	batch.upsampling.data = c->geometry[col_upsampling - col_width];
+	batch.device.data = c->geometry[col_device - col_width];
+	batch.width.stride = batch.height.stride = batch.player_width.stride = batch.player_height.stride = 1;
+	batch.hdr.stride = batch.upsampling.stride = batch.device.stride = 1;
+	batch.params = NULL;
+	batch.store = NULL;
+	score_batch(c->metric, &batch, c->mos, 1);
+	return SQLITE_OK;
+}
+
+static int score_filter(sqlite3_vtab_cursor* cursor, int idx_num, const char* idx_str, int argc, sqlite3_value** argv)
+{
+	struct score_cursor* c = (struct score_cursor*)cursor;
+	sqlite3_vtab* vtab = cursor->pVtab;
+	const char* query = (const char*)sqlite3_value_text(argv[0]);
+	const char* name;
+	int rc;
+
+	/* metric type: */
+	c->metric = metric_psnr;
+	if (idx_num & 1) {
+		name = (const char*)sqlite3_value_text(argv[1]);
+		for (c->metric = 0; c->metric < n_metric_types; c->metric++)
+			if (name != NULL && sqlite3_stricmp(name, metric_names[c->metric]) == 0) break;
+		if (c->metric == n_metric_types) {
+			sqlite3_free(vtab->zErrMsg);
+			vtab->zErrMsg = sqlite3_mprintf("pmos_score: unknown metric '%s'", name ? name : "");
+			return SQLITE_ERROR;
+		}
+	}
+
+	/* (re)start the query: */
+	sqlite3_finalize(c->stmt);
+	c->stmt = NULL;
+	if (query == NULL) {
+		sqlite3_free(vtab->zErrMsg);
+		vtab->zErrMsg = sqlite3_mprintf("pmos_score: query must not be NULL");
+		return SQLITE_ERROR;
+	}
+	rc = sqlite3_prepare_v2(((struct score_vtab*)vtab)->db, query, -1, &c->stmt, NULL);
+	if (rc != SQLITE_OK) return score_error(c, rc);
+	if (sqlite3_column_count(c->stmt) < 6) {
+		sqlite3_free(vtab->zErrMsg);
+		vtab->zErrMsg = sqlite3_mprintf("pmos_score: query must return (id, value, width, height, player_width, player_height [, hdr, upsampling, device])");
+		return SQLITE_ERROR;
+	}
+	c->done = 0;
+	c->rowid = 0;
+	return score_fill(c);
+}
+
+static int score_next(sqlite3_vtab_cursor* cursor)
+{
+	struct score_cursor* c = (struct score_cursor*)cursor;
+
+	c->rowid++;
+	if (++c->pos < c->n) return SQLITE_OK;
+	return score_fill(c);
+}
+
+static int score_eof(sqlite3_vtab_cursor* cursor)
+{
+	struct score_cursor* c = (struct score_cursor*)cursor;
+	return c->pos >= c->n;
+}
+
+static int score_column(sqlite3_vtab_cursor* cursor, sqlite3_context* context, int column)
+{
+	struct score_cursor* c = (struct score_cursor*)cursor;
+	int i = c->pos;
+
+	switch (column) {
+	case col_id:	sqlite3_result_int64(context, c->ids[i]); break;
+	case col_value:	if (!c->null_values[i]) sqlite3_result_double(context, c->values[i]); break;
+	case col_mos:	if (c->mos[i] >= 0 && !c->null_geometry[i]) sqlite3_result_double(context, c->mos[i]); break;
+	case col_metric:	sqlite3_result_text(context, metric_names[c->metric], -1, SQLITE_STATIC); break;
+	case col_query:	break;
+	default:	if (!(c->null_geometry[i] >> (column - col_width) & 1)) sqlite3_result_int(context, c->geometry[column - col_width][i]); break;
+	}
+	return SQLITE_OK;
+}
+
+static int score_rowid(sqlite3_vtab_cursor* cursor, sqlite3_int64* p_rowid)
+{
+	*p_rowid = ((struct score_cursor*)cursor)->rowid;
+	return SQLITE_OK;
+}
+
+static sqlite3_module score_module = {
+	0,				/* iVersion */
+	NULL,				/* xCreate - eponymous-only table */
+	score_connect, score_best_index, score_disconnect, NULL,
+	score_open, score_close, score_filter, score_next, score_eof, score_column, score_rowid
+	/* read-only table, other methods are not used */
+};
+
+/****************************
+ *
+ * Entry point:
+ *
+ ***/
+
+#ifdef _WIN32
+__declspec(dllexport)
+#endif
+int sqlite3_pmossqlite_init(sqlite3* db, char** err, const sqlite3_api_routines* api)
+{
+	static const char* names[n_metric_types] = {"psnr2mos", "ssim2mos", "vif2mos", "vmaf2mos"};
+	struct metric_func* f;
+	int metric, rc;
+
+	SQLITE_EXTENSION_INIT2(api);
+
+	for (metric = 0; metric < n_metric_types; metric++) {
+		f = (struct metric_func*)sqlite3_malloc(sizeof(struct metric_func));
+		if (f == NULL) return SQLITE_NOMEM;
+		f->metric = metric;
+		geometry_cache_init(&f->cache, NULL);
+		rc = sqlite3_create_function_v2(db, names[metric], -1, SQLITE_UTF8 | SQLITE_DETERMINISTIC | SQLITE_INNOCUOUS, f, metric2mos_func, NULL, NULL, sqlite3_free);
+		if (rc != SQLITE_OK) return rc;
+	}
+	return sqlite3_create_module(db, "pmos_score", &score_module, NULL);
+}
+
+/* pmos_sqlite.c -- end of file */
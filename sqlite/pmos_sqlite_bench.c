@@ -0,0 +1,85 @@
+/*!
+ *  \file  pmos_sqlite_bench.c
+ *  \brief Benchmark of pmos SQLite extension: scalar functions vs. pmos_score() over a large table.
+ *
+ *  Usage: pmos_sqlite_bench [number of rows, default 2000000]
+ *
+ *  \version  1.0.0
+ *  \date     Jul 3, 2025
+ *  \author   Yuriy A. Reznik, yreznik@streaminglabs.com
+ *
+ *  \copyright (c) 2025 Streaming Labs, Ltd.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sqlite3.h>
+
+/* extension entry point (linked statically): */
+int sqlite3_pmossqlite_init(sqlite3* db, char** err, const void* api);
+
+/*!
+ * \brief Runs a query returning a single number, and prints its result and run time.
+ */
+static int run(sqlite3* db, const char* title, const char* sql)
+{
+	sqlite3_stmt* stmt;
+	clock_t t;
+	double result = 0;
+
+	t = clock();
+	if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+		printf("%s: %s\n", title, sqlite3_errmsg(db));
+		return 1;
+	}
+	if (sqlite3_step(stmt) == SQLITE_ROW)
+		result = sqlite3_column_double(stmt, 0);
+	else
+		printf("%s: %s\n", title, sqlite3_errmsg(db));
+	sqlite3_finalize(stmt);
+	printf("%-32s %10.3f s  (result = %.6f)\n", title, (double)(clock() - t) / CLOCKS_PER_SEC, result);
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	static const int widths[] = {384, 640, 960, 1280, 1920, 2560, 3840}, heights[] = {216, 360, 540, 720, 1080, 1440, 2160};
+	int n = argc > 1 ? atoi(argv[1]) : 2000000, i, k;
+	sqlite3_stmt* stmt;
+	sqlite3* db;
+
+	if (n < 1) { printf("usage: pmos_sqlite_bench [number of rows]\n"); return 1; }
+	sqlite3_auto_extension((void (*)(void))sqlite3_pmossqlite_init);
+	if (sqlite3_open(":memory:", &db) != SQLITE_OK) return 1;
+
+	/* table of synthetic encodings: */
+	printf("creating table with %d rows...\n", n);
+	sqlite3_exec(db, "CREATE TABLE encodes(id INTEGER PRIMARY KEY, psnr REAL, width INTEGER, height INTEGER, device INTEGER)", NULL, NULL, NULL);
+	sqlite3_exec(db, "BEGIN", NULL, NULL, NULL);
+	sqlite3_prepare_v2(db, "INSERT INTO encodes VALUES(?, ?, ?, ?, ?)", -1, &stmt, NULL);
+	for (i = 0; i < n; i++) {
+		k = i % 7;
+		sqlite3_bind_int(stmt, 1, i);
+		sqlite3_bind_double(stmt, 2, 28.0 + (i % 1500) / 100.0);
+		sqlite3_bind_int(stmt, 3, widths[k]);
+		sqlite3_bind_int(stmt, 4, heights[k]);
+		sqlite3_bind_int(stmt, 5, i % 4);
+		sqlite3_step(stmt);
+		sqlite3_reset(stmt);
+	}
+	sqlite3_finalize(stmt);
+	sqlite3_exec(db, "COMMIT", NULL, NULL, NULL);
+
+	/* queries: */
+	if (run(db, "scan only", "SELECT sum(psnr) FROM encodes")
+		|| run(db, "psnr2mos() scalar", "SELECT sum(psnr2mos(psnr, width, height, 1920, 1080, 0, 0, device)) FROM encodes")
+		|| run(db, "pmos_score() table", "SELECT sum(mos) FROM pmos_score('SELECT id, psnr, width, height, 1920, 1080, 0, 0, device FROM encodes')")
+		|| run(db, "pmos_score() joined", "SELECT sum(s.mos * (e.device = 3)) FROM pmos_score('SELECT id, psnr, width, height, 1920, 1080, 0, 0, device FROM encodes') s JOIN encodes e ON e.id = s.id"))
+		return 1;
+
+	sqlite3_close(db);
+	return 0;
+}
+
+/* pmos_sqlite_bench.c -- end of file */